@@ -1,56 +1,102 @@
 %{
 
-#include "symbol_table.h"
-#include "ast.h"
+#include "compile_context.h"
 #include "three_addr_code.h"
+#include "log_sink.h"
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <fstream>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
 
-/* Define the type for all grammar symbols */
-#define YYSTYPE symbol_info*
+/* Span of a rule covers its first to its last symbol; empty rules sit right after the previous symbol */
+#define YYLLOC_DEFAULT(Cur, Rhs, N) \
+	do { \
+		if(N) \
+		{ \
+			(Cur).offset = YYRHSLOC(Rhs, 1).offset; \
+			(Cur).length = YYRHSLOC(Rhs, N).offset + YYRHSLOC(Rhs, N).length - (Cur).offset; \
+		} \
+		else \
+		{ \
+			(Cur).offset = YYRHSLOC(Rhs, 0).offset + YYRHSLOC(Rhs, 0).length; \
+			(Cur).length = 0; \
+		} \
+	} while(0)
 
-extern FILE *yyin;
-int yyparse(void);
-int yylex(void);
-extern YYSTYPE yylval;
+thread_local string_interner names; //every identifier spelled once, symbols refer to it by id
+thread_local arena compile_arena; //owns every AST node and semantic value, freed together after code generation
 
-symbol_table *symtbl = new symbol_table();
-ProgramNode* ast_root = new ProgramNode();
+/* Log lines by level; nothing after the macro is evaluated when its level is off */
+#define ERROR_LOG LOG_IF(ctx->outlog, LOG_ERRORS)
+#define RULE_LOG LOG_IF(ctx->outlog, LOG_RULES)
+#define FULL_LOG LOG_IF(ctx->outlog, LOG_FULL)
 
-int lines = 1;
-int errors = 0;
-ofstream outlog, outerror, outcode;
+tac_operand storage_of(symbol_info *sym) //where code generation finds a declared variable
+{
+	if(sym == NULL || sym->getslot() < 0) return tac_operand();
+	return tac_operand(sym->getscope() == 1 ? OPND_GLOBAL : OPND_VAR, sym->getslot());
+}
 
-string varlist=""; //for variable declarartion list
-vector<string>paramlist; //for parameter list fot func dec and func def
-vector<string>paramname; //for func def	
-vector<string>arglist; //to store types of function argument
+// With --stream, a unit is generated and written as soon as it is reduced, and everything the
+// parser allocated for it is released. Not when the parser already holds the next token: with
+// --cache its span is already in ctx->tokens, and clearing them would drop the first token of
+// the next function's cache key. That unit is then released along with the next one.
+// After an error no more code is generated, as the output will be replaced.
+void stream_unit(compile_context *ctx, ASTNode *unit, bool release)
+{
+	if(ctx->errors == 0 && unit)
+	{
+		if(ctx->options.opt_level >= 1) unit = unit->fold(ctx->folded);
+		ctx->streamer->stream_unit(unit, ctx->global_slots);
+	}
+	if(release)
+	{
+		compile_arena.rewind(ctx->unit_mark);
+		ctx->tokens.clear();
+	}
+}
 
-int is_func = 0; //is compound statement in function definition
+%}
 
-string ret_type, func_name, func_ret_type;
+/* The parser and the scanner keep no state of their own: both work on the compile_context of the file being compiled */
+%code requires {
+#include "token.h"
+class compile_context;
+class symbol_info;
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void* yyscan_t;
+#endif
+}
 
-void yyerror(char *s)
-{
-	outlog<<"At line "<<lines<<" "<<s<<endl<<endl;
-	outerror<<"At line "<<lines<<" "<<s<<endl<<endl;
-	errors++;
-	
-	varlist = "";
-	paramlist.clear();
-	paramname.clear();
-	arglist.clear();
-	is_func = 0;
-	ret_type = "";
-	func_name = "";
-	func_ret_type = "";
+%code {
+int yylex(YYSTYPE *yylval, YYLTYPE *yylloc, yyscan_t scanner);
+void yyerror(YYLTYPE *loc, compile_context *ctx, yyscan_t scanner, const char *s);
 }
 
-%}
+%define api.pure full
+%parse-param {compile_context *ctx} {yyscan_t scanner}
+%lex-param {yyscan_t scanner}
+
+/* Tokens are plain values (see token.h); grammar symbols are symbol_info made in the arena */
+%union {
+	token_value tok;
+	symbol_info *sym;
+}
 
 /* Declare tokens */
-%token IF ELSE FOR WHILE DO BREAK INT CHAR FLOAT DOUBLE VOID RETURN SWITCH CASE DEFAULT CONTINUE PRINTLN ADDOP MULOP INCOP DECOP RELOP ASSIGNOP LOGICOP NOT LPAREN RPAREN LCURL RCURL LTHIRD RTHIRD COMMA SEMICOLON CONST_INT CONST_FLOAT ID
+%token IF ELSE FOR WHILE DO BREAK INT CHAR FLOAT DOUBLE VOID RETURN SWITCH CASE DEFAULT CONTINUE PRINTLN INCOP DECOP ASSIGNOP NOT LPAREN RPAREN LCURL RCURL LTHIRD RTHIRD COMMA SEMICOLON
+%token <tok> ADDOP MULOP RELOP LOGICOP CONST_INT CONST_FLOAT ID
+
+%type <sym> start program unit func_definition enter_func parameter_list compound_statement enter_scope_variables
+%type <sym> var_declaration type_specifier declaration_list id_name statements statement expression_statement variable
+%type <sym> expression logic_expression rel_expression simple_expression term unary_expression factor argument_list arguments
+
+%locations
 
 %nonassoc LOWER_THAN_ELSE
 %nonassoc ELSE
@@ -59,91 +105,111 @@ void yyerror(char *s)
 
 start : program
 	{
-		outlog<<"At line no: "<<lines<<" start : program "<<endl<<endl;
-		outlog<<"Symbol Table"<<endl<<endl;
+		RULE_LOG<<"At line no: "<<ctx->lines<<" start : program "<<endl<<endl;
+		FULL_LOG<<"Symbol Table"<<endl<<endl;
 		
-		symtbl->Print_all_scope(outlog);
+		ctx->symtbl->Print_all_scope(ctx->outlog);
 		
 		$$ = $1;
 		// Root of AST is the program node
-		ast_root = (ProgramNode*)$1->get_ast_node();
+		ctx->ast_root = (ProgramNode*)$1->get_ast_node();
+		if(ctx->ast_root) ctx->ast_root->set_globals(ctx->global_slots);
 	}
 	;
 
 program : program unit
 	{
-		outlog<<"At line no: "<<lines<<" program : program unit "<<endl<<endl;
-		outlog<<$1->getname()+"\n"+$2->getname()<<endl<<endl;
-		
-		$$ = new symbol_info($1->getname()+"\n"+$2->getname(),"program");
+		RULE_LOG<<"At line no: "<<ctx->lines<<" program : program unit "<<endl<<endl;
+		RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 		
-		// Create/update AST node for program
-		ProgramNode* prog;
-		if($1->get_ast_node()) {
-			prog = (ProgramNode*)$1->get_ast_node();
-		} else {
-			prog = new ProgramNode();
+		if(ctx->streamer)
+		{
+			// the unit goes out now, the program keeps nothing of it
+			stream_unit(ctx, $2->get_ast_node(), yychar == YYEMPTY);
+			$$ = compile_arena.make<symbol_info>(0,SYM_PROGRAM);
+			$$->set_ast_node(ctx->ast_root);
 		}
-		
-		// Add the unit to the program
-		if($2->get_ast_node()) {
-			prog->add_unit($2->get_ast_node());
+		else
+		{
+			$$ = compile_arena.make<symbol_info>(0,SYM_PROGRAM);
+			
+			// Create/update AST node for program
+			ProgramNode* prog;
+			if($1->get_ast_node()) {
+				prog = (ProgramNode*)$1->get_ast_node();
+			} else {
+				prog = compile_arena.make<ProgramNode>();
+			}
+			
+			// Add the unit to the program
+			if($2->get_ast_node()) {
+				prog->add_unit($2->get_ast_node());
+			}
+			
+			$$->set_ast_node(prog);
 		}
-		
-		$$->set_ast_node(prog);
 	}
 	| unit
 	{
-		outlog<<"At line no: "<<lines<<" program : unit "<<endl<<endl;
-		outlog<<$1->getname()<<endl<<endl;
+		RULE_LOG<<"At line no: "<<ctx->lines<<" program : unit "<<endl<<endl;
+		RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 		
-		$$ = new symbol_info($1->getname(),"program");
-		
-		// Create AST node for program with a single unit
-		ProgramNode* prog = new ProgramNode();
-		if($1->get_ast_node()) {
-			prog->add_unit($1->get_ast_node());
+		if(ctx->streamer)
+		{
+			stream_unit(ctx, $1->get_ast_node(), yychar == YYEMPTY);
+			$$ = compile_arena.make<symbol_info>(0,SYM_PROGRAM);
+			$$->set_ast_node(ctx->ast_root);
+		}
+		else
+		{
+			$$ = compile_arena.make<symbol_info>(0,SYM_PROGRAM);
+			
+			// Create AST node for program with a single unit
+			ProgramNode* prog = compile_arena.make<ProgramNode>();
+			if($1->get_ast_node()) {
+				prog->add_unit($1->get_ast_node());
+			}
+			$$->set_ast_node(prog);
 		}
-		$$->set_ast_node(prog);
 	}
 	;
 
 unit : var_declaration
 	 {
-		outlog<<"At line no: "<<lines<<" unit : var_declaration "<<endl<<endl;
-		outlog<<$1->getname()<<endl<<endl;
+		RULE_LOG<<"At line no: "<<ctx->lines<<" unit : var_declaration "<<endl<<endl;
+		RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 		
-		$$ = new symbol_info($1->getname(),"unit");
+		$$ = compile_arena.make<symbol_info>(0,SYM_UNIT);
 		$$->set_ast_node($1->get_ast_node());
 	 }
      | func_definition
      {
-		outlog<<"At line no: "<<lines<<" unit : func_definition "<<endl<<endl;
-		outlog<<$1->getname()<<endl<<endl;
+		RULE_LOG<<"At line no: "<<ctx->lines<<" unit : func_definition "<<endl<<endl;
+		RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 		
-		$$ = new symbol_info($1->getname(),"unit");
+		$$ = compile_arena.make<symbol_info>(0,SYM_UNIT);
 		$$->set_ast_node($1->get_ast_node());
 	 }
 	 | error
 	 {
-	 	$$ = new symbol_info("","unit");
+	 	$$ = compile_arena.make<symbol_info>(0,SYM_UNIT);
 	 }
      ;
 
 func_definition : type_specifier id_name LPAREN parameter_list RPAREN enter_func compound_statement
 		{	
-			outlog<<"At line no: "<<lines<<" func_definition : type_specifier ID LPAREN parameter_list RPAREN compound_statement "<<endl<<endl;
-			outlog<<$1->getname()<<" "<<$2->getname()<<"("+$4->getname()+")\n"<<$7->getname()<<endl<<endl;
+			RULE_LOG<<"At line no: "<<ctx->lines<<" func_definition : type_specifier ID LPAREN parameter_list RPAREN compound_statement "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			$$ = new symbol_info($1->getname()+" "+$2->getname()+"("+$4->getname()+")\n"+$7->getname(),"func_def");	
+			$$ = compile_arena.make<symbol_info>(0,SYM_FUNC_DEF);
 			
 			// Create AST node for function definition
-			FuncDeclNode* func = new FuncDeclNode($1->getname(), $2->getname());
+			FuncDeclNode* func = compile_arena.make<FuncDeclNode>($1->getvartype(), $2->getnameid());
 			
 			// Add parameters
-			for(int i = 0; i < paramlist.size(); i++) {
-				if(paramname[i] != "_null_") {
-					func->add_param(paramlist[i], paramname[i]);
+			for(int i = 0; i < ctx->paramlist.size(); i++) {
+				if(ctx->paramname[i] != 0) {
+					func->add_param(ctx->paramlist[i], ctx->paramname[i]);
 				}
 			}
 			
@@ -151,84 +217,91 @@ func_definition : type_specifier id_name LPAREN parameter_list RPAREN enter_func
 			if($7->get_ast_node()) {
 				func->set_body((BlockNode*)$7->get_ast_node());
 			}
+			func->set_slots(ctx->func_slots);
+			if(!ctx->options.cache_dir.empty()) func->set_cache_key(ctx->function_cache_key(@$));
 			
 			$$->set_ast_node(func);
 			
-			if(symtbl->getID()!=1)
+			if(ctx->symtbl->getID()!=1)
 			{
-				symtbl->Remove_from_table($2->getname());
+				ctx->symtbl->Remove_from_table($2->getnameid());
 			}
 			
-			paramlist.clear();
-			paramname.clear();	
+			ctx->paramlist.clear();
+			ctx->paramname.clear();	
 		}
 		| type_specifier id_name LPAREN RPAREN enter_func compound_statement
 		{
 			
-			outlog<<"At line no: "<<lines<<" func_definition : type_specifier ID LPAREN RPAREN compound_statement "<<endl<<endl;
-			outlog<<$1->getname()<<" "<<$2->getname()<<"()\n"<<$6->getname()<<endl<<endl;
+			RULE_LOG<<"At line no: "<<ctx->lines<<" func_definition : type_specifier ID LPAREN RPAREN compound_statement "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			$$ = new symbol_info($1->getname()+" "+$2->getname()+"()\n"+$6->getname(),"func_def");	
+			$$ = compile_arena.make<symbol_info>(0,SYM_FUNC_DEF);
 			
 			// Create AST node for function definition
-			FuncDeclNode* func = new FuncDeclNode($1->getname(), $2->getname());
+			FuncDeclNode* func = compile_arena.make<FuncDeclNode>($1->getvartype(), $2->getnameid());
 			
 			// Set body
 			if($6->get_ast_node()) {
 				func->set_body((BlockNode*)$6->get_ast_node());
 			}
+			func->set_slots(ctx->func_slots);
+			if(!ctx->options.cache_dir.empty()) func->set_cache_key(ctx->function_cache_key(@$));
 			
 			$$->set_ast_node(func);
 			
-			if(symtbl->getID()!=1)
+			if(ctx->symtbl->getID()!=1)
 			{
-				symtbl->Remove_from_table($2->getname());
+				ctx->symtbl->Remove_from_table($2->getnameid());
 			}
 			
-			paramlist.clear();
-			paramname.clear();	
+			ctx->paramlist.clear();
+			ctx->paramname.clear();	
 		}
  		;
 
 enter_func : {
 				//if(symtbl->getID()!="1") goto end2; //not in global scope , doesnt work because if not inserted lots of errors come in compound statement
 				
-				is_func=1;//compound statement is coming in function definition. enter parameter variables.
+				ctx->is_func=1;//compound statement is coming in function definition. enter parameter variables.
+				ctx->func_slots.clear(); //parameters and locals are numbered from 0 in every function
 				
-				if(paramlist.size()!=0) //check parameters
+				if(ctx->paramlist.size()!=0) //check parameters
 				{
-					for(int i = 0; i < paramlist.size();i++)
+					for(int i = 0; i < ctx->paramlist.size();i++)
 					{
-						if(paramname[i]=="_null_")
+						if(ctx->paramname[i]==0)
 						{
-							outerror<<"At line no: "<<lines<<" Parameter "<<i+1<<"'s name not given in function definition of "<<func_name<<endl<<endl;
-							outlog<<"At line no: "<<lines<<" Parameter "<<i+1<<"'s name not given in function definition of "<<func_name<<endl<<endl;
-							errors++;
+							ctx->outerror<<"At line no: "<<ctx->lines<<" Parameter "<<i+1<<"'s name not given in function definition of "<<names.str(ctx->func_name)<<endl<<endl;
+							ERROR_LOG<<"At line no: "<<ctx->lines<<" Parameter "<<i+1<<"'s name not given in function definition of "<<names.str(ctx->func_name)<<endl<<endl;
+							ctx->errors++;
 						}
 					}
 				}
 				
 				//check if function already present and do error checking
-				if(symtbl->Insert_in_table(func_name,"ID"))
+				symbol_info *func = ctx->symtbl->Insert_in_table(ctx->func_name,SYM_ID);
+				if(func)
 				{
-					(symtbl->Lookup_in_table(func_name))->setvartype(func_ret_type);
-					(symtbl->Lookup_in_table(func_name))->setidtype("func_def");
-					(symtbl->Lookup_in_table(func_name))->setparamlist(paramlist);//initialize parameters
-					(symtbl->Lookup_in_table(func_name))->setparamname(paramname);
+					func->setvartype(ctx->func_ret_type);
+					func->setidtype(ID_FUNC_DEF);
+					func->setparamlist(ctx->paramlist);//initialize parameters
+					func->setparamname(ctx->paramname);
 				}
 				else
 				{
-					outerror<<"At line no: "<<lines<<" Multiple declaration of function "<<func_name<<endl<<endl;
-					outlog<<"At line no: "<<lines<<" Multiple declaration of function "<<func_name<<endl<<endl;
-					errors++;
-					// (symtbl->Lookup_in_table(func_name))->setidtype("func_def");
+					ctx->outerror<<"At line no: "<<ctx->lines<<" Multiple declaration of function "<<names.str(ctx->func_name)<<endl<<endl;
+					ERROR_LOG<<"At line no: "<<ctx->lines<<" Multiple declaration of function "<<names.str(ctx->func_name)<<endl<<endl;
+					ctx->errors++;
+					func = ctx->symtbl->Lookup_in_table(ctx->func_name);
+					// func->setidtype(ID_FUNC_DEF);
 				}
 					
-				if((symtbl->Lookup_in_table(func_name))->getvartype() != func_ret_type)
+				if(func->getvartype() != ctx->func_ret_type)
 				{
-					outerror<<"At line no: "<<lines<<" Return type mismatch of function "<<func_name<<endl<<endl;
-					outlog<<"At line no: "<<lines<<" Return type mismatch of function "<<func_name<<endl<<endl;
-					errors++;
+					ctx->outerror<<"At line no: "<<ctx->lines<<" Return type mismatch of function "<<names.str(ctx->func_name)<<endl<<endl;
+					ERROR_LOG<<"At line no: "<<ctx->lines<<" Return type mismatch of function "<<names.str(ctx->func_name)<<endl<<endl;
+					ctx->errors++;
 				}
 				
 				//end2:
@@ -238,101 +311,103 @@ enter_func : {
 
 parameter_list : parameter_list COMMA type_specifier ID
 		{
-			outlog<<"At line no: "<<lines<<" parameter_list : parameter_list COMMA type_specifier ID "<<endl<<endl;
-			outlog<<$1->getname()+","+$3->getname()+" "+$4->getname()<<endl<<endl;
+			RULE_LOG<<"At line no: "<<ctx->lines<<" parameter_list : parameter_list COMMA type_specifier ID "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 					
-			$$ = new symbol_info($1->getname()+","+$3->getname()+" "+$4->getname(),"param_list");
+			$$ = compile_arena.make<symbol_info>(0,SYM_PARAM_LIST);
 			
-			if(count(paramname.begin(),paramname.end(),$4->getname()))
+			if(count(ctx->paramname.begin(),ctx->paramname.end(),$4.name))
 			{
-				outerror<<"At line no: "<<lines<<" Multiple declaration of variable "<<$4->getname()<<" in parameter of "<<func_name<<endl<<endl;
-				outlog<<"At line no: "<<lines<<" Multiple declaration of variable "<<$4->getname()<<" in parameter of "<<func_name<<endl<<endl;
-				errors++;
+				ctx->outerror<<"At line no: "<<ctx->lines<<" Multiple declaration of variable "<<names.str($4.name)<<" in parameter of "<<names.str(ctx->func_name)<<endl<<endl;
+				ERROR_LOG<<"At line no: "<<ctx->lines<<" Multiple declaration of variable "<<names.str($4.name)<<" in parameter of "<<names.str(ctx->func_name)<<endl<<endl;
+				ctx->errors++;
 			}
 			
-			paramlist.push_back($3->getname());
-			paramname.push_back($4->getname());
+			ctx->paramlist.push_back($3->getvartype());
+			ctx->paramname.push_back($4.name);
 		}
 		| parameter_list COMMA type_specifier
 		{
-			outlog<<"At line no: "<<lines<<" parameter_list : parameter_list COMMA type_specifier "<<endl<<endl;
-			outlog<<$1->getname()+","+$3->getname()<<endl<<endl;
+			RULE_LOG<<"At line no: "<<ctx->lines<<" parameter_list : parameter_list COMMA type_specifier "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			$$ = new symbol_info($1->getname()+","+$3->getname(),"param_list");
+			$$ = compile_arena.make<symbol_info>(0,SYM_PARAM_LIST);
 			
-			paramlist.push_back($3->getname());
-			paramname.push_back("_null_");
+			ctx->paramlist.push_back($3->getvartype());
+			ctx->paramname.push_back(0);
 		}
  		| type_specifier ID
  		{
-			outlog<<"At line no: "<<lines<<" parameter_list : type_specifier ID "<<endl<<endl;
-			outlog<<$1->getname()<<" "<<$2->getname()<<endl<<endl;
+			RULE_LOG<<"At line no: "<<ctx->lines<<" parameter_list : type_specifier ID "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			$$ = new symbol_info($1->getname()+" "+$2->getname(),"param_list");
+			$$ = compile_arena.make<symbol_info>(0,SYM_PARAM_LIST);
 			
-			paramlist.push_back($1->getname());
-			paramname.push_back($2->getname());
+			ctx->paramlist.push_back($1->getvartype());
+			ctx->paramname.push_back($2.name);
 		}
 		| type_specifier
 		{
-			outlog<<"At line no: "<<lines<<" parameter_list : type_specifier "<<endl<<endl;
-			outlog<<$1->getname()<<endl<<endl;
+			RULE_LOG<<"At line no: "<<ctx->lines<<" parameter_list : type_specifier "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			$$ = new symbol_info($1->getname(),"param_list");
+			$$ = compile_arena.make<symbol_info>(0,SYM_PARAM_LIST);
 			
-			paramlist.push_back($1->getname());
-			paramname.push_back("_null_");
+			ctx->paramlist.push_back($1->getvartype());
+			ctx->paramname.push_back(0);
 		}
  		;
 
 compound_statement : LCURL enter_scope_variables statements RCURL
 			{ 
- 		    	outlog<<"At line no: "<<lines<<" compound_statement : LCURL statements RCURL "<<endl<<endl;
-				outlog<<"{\n"+$3->getname()+"\n}"<<endl<<endl;
+ 		    	RULE_LOG<<"At line no: "<<ctx->lines<<" compound_statement : LCURL statements RCURL "<<endl<<endl;
+				RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 				
-				$$ = new symbol_info("{\n"+$3->getname()+"\n}","comp_stmnt");
+				$$ = compile_arena.make<symbol_info>(0,SYM_COMP_STMNT);
 				
 				// Set AST node for compound statement
 				$$->set_ast_node($3->get_ast_node());
 				
-				symtbl->Print_all_scope(outlog);
-			    symtbl->exit_scope(outlog);
+				ctx->symtbl->Print_all_scope(ctx->outlog);
+			    ctx->symtbl->exit_scope(ctx->outlog);
  		    }
  		    | LCURL enter_scope_variables RCURL
  		    { 
- 		    	outlog<<"At line no: "<<lines<<" compound_statement : LCURL RCURL "<<endl<<endl;
-				outlog<<"{\n}"<<endl<<endl;
+ 		    	RULE_LOG<<"At line no: "<<ctx->lines<<" compound_statement : LCURL RCURL "<<endl<<endl;
+				RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 				
-				$$ = new symbol_info("{\n}","comp_stmnt");
+				$$ = compile_arena.make<symbol_info>(0,SYM_COMP_STMNT);
 				
 				// Create empty block node
-				BlockNode* block = new BlockNode();
+				BlockNode* block = compile_arena.make<BlockNode>();
 				$$->set_ast_node(block);
 				
-				symtbl->Print_all_scope(outlog);
-			    symtbl->exit_scope(outlog);
+				ctx->symtbl->Print_all_scope(ctx->outlog);
+			    ctx->symtbl->exit_scope(ctx->outlog);
  		    }
  		    ;
 enter_scope_variables :
 			{
-				symtbl->enter_scope(outlog);
+				ctx->symtbl->enter_scope(ctx->outlog);
 				
-				if(is_func == 1)
+				if(ctx->is_func == 1)
 				{
-					if(paramname.size()!=0)
+					if(ctx->paramname.size()!=0)
 					{
-						for(int i = 0; i < paramname.size(); i++)
+						for(int i = 0; i < ctx->paramname.size(); i++)
 						{
-							if(paramname[i]!="_null_")
+							if(ctx->paramname[i]!=0)
 							{
-								symtbl->Insert_in_table(paramname[i],"ID");
-								(symtbl->Lookup_in_table(paramname[i]))->setidtype("var");
-								(symtbl->Lookup_in_table(paramname[i]))->setvartype(paramlist[i]);
+								symbol_info *param = ctx->symtbl->Insert_in_table(ctx->paramname[i],SYM_ID);
+								if(param == NULL) continue; //repeated parameter name, already reported
+								param->setidtype(ID_VAR);
+								param->setvartype(ctx->paramlist[i]);
+								ctx->assign_slot(param);
 							}
 							
 						}
 					}
-					is_func=0; //variable entered.if more compound statements come in func efinitions, don't enter the function variables.
+					ctx->is_func=0; //variable entered.if more compound statements come in func efinitions, don't enter the function variables.
 				}
 				
 			}
@@ -340,156 +415,143 @@ enter_scope_variables :
  		    
 var_declaration : type_specifier declaration_list SEMICOLON
 		 {
-			outlog<<"At line no: "<<lines<<" var_declaration : type_specifier declaration_list SEMICOLON "<<endl<<endl;
-			outlog<<$1->getname()<<" "<<varlist<<";"<<endl<<endl;
+			RULE_LOG<<"At line no: "<<ctx->lines<<" var_declaration : type_specifier declaration_list SEMICOLON "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			$$ = new symbol_info($1->getname()+" "+varlist+";","var_dec");
+			$$ = compile_arena.make<symbol_info>(0,SYM_VAR_DEC);
 			
-			if($1->getname()=="void")
+			if($1->getvartype()==TYPE_VOID)
 			{
-				outerror<<"At line no: "<<lines<<" variable type can not be void "<<endl<<endl;
-				outlog<<"At line no: "<<lines<<" variable type can not be void "<<endl<<endl;
-				errors++;
-				$1 = new symbol_info("error","type"); //variable is declared void so pass error instead
+				ctx->outerror<<"At line no: "<<ctx->lines<<" variable type can not be void "<<endl<<endl;
+				ERROR_LOG<<"At line no: "<<ctx->lines<<" variable type can not be void "<<endl<<endl;
+				ctx->errors++;
+				$1 = compile_arena.make<symbol_info>(0,SYM_TYPE); //variable is declared void so pass error instead
+				$1->setvartype(TYPE_ERROR);
 			}
 			
 			// Create AST node for variable declaration
-			DeclNode* declNode = new DeclNode($1->getname());
-			
-			// Parse the varlist to add variables to the declaration node
-			stringstream _varlist(varlist);
-			string varname;
+			DeclNode* declNode = compile_arena.make<DeclNode>($1->getvartype());
 			
-			while(getline(_varlist,varname,','))
+			// Add the declarators to the declaration node
+			for(auto& var : ctx->varlist)
 			{
-				if(varname.find("[") == string::npos) // normal variable
+				int name = var.first;
+				int size = var.second;
+				
+				symbol_info *sym = ctx->symtbl->Insert_in_table(name,SYM_ID);
+				if(sym)
 				{
-					declNode->add_var(varname, 0);
-					
-					if(symtbl->Insert_in_table(varname,"ID"))
+					sym->setvartype($1->getvartype());
+					if(size == 0) // normal variable
 					{
-						(symtbl->Lookup_in_table(varname))->setvartype($1->getname());
-						(symtbl->Lookup_in_table(varname))->setidtype("var");
+						sym->setidtype(ID_VAR);
 					}
-					else
+					else // array
 					{
-						outerror<<"At line no: "<<lines<<" Multiple declaration of variable "<<varname<<endl<<endl;
-						outlog<<"At line no: "<<lines<<" Multiple declaration of variable "<<varname<<endl<<endl;
-						errors++;
+						sym->setidtype(ID_ARRAY);
+						sym->setarraysize(size);
 					}
+					ctx->assign_slot(sym);
 				}
-				else // array
+				else
 				{
-					stringstream _varname(varname);
-					string name, size;
-					
-					getline(_varname,name,'['); // get array name
-					getline(_varname,size,']'); // get array size
-					
-					declNode->add_var(name, stoi(size));
-					
-					if(symtbl->Insert_in_table(name,"ID"))
-					{
-						(symtbl->Lookup_in_table(name))->setvartype($1->getname());
-						(symtbl->Lookup_in_table(name))->setidtype("array");
-						(symtbl->Lookup_in_table(name))->setarraysize(stoi(size));
-					}
-					else
-					{
-						outerror<<"At line no: "<<lines<<" Multiple declaration of variable "<<name<<endl<<endl;
-						outlog<<"At line no: "<<lines<<" Multiple declaration of variable "<<name<<endl<<endl;
-						errors++;
-					}
+					ctx->outerror<<"At line no: "<<ctx->lines<<" Multiple declaration of variable "<<names.str(name)<<endl<<endl;
+					ERROR_LOG<<"At line no: "<<ctx->lines<<" Multiple declaration of variable "<<names.str(name)<<endl<<endl;
+					ctx->errors++;
 				}
+				declNode->add_var(name, size, storage_of(sym));
 			}
 			
 			$$->set_ast_node(declNode);
-			varlist = "";
+			ctx->varlist.clear();
 		 }
  		 ;
 
 type_specifier : INT
 		{
-			outlog<<"At line no: "<<lines<<" type_specifier : INT "<<endl<<endl;
-			outlog<<"int"<<endl<<endl;
+			RULE_LOG<<"At line no: "<<ctx->lines<<" type_specifier : INT "<<endl<<endl;
+			RULE_LOG<<"int"<<endl<<endl;
 			
-			$$ = new symbol_info("int","type");
-			ret_type = "int";
+			$$ = compile_arena.make<symbol_info>(0,SYM_TYPE);
+			$$->setvartype(TYPE_INT);
+			ctx->ret_type = TYPE_INT;
 	    }
  		| FLOAT
  		{
-			outlog<<"At line no: "<<lines<<" type_specifier : FLOAT "<<endl<<endl;
-			outlog<<"float"<<endl<<endl;
+			RULE_LOG<<"At line no: "<<ctx->lines<<" type_specifier : FLOAT "<<endl<<endl;
+			RULE_LOG<<"float"<<endl<<endl;
 			
-			$$ = new symbol_info("float","type");
-			ret_type = "float";
+			$$ = compile_arena.make<symbol_info>(0,SYM_TYPE);
+			$$->setvartype(TYPE_FLOAT);
+			ctx->ret_type = TYPE_FLOAT;
 	    }
  		| VOID
  		{
-			outlog<<"At line no: "<<lines<<" type_specifier : VOID "<<endl<<endl;
-			outlog<<"void"<<endl<<endl;
+			RULE_LOG<<"At line no: "<<ctx->lines<<" type_specifier : VOID "<<endl<<endl;
+			RULE_LOG<<"void"<<endl<<endl;
 			
-			$$ = new symbol_info("void","type");
-			ret_type = "void";
+			$$ = compile_arena.make<symbol_info>(0,SYM_TYPE);
+			$$->setvartype(TYPE_VOID);
+			ctx->ret_type = TYPE_VOID;
 	    }
  		;
 
 declaration_list : declaration_list COMMA id_name
 		  {
- 		  	string name = $3->getname();
- 		  	outlog<<"At line no: "<<lines<<" declaration_list : declaration_list COMMA ID "<<endl<<endl;
+ 		  	int name = $3->getnameid();
+ 		  	RULE_LOG<<"At line no: "<<ctx->lines<<" declaration_list : declaration_list COMMA ID "<<endl<<endl;
  		  	
- 		  	varlist=varlist+","+name;
+ 		  	ctx->varlist.push_back(make_pair(name, 0));
  		  	
-			outlog<<varlist<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
  		  }
  		  | declaration_list COMMA id_name LTHIRD CONST_INT RTHIRD //array after some declaration
  		  {
- 		  	string name = $3->getname();
- 		  	string size = $5->getname();
- 		  	outlog<<"At line no: "<<lines<<" declaration_list : declaration_list COMMA ID LTHIRD CONST_INT RTHIRD "<<endl<<endl;
+ 		  	int name = $3->getnameid();
+ 		  	int size = $5.int_value;
+ 		  	RULE_LOG<<"At line no: "<<ctx->lines<<" declaration_list : declaration_list COMMA ID LTHIRD CONST_INT RTHIRD "<<endl<<endl;
  		  	
- 		  	varlist=varlist+","+name+"["+size+"]";
+ 		  	ctx->varlist.push_back(make_pair(name, size));
  		  	
-			outlog<<varlist<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
  		  }
  		  |id_name
  		  {
- 		  	string name = $1->getname();
- 		  	outlog<<"At line no: "<<lines<<" declaration_list : ID "<<endl<<endl;
-			outlog<<name<<endl<<endl;
+ 		  	int name = $1->getnameid();
+ 		  	RULE_LOG<<"At line no: "<<ctx->lines<<" declaration_list : ID "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			varlist+=name;
+			ctx->varlist.push_back(make_pair(name, 0));
  		  }
  		  | id_name LTHIRD CONST_INT RTHIRD //array
  		  {
- 		  	string name = $1->getname();
- 		  	string size = $3->getname();
- 		  	outlog<<"At line no: "<<lines<<" declaration_list : ID LTHIRD CONST_INT RTHIRD "<<endl<<endl;
-			outlog<<name+"["+size+"]"<<endl<<endl;
+ 		  	int name = $1->getnameid();
+ 		  	int size = $3.int_value;
+ 		  	RULE_LOG<<"At line no: "<<ctx->lines<<" declaration_list : ID LTHIRD CONST_INT RTHIRD "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			varlist=varlist+name+"["+size+"]";
+			ctx->varlist.push_back(make_pair(name, size));
  		  }
  		  ;
 id_name : ID
 		  {
-		   	$$ = new symbol_info($1->getname(),"ID");
-		   	func_name = $1->getname();
-		   	func_ret_type = ret_type;
+		   	$$ = compile_arena.make<symbol_info>($1.name,SYM_ID);
+		   	ctx->func_name = $1.name;
+		   	ctx->func_ret_type = ctx->ret_type;
 		  }
  		  ;
 
 statements : statement
 	   {
-	    	outlog<<"At line no: "<<lines<<" statements : statement "<<endl<<endl;
-			outlog<<$1->getname()<<endl<<endl;
+	    	RULE_LOG<<"At line no: "<<ctx->lines<<" statements : statement "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			$$ = new symbol_info($1->getname(),"stmnts");
+			$$ = compile_arena.make<symbol_info>(0,SYM_STMNTS);
 			
 			// Create block for statements
-			BlockNode* block = new BlockNode();
+			BlockNode* block = compile_arena.make<BlockNode>();
 			if($1->get_ast_node()) {
 				block->add_statement((StmtNode*)$1->get_ast_node());
 			}
@@ -497,10 +559,10 @@ statements : statement
 	   }
 	   | statements statement
 	   {
-	    	outlog<<"At line no: "<<lines<<" statements : statements statement "<<endl<<endl;
-			outlog<<$1->getname()<<"\n"<<$2->getname()<<endl<<endl;
+	    	RULE_LOG<<"At line no: "<<ctx->lines<<" statements : statements statement "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			$$ = new symbol_info($1->getname()+"\n"+$2->getname(),"stmnts");
+			$$ = compile_arena.make<symbol_info>(0,SYM_STMNTS);
 			
 			// Update block with new statement
 			BlockNode* block = (BlockNode*)$1->get_ast_node();
@@ -511,60 +573,60 @@ statements : statement
 	   }
 	   | error
 	   {
-	  		$$ = new symbol_info("","stmnts");
-			BlockNode* block = new BlockNode();
+	  		$$ = compile_arena.make<symbol_info>(0,SYM_STMNTS);
+			BlockNode* block = compile_arena.make<BlockNode>();
 			$$->set_ast_node(block);
 	   }  
 	   | statements error
 	   {
-	   		$$ = new symbol_info($1->getname(),"stmnts");
+	   		$$ = compile_arena.make<symbol_info>(0,SYM_STMNTS);
 			$$->set_ast_node($1->get_ast_node());
 	   }
 	   ;
 	   
 statement : var_declaration
 	  {
-	    	outlog<<"At line no: "<<lines<<" statement : var_declaration "<<endl<<endl;
-			outlog<<$1->getname()<<endl<<endl;
+	    	RULE_LOG<<"At line no: "<<ctx->lines<<" statement : var_declaration "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			$$ = new symbol_info($1->getname(),"stmnt");
+			$$ = compile_arena.make<symbol_info>(0,SYM_STMNT);
 			$$->set_ast_node($1->get_ast_node());
 	  }
 	  | func_definition
 	  {
-	  		outlog<<"At line no: "<<lines<<" Function definition must be in the global scope "<<endl<<endl;
-	  		outerror<<"At line no: "<<lines<<" Function definition must be in the global scope "<<endl<<endl;
-	  		errors++;
-	  		$$ = new symbol_info("","stmnt");
+	  		ERROR_LOG<<"At line no: "<<ctx->lines<<" Function definition must be in the global scope "<<endl<<endl;
+	  		ctx->outerror<<"At line no: "<<ctx->lines<<" Function definition must be in the global scope "<<endl<<endl;
+	  		ctx->errors++;
+	  		$$ = compile_arena.make<symbol_info>(0,SYM_STMNT);
 	  		
 	  }
 	  | expression_statement
 	  {
-	    	outlog<<"At line no: "<<lines<<" statement : expression_statement "<<endl<<endl;
-			outlog<<$1->getname()<<endl<<endl;
+	    	RULE_LOG<<"At line no: "<<ctx->lines<<" statement : expression_statement "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			$$ = new symbol_info($1->getname(),"stmnt");
+			$$ = compile_arena.make<symbol_info>(0,SYM_STMNT);
 			$$->set_ast_node($1->get_ast_node());
 	  }
 	  | compound_statement
 	  {
-	    	outlog<<"At line no: "<<lines<<" statement : compound_statement "<<endl<<endl;
-			outlog<<$1->getname()<<endl<<endl;
+	    	RULE_LOG<<"At line no: "<<ctx->lines<<" statement : compound_statement "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			$$ = new symbol_info($1->getname(),"stmnt");
+			$$ = compile_arena.make<symbol_info>(0,SYM_STMNT);
 			$$->set_ast_node($1->get_ast_node());
 	  }
 	  | FOR LPAREN expression_statement expression_statement expression RPAREN statement
 	  {
-	    	outlog<<"At line no: "<<lines<<" statement : FOR LPAREN expression_statement expression_statement expression RPAREN statement "<<endl<<endl;
-			outlog<<"for("<<$3->getname()<<$4->getname()<<$5->getname()<<")\n"<<$7->getname()<<endl<<endl;
+	    	RULE_LOG<<"At line no: "<<ctx->lines<<" statement : FOR LPAREN expression_statement expression_statement expression RPAREN statement "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			$$ = new symbol_info("for("+$3->getname()+$4->getname()+$5->getname()+")\n"+$7->getname(),"stmnt");
+			$$ = compile_arena.make<symbol_info>(0,SYM_STMNT);
 			
 			// Create AST node for for loop
-			ForNode* forNode = new ForNode(
-				(ExprNode*)$3->get_ast_node(),
-				(ExprNode*)$4->get_ast_node(),
+			ForNode* forNode = compile_arena.make<ForNode>(
+				((ExprStmtNode*)$3->get_ast_node())->get_expr(),
+				((ExprStmtNode*)$4->get_ast_node())->get_expr(),
 				(ExprNode*)$5->get_ast_node(),
 				(StmtNode*)$7->get_ast_node()
 			);
@@ -572,13 +634,13 @@ statement : var_declaration
 	  }
 	  | IF LPAREN expression RPAREN statement %prec LOWER_THAN_ELSE
 	  {
-	    	outlog<<"At line no: "<<lines<<" statement : IF LPAREN expression RPAREN statement "<<endl<<endl;
-			outlog<<"if("<<$3->getname()<<")\n"<<$5->getname()<<endl<<endl;
+	    	RULE_LOG<<"At line no: "<<ctx->lines<<" statement : IF LPAREN expression RPAREN statement "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			$$ = new symbol_info("if("+$3->getname()+")\n"+$5->getname(),"stmnt");
+			$$ = compile_arena.make<symbol_info>(0,SYM_STMNT);
 			
 			// Create AST node for if statement (without else)
-			IfNode* ifNode = new IfNode(
+			IfNode* ifNode = compile_arena.make<IfNode>(
 				(ExprNode*)$3->get_ast_node(),
 				(StmtNode*)$5->get_ast_node()
 			);
@@ -586,13 +648,13 @@ statement : var_declaration
 	  }
 	  | IF LPAREN expression RPAREN statement ELSE statement
 	  {
-	    	outlog<<"At line no: "<<lines<<" statement : IF LPAREN expression RPAREN statement ELSE statement "<<endl<<endl;
-			outlog<<"if("<<$3->getname()<<")\n"<<$5->getname()<<"\nelse\n"<<$7->getname()<<endl<<endl;
+	    	RULE_LOG<<"At line no: "<<ctx->lines<<" statement : IF LPAREN expression RPAREN statement ELSE statement "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			$$ = new symbol_info("if("+$3->getname()+")\n"+$5->getname()+"\nelse\n"+$7->getname(),"stmnt");
+			$$ = compile_arena.make<symbol_info>(0,SYM_STMNT);
 			
 			// Create AST node for if-else statement
-			IfNode* ifNode = new IfNode(
+			IfNode* ifNode = compile_arena.make<IfNode>(
 				(ExprNode*)$3->get_ast_node(),
 				(StmtNode*)$5->get_ast_node(),
 				(StmtNode*)$7->get_ast_node()
@@ -601,13 +663,13 @@ statement : var_declaration
 	  }
 	  | WHILE LPAREN expression RPAREN statement
 	  {
-	    	outlog<<"At line no: "<<lines<<" statement : WHILE LPAREN expression RPAREN statement "<<endl<<endl;
-			outlog<<"while("<<$3->getname()<<")\n"<<$5->getname()<<endl<<endl;
+	    	RULE_LOG<<"At line no: "<<ctx->lines<<" statement : WHILE LPAREN expression RPAREN statement "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			$$ = new symbol_info("while("+$3->getname()+")\n"+$5->getname(),"stmnt");
+			$$ = compile_arena.make<symbol_info>(0,SYM_STMNT);
 			
 			// Create AST node for while loop
-			WhileNode* whileNode = new WhileNode(
+			WhileNode* whileNode = compile_arena.make<WhileNode>(
 				(ExprNode*)$3->get_ast_node(),
 				(StmtNode*)$5->get_ast_node()
 			);
@@ -615,191 +677,197 @@ statement : var_declaration
 	  }
 	  | PRINTLN LPAREN id_name RPAREN SEMICOLON
 	  {
-	    	outlog<<"At line no: "<<lines<<" statement : PRINTLN LPAREN ID RPAREN SEMICOLON "<<endl<<endl;
-			outlog<<"printf("<<$3->getname()<<");"<<endl<<endl; 
+	    	RULE_LOG<<"At line no: "<<ctx->lines<<" statement : PRINTLN LPAREN ID RPAREN SEMICOLON "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			if(symtbl->Lookup_in_table($3->getname()) == NULL)
+			symbol_info *sym = ctx->symtbl->Lookup_in_table($3->getnameid());
+			
+			if(sym == NULL)
 			{
-				outerror<<"At line no: "<<lines<<" Undeclared variable "<<$3->getname()<<endl<<endl;
-				outlog<<"At line no: "<<lines<<" Undeclared variable "<<$3->getname()<<endl<<endl;
-				errors++;
+				ctx->outerror<<"At line no: "<<ctx->lines<<" Undeclared variable "<<$3->getname()<<endl<<endl;
+				ERROR_LOG<<"At line no: "<<ctx->lines<<" Undeclared variable "<<$3->getname()<<endl<<endl;
+				ctx->errors++;
 			}
 			
-			$$ = new symbol_info("printf("+$3->getname()+");","stmnt");
+			$$ = compile_arena.make<symbol_info>(0,SYM_STMNT);
 			
 			// Could add a PrintNode to AST if needed
 			// For now, create a basic expression statement
-			VarNode* var = new VarNode($3->getname(), 
-			                         symtbl->Lookup_in_table($3->getname()) ? 
-			                         symtbl->Lookup_in_table($3->getname())->getvartype() : "error");
-			ExprStmtNode* printNode = new ExprStmtNode(var);
+			VarNode* var = compile_arena.make<VarNode>($3->getnameid(), 
+			                         sym ? 
+			                         sym->getvartype() : TYPE_ERROR, storage_of(sym));
+			ExprStmtNode* printNode = compile_arena.make<ExprStmtNode>(var);
 			$$->set_ast_node(printNode);
 	  }
 	  | RETURN expression SEMICOLON
 	  {
-	    	outlog<<"At line no: "<<lines<<" statement : RETURN expression SEMICOLON "<<endl<<endl;
-			outlog<<"return "<<$2->getname()<<";"<<endl<<endl;
+	    	RULE_LOG<<"At line no: "<<ctx->lines<<" statement : RETURN expression SEMICOLON "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			$$ = new symbol_info("return "+$2->getname()+";","stmnt");
+			$$ = compile_arena.make<symbol_info>(0,SYM_STMNT);
 			
 			// Create AST node for return statement
-			ReturnNode* returnNode = new ReturnNode((ExprNode*)$2->get_ast_node());
+			ReturnNode* returnNode = compile_arena.make<ReturnNode>((ExprNode*)$2->get_ast_node());
 			$$->set_ast_node(returnNode);
 	  }
 	  ;
 	  
 expression_statement : SEMICOLON
 			{
-				outlog<<"At line no: "<<lines<<" expression_statement : SEMICOLON "<<endl<<endl;
-				outlog<<";"<<endl<<endl;
+				RULE_LOG<<"At line no: "<<ctx->lines<<" expression_statement : SEMICOLON "<<endl<<endl;
+				RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 				
-				$$ = new symbol_info(";","expr_stmt");
+				$$ = compile_arena.make<symbol_info>(0,SYM_EXPR_STMT);
 				
 				// Create empty expression statement
-				ExprStmtNode* exprStmt = new ExprStmtNode(nullptr);
+				ExprStmtNode* exprStmt = compile_arena.make<ExprStmtNode>(nullptr);
 				$$->set_ast_node(exprStmt);
 	        }			
 			| expression SEMICOLON 
 			{
-				outlog<<"At line no: "<<lines<<" expression_statement : expression SEMICOLON "<<endl<<endl;
-				outlog<<$1->getname()<<";"<<endl<<endl;
+				RULE_LOG<<"At line no: "<<ctx->lines<<" expression_statement : expression SEMICOLON "<<endl<<endl;
+				RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 				
-				$$ = new symbol_info($1->getname()+";","expr_stmt");
+				$$ = compile_arena.make<symbol_info>(0,SYM_EXPR_STMT);
 				
 				// Create expression statement from expression
-				ExprStmtNode* exprStmt = new ExprStmtNode((ExprNode*)$1->get_ast_node());
+				ExprStmtNode* exprStmt = compile_arena.make<ExprStmtNode>((ExprNode*)$1->get_ast_node());
 				$$->set_ast_node(exprStmt);
 	        }
 			;
 	  
 variable : id_name 	
       {
-	    outlog<<"At line no: "<<lines<<" variable : ID "<<endl<<endl;
-		outlog<<$1->getname()<<endl<<endl;
+	    RULE_LOG<<"At line no: "<<ctx->lines<<" variable : ID "<<endl<<endl;
+		RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-		$$ = new symbol_info($1->getname(),"varbl");
+		$$ = compile_arena.make<symbol_info>(0,SYM_VARBL);
+		
+		symbol_info *var = ctx->symtbl->Lookup_in_table($1->getnameid());
 		
-		if(symtbl->Lookup_in_table($1->getname()) == NULL)
+		if(var == NULL)
 		{
-			outerror<<"At line no: "<<lines<<" Undeclared variable "<<$1->getname()<<endl<<endl;
-			outlog<<"At line no: "<<lines<<" Undeclared variable "<<$1->getname()<<endl<<endl;
-			errors++;
+			ctx->outerror<<"At line no: "<<ctx->lines<<" Undeclared variable "<<$1->getname()<<endl<<endl;
+			ERROR_LOG<<"At line no: "<<ctx->lines<<" Undeclared variable "<<$1->getname()<<endl<<endl;
+			ctx->errors++;
 			
-			$$->setvartype("error");; //not found set error type
+			$$->setvartype(TYPE_ERROR);; //not found set error type
 		}
-		else if((symtbl->Lookup_in_table($1->getname()))->getidtype() != "var") //variable is not a normal variable
+		else if(var->getidtype() != ID_VAR) //variable is not a normal variable
 		{
-			if((symtbl->Lookup_in_table($1->getname()))->getidtype() == "array")
+			if(var->getidtype() == ID_ARRAY)
 			{
-				outerror<<"At line no: "<<lines<<" variable is of array type : "<<$1->getname()<<endl<<endl;
-				outlog<<"At line no: "<<lines<<" variable is of array type : "<<$1->getname()<<endl<<endl;
-				errors++;
+				ctx->outerror<<"At line no: "<<ctx->lines<<" variable is of array type : "<<$1->getname()<<endl<<endl;
+				ERROR_LOG<<"At line no: "<<ctx->lines<<" variable is of array type : "<<$1->getname()<<endl<<endl;
+				ctx->errors++;
 			}
-			else if((symtbl->Lookup_in_table($1->getname()))->getidtype() == "func_def") 
+			else if(var->getidtype() == ID_FUNC_DEF) 
 			{
-				outerror<<"At line no: "<<lines<<" variable is of function type : "<<$1->getname()<<endl<<endl;
-				outlog<<"At line no: "<<lines<<" variable is of function type : "<<$1->getname()<<endl<<endl;
-				errors++;
+				ctx->outerror<<"At line no: "<<ctx->lines<<" variable is of function type : "<<$1->getname()<<endl<<endl;
+				ERROR_LOG<<"At line no: "<<ctx->lines<<" variable is of function type : "<<$1->getname()<<endl<<endl;
+				ctx->errors++;
 			}
-			else if((symtbl->Lookup_in_table($1->getname()))->getidtype() == "func_dec") 
+			else if(var->getidtype() == ID_FUNC_DEC) 
 			{
-				outerror<<"At line no: "<<lines<<" variable is of function type : "<<$1->getname()<<endl<<endl;
-				outlog<<"At line no: "<<lines<<" variable is of function type : "<<$1->getname()<<endl<<endl;
-				errors++;
+				ctx->outerror<<"At line no: "<<ctx->lines<<" variable is of function type : "<<$1->getname()<<endl<<endl;
+				ERROR_LOG<<"At line no: "<<ctx->lines<<" variable is of function type : "<<$1->getname()<<endl<<endl;
+				ctx->errors++;
 			}
 			
 			
-			$$->setvartype("error");; //doesnt match set error type
+			$$->setvartype(TYPE_ERROR);; //doesnt match set error type
 		}
-		else $$->setvartype((symtbl->Lookup_in_table($1->getname()))->getvartype());  //set variable type as id type
+		else $$->setvartype(var->getvartype());  //set variable type as id type
 		
 		// Create AST node for variable
-		VarNode* varNode = new VarNode($1->getname(), $$->getvartype());
+		VarNode* varNode = compile_arena.make<VarNode>($1->getnameid(), $$->getvartype(), storage_of(var));
 		$$->set_ast_node(varNode);
 	 }	
 	 | id_name LTHIRD expression RTHIRD 
 	 {
-	 	outlog<<"At line no: "<<lines<<" variable : ID LTHIRD expression RTHIRD "<<endl<<endl;
-		outlog<<$1->getname()<<"["<<$3->getname()<<"]"<<endl<<endl;
+	 	RULE_LOG<<"At line no: "<<ctx->lines<<" variable : ID LTHIRD expression RTHIRD "<<endl<<endl;
+		RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 		
-		$$ = new symbol_info($1->getname()+"["+$3->getname()+"]","varbl");
+		$$ = compile_arena.make<symbol_info>(0,SYM_VARBL);
 		
-		if(symtbl->Lookup_in_table($1->getname()) == NULL)
+		symbol_info *var = ctx->symtbl->Lookup_in_table($1->getnameid());
+		
+		if(var == NULL)
 		{
-			outerror<<"At line no: "<<lines<<" Undeclared variable "<<$1->getname()<<endl<<endl;
-			outlog<<"At line no: "<<lines<<" Undeclared variable "<<$1->getname()<<endl<<endl;
-			errors++;
+			ctx->outerror<<"At line no: "<<ctx->lines<<" Undeclared variable "<<$1->getname()<<endl<<endl;
+			ERROR_LOG<<"At line no: "<<ctx->lines<<" Undeclared variable "<<$1->getname()<<endl<<endl;
+			ctx->errors++;
 			
-			$$->setvartype("error");; //not found set error type
+			$$->setvartype(TYPE_ERROR);; //not found set error type
 		}
-		else if((symtbl->Lookup_in_table($1->getname()))->getidtype() != "array") //variable is not an array
+		else if(var->getidtype() != ID_ARRAY) //variable is not an array
 		{
-			outerror<<"At line no: "<<lines<<" variable is not of array type : "<<$1->getname()<<endl<<endl;
-			outlog<<"At line no: "<<lines<<" variable is not of array type : "<<$1->getname()<<endl<<endl;
-			errors++;
+			ctx->outerror<<"At line no: "<<ctx->lines<<" variable is not of array type : "<<$1->getname()<<endl<<endl;
+			ERROR_LOG<<"At line no: "<<ctx->lines<<" variable is not of array type : "<<$1->getname()<<endl<<endl;
+			ctx->errors++;
 			
-			$$->setvartype("error");; //doesnt match set error type
+			$$->setvartype(TYPE_ERROR);; //doesnt match set error type
 		}
-		else if($3->getvartype()!="int") // get type of expression of array index
+		else if($3->getvartype() != TYPE_INT) // get type of expression of array index
 		{
-			outerror<<"At line no: "<<lines<<" array index is not of integer type : "<<$1->getname()<<endl<<endl;
-			outlog<<"At line no: "<<lines<<" array index is not of integer type : "<<$1->getname()<<endl<<endl;
-			errors++;
+			ctx->outerror<<"At line no: "<<ctx->lines<<" array index is not of integer type : "<<$1->getname()<<endl<<endl;
+			ERROR_LOG<<"At line no: "<<ctx->lines<<" array index is not of integer type : "<<$1->getname()<<endl<<endl;
+			ctx->errors++;
 			
-			$$->setvartype("error");
+			$$->setvartype(TYPE_ERROR);
 		}
 		else
 		{
-			$$->setvartype((symtbl->Lookup_in_table($1->getname()))->getvartype());
+			$$->setvartype(var->getvartype());
 		}
 		
 		// Create AST node for array access
-		VarNode* varNode = new VarNode($1->getname(), $$->getvartype(), (ExprNode*)$3->get_ast_node());
+		VarNode* varNode = compile_arena.make<VarNode>($1->getnameid(), $$->getvartype(), storage_of(var), (ExprNode*)$3->get_ast_node());
 		$$->set_ast_node(varNode);
 	 }
 	 ;
 	 
 expression : logic_expression //expr can be void
 	   {
-	    	outlog<<"At line no: "<<lines<<" expression : logic_expression "<<endl<<endl;
-			outlog<<$1->getname()<<endl<<endl;
+	    	RULE_LOG<<"At line no: "<<ctx->lines<<" expression : logic_expression "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			$$ = new symbol_info($1->getname(),"expr");
+			$$ = compile_arena.make<symbol_info>(0,SYM_EXPR);
 			$$->setvartype($1->getvartype());
 			$$->set_ast_node($1->get_ast_node());
 	   }
 	   | variable ASSIGNOP logic_expression 	
 	   {
-	    	outlog<<"At line no: "<<lines<<" expression : variable ASSIGNOP logic_expression "<<endl<<endl;
-			outlog<<$1->getname()<<"="<<$3->getname()<<endl<<endl;
+	    	RULE_LOG<<"At line no: "<<ctx->lines<<" expression : variable ASSIGNOP logic_expression "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 
-			$$ = new symbol_info($1->getname()+"="+$3->getname(),"expr");
+			$$ = compile_arena.make<symbol_info>(0,SYM_EXPR);
 			$$->setvartype($1->getvartype());
 			
-			if($1->getvartype() == "void" || $3->getvartype() == "void") //if any of them is a void
+			if($1->getvartype() == TYPE_VOID || $3->getvartype() == TYPE_VOID) //if any of them is a void
 			{
-				outerror<<"At line no: "<<lines<<" operation on void type "<<endl<<endl;
-				outlog<<"At line no: "<<lines<<" operation on void type "<<endl<<endl;
-				errors++;
+				ctx->outerror<<"At line no: "<<ctx->lines<<" operation on void type "<<endl<<endl;
+				ERROR_LOG<<"At line no: "<<ctx->lines<<" operation on void type "<<endl<<endl;
+				ctx->errors++;
 				
-				$$->setvartype("error");
+				$$->setvartype(TYPE_ERROR);
 			}
-			else if($1->getvartype() == "int" && $3->getvartype() == "float") // assignment of float into int
+			else if($1->getvartype() == TYPE_INT && $3->getvartype() == TYPE_FLOAT) // assignment of float into int
 			{
-				outerror<<"At line no: "<<lines<<" Warning: Assignment of float value into variable of integer type "<<endl<<endl;
-				outlog<<"At line no: "<<lines<<" Warning: Assignment of float value into variable of integer type "<<endl<<endl;
-				errors++;
+				ctx->outerror<<"At line no: "<<ctx->lines<<" Warning: Assignment of float value into variable of integer type "<<endl<<endl;
+				ERROR_LOG<<"At line no: "<<ctx->lines<<" Warning: Assignment of float value into variable of integer type "<<endl<<endl;
+				ctx->errors++;
 				
-				$$->setvartype("int");
+				$$->setvartype(TYPE_INT);
 			}
 			
-			if($1->getvartype() == "error" || $3->getvartype() == "error") //if any of them is a error
+			if($1->getvartype() == TYPE_ERROR || $3->getvartype() == TYPE_ERROR) //if any of them is a error
 			{
-				$$->setvartype("error");
+				$$->setvartype(TYPE_ERROR);
 			}
 			
 			// Create AST node for assignment
-			AssignNode* assignNode = new AssignNode(
+			AssignNode* assignNode = compile_arena.make<AssignNode>(
 				(VarNode*)$1->get_ast_node(),
 				(ExprNode*)$3->get_ast_node(),
 				$$->getvartype()
@@ -810,40 +878,40 @@ expression : logic_expression //expr can be void
 			
 logic_expression : rel_expression //lgc_expr can be void
 	     {
-	    	outlog<<"At line no: "<<lines<<" logic_expression : rel_expression "<<endl<<endl;
-			outlog<<$1->getname()<<endl<<endl;
+	    	RULE_LOG<<"At line no: "<<ctx->lines<<" logic_expression : rel_expression "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			$$ = new symbol_info($1->getname(),"lgc_expr");
+			$$ = compile_arena.make<symbol_info>(0,SYM_LGC_EXPR);
 			$$->setvartype($1->getvartype());
 			$$->set_ast_node($1->get_ast_node());
 	     }	
 		 | rel_expression LOGICOP rel_expression 
 		 {
-	    	outlog<<"At line no: "<<lines<<" logic_expression : rel_expression LOGICOP rel_expression "<<endl<<endl;
-			outlog<<$1->getname()<<$2->getname()<<$3->getname()<<endl<<endl;
+	    	RULE_LOG<<"At line no: "<<ctx->lines<<" logic_expression : rel_expression LOGICOP rel_expression "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			$$ = new symbol_info($1->getname()+$2->getname()+$3->getname(),"lgc_expr");
-			$$->setvartype("int");
+			$$ = compile_arena.make<symbol_info>(0,SYM_LGC_EXPR);
+			$$->setvartype(TYPE_INT);
 			
 			//do type checking of both side of logicop
 			
-			if($1->getvartype() == "void" || $3->getvartype() == "void") //if any of them is a void
+			if($1->getvartype() == TYPE_VOID || $3->getvartype() == TYPE_VOID) //if any of them is a void
 			{
-				outerror<<"At line no: "<<lines<<" operation on void type "<<endl<<endl;
-				outlog<<"At line no: "<<lines<<" operation on void type "<<endl<<endl;
-				errors++;
+				ctx->outerror<<"At line no: "<<ctx->lines<<" operation on void type "<<endl<<endl;
+				ERROR_LOG<<"At line no: "<<ctx->lines<<" operation on void type "<<endl<<endl;
+				ctx->errors++;
 				
-				$$->setvartype("error");
+				$$->setvartype(TYPE_ERROR);
 			}
 			
-			if($1->getvartype() == "error" || $3->getvartype() == "error") //if any of them is a error
+			if($1->getvartype() == TYPE_ERROR || $3->getvartype() == TYPE_ERROR) //if any of them is a error
 			{
-				$$->setvartype("error");
+				$$->setvartype(TYPE_ERROR);
 			}
 			
 			// Create AST node for logical operation
-			BinaryOpNode* logicNode = new BinaryOpNode(
-				$2->getname(),
+			BinaryOpNode* logicNode = compile_arena.make<BinaryOpNode>(
+				$2.op,
 				(ExprNode*)$1->get_ast_node(),
 				(ExprNode*)$3->get_ast_node(),
 				$$->getvartype()
@@ -854,40 +922,40 @@ logic_expression : rel_expression //lgc_expr can be void
 			
 rel_expression	: simple_expression //rel_expr can be void
 		{
-	    	outlog<<"At line no: "<<lines<<" rel_expression : simple_expression "<<endl<<endl;
-			outlog<<$1->getname()<<endl<<endl;
+	    	RULE_LOG<<"At line no: "<<ctx->lines<<" rel_expression : simple_expression "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			$$ = new symbol_info($1->getname(),"rel_expr");
+			$$ = compile_arena.make<symbol_info>(0,SYM_REL_EXPR);
 			$$->setvartype($1->getvartype());
 			$$->set_ast_node($1->get_ast_node());
 	    }
 		| simple_expression RELOP simple_expression
 		{
-	    	outlog<<"At line no: "<<lines<<" rel_expression : simple_expression RELOP simple_expression "<<endl<<endl;
-			outlog<<$1->getname()<<$2->getname()<<$3->getname()<<endl<<endl;
+	    	RULE_LOG<<"At line no: "<<ctx->lines<<" rel_expression : simple_expression RELOP simple_expression "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			$$ = new symbol_info($1->getname()+$2->getname()+$3->getname(),"rel_expr");
-			$$->setvartype("int");
+			$$ = compile_arena.make<symbol_info>(0,SYM_REL_EXPR);
+			$$->setvartype(TYPE_INT);
 			
 			//do type checking of both side of relop
 			
-			if($1->getvartype() == "void" || $3->getvartype() == "void") //if any of them is a void
+			if($1->getvartype() == TYPE_VOID || $3->getvartype() == TYPE_VOID) //if any of them is a void
 			{
-				outerror<<"At line no: "<<lines<<" operation on void type "<<endl<<endl;
-				outlog<<"At line no: "<<lines<<" operation on void type "<<endl<<endl;
-				errors++;
+				ctx->outerror<<"At line no: "<<ctx->lines<<" operation on void type "<<endl<<endl;
+				ERROR_LOG<<"At line no: "<<ctx->lines<<" operation on void type "<<endl<<endl;
+				ctx->errors++;
 				
-				$$->setvartype("error");
+				$$->setvartype(TYPE_ERROR);
 			}
 			
-			if($1->getvartype() == "error" || $3->getvartype() == "error") //if any of them is a error
+			if($1->getvartype() == TYPE_ERROR || $3->getvartype() == TYPE_ERROR) //if any of them is a error
 			{
-				$$->setvartype("error");
+				$$->setvartype(TYPE_ERROR);
 			}
 			
 			// Create AST node for relational operation
-			BinaryOpNode* relNode = new BinaryOpNode(
-				$2->getname(),
+			BinaryOpNode* relNode = compile_arena.make<BinaryOpNode>(
+				$2.op,
 				(ExprNode*)$1->get_ast_node(),
 				(ExprNode*)$3->get_ast_node(),
 				$$->getvartype()
@@ -898,46 +966,46 @@ rel_expression	: simple_expression //rel_expr can be void
 				
 simple_expression : term //simp_expr can be void
           {
-	    	outlog<<"At line no: "<<lines<<" simple_expression : term "<<endl<<endl;
-			outlog<<$1->getname()<<endl<<endl;
+	    	RULE_LOG<<"At line no: "<<ctx->lines<<" simple_expression : term "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			$$ = new symbol_info($1->getname(),"simp_expr");
+			$$ = compile_arena.make<symbol_info>(0,SYM_SIMP_EXPR);
 			$$->setvartype($1->getvartype());
 			$$->set_ast_node($1->get_ast_node());
 			
 	      }
 		  | simple_expression ADDOP term 
 		  {
-	    	outlog<<"At line no: "<<lines<<" simple_expression : simple_expression ADDOP term "<<endl<<endl;
-			outlog<<$1->getname()<<$2->getname()<<$3->getname()<<endl<<endl;
+	    	RULE_LOG<<"At line no: "<<ctx->lines<<" simple_expression : simple_expression ADDOP term "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			$$ = new symbol_info($1->getname()+$2->getname()+$3->getname(),"simp_expr");
+			$$ = compile_arena.make<symbol_info>(0,SYM_SIMP_EXPR);
 			$$->setvartype($1->getvartype());
 			
 			//do type checking of both side of addop
 			
-			if($1->getvartype() == "void" || $3->getvartype() == "void") //if any of them is a void
+			if($1->getvartype() == TYPE_VOID || $3->getvartype() == TYPE_VOID) //if any of them is a void
 			{
-				outerror<<"At line no: "<<lines<<" operation on void type "<<endl<<endl;
-				outlog<<"At line no: "<<lines<<" operation on void type "<<endl<<endl;
-				errors++;
+				ctx->outerror<<"At line no: "<<ctx->lines<<" operation on void type "<<endl<<endl;
+				ERROR_LOG<<"At line no: "<<ctx->lines<<" operation on void type "<<endl<<endl;
+				ctx->errors++;
 				
-				$$->setvartype("error");
+				$$->setvartype(TYPE_ERROR);
 			}
-			else if($1->getvartype() == "float" || $3->getvartype() == "float") //if any of them is a float
+			else if($1->getvartype() == TYPE_FLOAT || $3->getvartype() == TYPE_FLOAT) //if any of them is a float
 			{
-				$$->setvartype("float");
+				$$->setvartype(TYPE_FLOAT);
 			}
-			else $$->setvartype("int");
+			else $$->setvartype(TYPE_INT);
 			
-			if($1->getvartype() == "error" || $3->getvartype() == "error") //if any of them is a error
+			if($1->getvartype() == TYPE_ERROR || $3->getvartype() == TYPE_ERROR) //if any of them is a error
 			{
-				$$->setvartype("error");
+				$$->setvartype(TYPE_ERROR);
 			}
 			
 			// Create AST node for addition/subtraction
-			BinaryOpNode* addopNode = new BinaryOpNode(
-				$2->getname(),
+			BinaryOpNode* addopNode = compile_arena.make<BinaryOpNode>(
+				$2.op,
 				(ExprNode*)$1->get_ast_node(),
 				(ExprNode*)$3->get_ast_node(),
 				$$->getvartype()
@@ -948,81 +1016,81 @@ simple_expression : term //simp_expr can be void
 					
 term :	unary_expression //term can be void because of un_expr->factor
      {
-	    	outlog<<"At line no: "<<lines<<" term : unary_expression "<<endl<<endl;
-			outlog<<$1->getname()<<endl<<endl;
+	    	RULE_LOG<<"At line no: "<<ctx->lines<<" term : unary_expression "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			$$ = new symbol_info($1->getname(),"term");
+			$$ = compile_arena.make<symbol_info>(0,SYM_TERM);
 			$$->setvartype($1->getvartype());
 			$$->set_ast_node($1->get_ast_node());
 			
 	 }
      |  term MULOP unary_expression
      {
-	    	outlog<<"At line no: "<<lines<<" term : term MULOP unary_expression "<<endl<<endl;
-			outlog<<$1->getname()<<$2->getname()<<$3->getname()<<endl<<endl;
+	    	RULE_LOG<<"At line no: "<<ctx->lines<<" term : term MULOP unary_expression "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			$$ = new symbol_info($1->getname()+$2->getname()+$3->getname(),"term");
+			$$ = compile_arena.make<symbol_info>(0,SYM_TERM);
 			$$->setvartype($1->getvartype());
 			
 			//do type checking of both side of mulop
-			if($1->getvartype() == "void" || $3->getvartype() == "void") //if any of them is a void
+			if($1->getvartype() == TYPE_VOID || $3->getvartype() == TYPE_VOID) //if any of them is a void
 			{
-				outerror<<"At line no: "<<lines<<" operation on void type "<<endl<<endl;
-				outlog<<"At line no: "<<lines<<" operation on void type "<<endl<<endl;
-				errors++;
+				ctx->outerror<<"At line no: "<<ctx->lines<<" operation on void type "<<endl<<endl;
+				ERROR_LOG<<"At line no: "<<ctx->lines<<" operation on void type "<<endl<<endl;
+				ctx->errors++;
 				
-				$$->setvartype("error");
+				$$->setvartype(TYPE_ERROR);
 			}
-			else if($1->getvartype() == "float" || $3->getvartype() == "float") //if any of them is a float
+			else if($1->getvartype() == TYPE_FLOAT || $3->getvartype() == TYPE_FLOAT) //if any of them is a float
 			{
-				$$->setvartype("float");
+				$$->setvartype(TYPE_FLOAT);
 			}
-			else $$->setvartype("int");
+			else $$->setvartype(TYPE_INT);
 			
 			//check if both int for modulous
-			if($2->getname() == "%")
+			if($2.op == TAC_MOD)
 			{
-				if($1->getvartype() == "int" && $3->getvartype() == "int")
+				if($1->getvartype() == TYPE_INT && $3->getvartype() == TYPE_INT)
 				{
-					if($3->getname()=="0")
+					if(ctx->span_text(@3)=="0")
 					{
-						outerror<<"At line no: "<<lines<<" Modulus by 0 "<<endl<<endl;
-						outlog<<"At line no: "<<lines<<" Modulus by 0 "<<endl<<endl;
-						errors++;
+						ctx->outerror<<"At line no: "<<ctx->lines<<" Modulus by 0 "<<endl<<endl;
+						ERROR_LOG<<"At line no: "<<ctx->lines<<" Modulus by 0 "<<endl<<endl;
+						ctx->errors++;
 						
-						$$->setvartype("error");
+						$$->setvartype(TYPE_ERROR);
 					}
-					else $$->setvartype("int");
+					else $$->setvartype(TYPE_INT);
 				}
-				else if($1->getvartype() == "float" || $3->getvartype() == "float")
+				else if($1->getvartype() == TYPE_FLOAT || $3->getvartype() == TYPE_FLOAT)
 				{
-					outerror<<"At line no: "<<lines<<" Modulus operator on non integer type "<<endl<<endl;
-					outlog<<"At line no: "<<lines<<" Modulus operator on non integer type "<<endl<<endl;
-					errors++;
+					ctx->outerror<<"At line no: "<<ctx->lines<<" Modulus operator on non integer type "<<endl<<endl;
+					ERROR_LOG<<"At line no: "<<ctx->lines<<" Modulus operator on non integer type "<<endl<<endl;
+					ctx->errors++;
 					
-					$$->setvartype("error");
+					$$->setvartype(TYPE_ERROR);
 				}
 			}
 			
-			if($2->getname() == "/") //divide by 0
+			if($2.op == TAC_DIV) //divide by 0
 			{
-				if($3->getname()=="0")
+				if(ctx->span_text(@3)=="0")
 				{
-					outerror<<"At line no: "<<lines<<" Divide by 0 "<<endl<<endl;
-					outlog<<"At line no: "<<lines<<" Divide by 0 "<<endl<<endl;
-					errors++;
+					ctx->outerror<<"At line no: "<<ctx->lines<<" Divide by 0 "<<endl<<endl;
+					ERROR_LOG<<"At line no: "<<ctx->lines<<" Divide by 0 "<<endl<<endl;
+					ctx->errors++;
 					
-					$$->setvartype("error");
+					$$->setvartype(TYPE_ERROR);
 				}
 			}
-			if($1->getvartype() == "error" || $3->getvartype() == "error") //if any of them is a error
+			if($1->getvartype() == TYPE_ERROR || $3->getvartype() == TYPE_ERROR) //if any of them is a error
 			{
-				$$->setvartype("error");
+				$$->setvartype(TYPE_ERROR);
 			}
 			
 			// Create AST node for multiplication/division/modulus
-			BinaryOpNode* mulopNode = new BinaryOpNode(
-				$2->getname(),
+			BinaryOpNode* mulopNode = compile_arena.make<BinaryOpNode>(
+				$2.op,
 				(ExprNode*)$1->get_ast_node(),
 				(ExprNode*)$3->get_ast_node(),
 				$$->getvartype()
@@ -1033,24 +1101,24 @@ term :	unary_expression //term can be void because of un_expr->factor
 
 unary_expression : ADDOP unary_expression  // un_expr can be void because of factor
 		 {
-	    	outlog<<"At line no: "<<lines<<" unary_expression : ADDOP unary_expression "<<endl<<endl;
-			outlog<<$1->getname()<<$2->getname()<<endl<<endl;
+	    	RULE_LOG<<"At line no: "<<ctx->lines<<" unary_expression : ADDOP unary_expression "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			$$ = new symbol_info($1->getname()+$2->getname(),"un_expr");
+			$$ = compile_arena.make<symbol_info>(0,SYM_UN_EXPR);
 			$$->setvartype($2->getvartype());
 			
-			if($2->getvartype()=="void")
+			if($2->getvartype() == TYPE_VOID)
 			{
-				outerror<<"At line no: "<<lines<<" operation on void type : "<<$2->getname()<<endl<<endl;
-				outlog<<"At line no: "<<lines<<" operation on void type : "<<$2->getname()<<endl<<endl;
-				errors++;
+				ctx->outerror<<"At line no: "<<ctx->lines<<" operation on void type : "<<ctx->span_text(@2)<<endl<<endl;
+				ERROR_LOG<<"At line no: "<<ctx->lines<<" operation on void type : "<<ctx->span_text(@2)<<endl<<endl;
+				ctx->errors++;
 				
-				$$->setvartype("error");
+				$$->setvartype(TYPE_ERROR);
 			}
 			
 			// Create AST node for unary plus/minus
-			UnaryOpNode* unaryNode = new UnaryOpNode(
-				$1->getname(),
+			UnaryOpNode* unaryNode = compile_arena.make<UnaryOpNode>(
+				$1.op == TAC_SUB ? TAC_NEG : TAC_COPY, // unary + is a copy
 				(ExprNode*)$2->get_ast_node(),
 				$$->getvartype()
 			);
@@ -1058,24 +1126,24 @@ unary_expression : ADDOP unary_expression  // un_expr can be void because of fac
 	     }
 		 | NOT unary_expression 
 		 {
-	    	outlog<<"At line no: "<<lines<<" unary_expression : NOT unary_expression "<<endl<<endl;
-			outlog<<"!"<<$2->getname()<<endl<<endl;
+	    	RULE_LOG<<"At line no: "<<ctx->lines<<" unary_expression : NOT unary_expression "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			$$ = new symbol_info("!"+$2->getname(),"un_expr");
-			$$->setvartype("int");
+			$$ = compile_arena.make<symbol_info>(0,SYM_UN_EXPR);
+			$$->setvartype(TYPE_INT);
 			
-			if($2->getvartype()=="void")
+			if($2->getvartype() == TYPE_VOID)
 			{
-				outerror<<"At line no: "<<lines<<" operation on void type : "<<$2->getname()<<endl<<endl;
-				outlog<<"At line no: "<<lines<<" operation on void type : "<<$2->getname()<<endl<<endl;
-				errors++;
+				ctx->outerror<<"At line no: "<<ctx->lines<<" operation on void type : "<<ctx->span_text(@2)<<endl<<endl;
+				ERROR_LOG<<"At line no: "<<ctx->lines<<" operation on void type : "<<ctx->span_text(@2)<<endl<<endl;
+				ctx->errors++;
 				
-				$$->setvartype("error");
+				$$->setvartype(TYPE_ERROR);
 			}
 			
 			// Create AST node for logical NOT
-			UnaryOpNode* notNode = new UnaryOpNode(
-				"!",
+			UnaryOpNode* notNode = compile_arena.make<UnaryOpNode>(
+				TAC_NOT,
 				(ExprNode*)$2->get_ast_node(),
 				$$->getvartype()
 			);
@@ -1083,10 +1151,10 @@ unary_expression : ADDOP unary_expression  // un_expr can be void because of fac
 	     }
 		 | factor 
 		 {
-	    	outlog<<"At line no: "<<lines<<" unary_expression : factor "<<endl<<endl;
-			outlog<<$1->getname()<<endl<<endl;
+	    	RULE_LOG<<"At line no: "<<ctx->lines<<" unary_expression : factor "<<endl<<endl;
+			RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-			$$ = new symbol_info($1->getname(),"un_expr");
+			$$ = compile_arena.make<symbol_info>(0,SYM_UN_EXPR);
 			$$->setvartype($1->getvartype());
 			$$->set_ast_node($1->get_ast_node());
 			
@@ -1096,71 +1164,73 @@ unary_expression : ADDOP unary_expression  // un_expr can be void because of fac
 	
 factor	: variable  // factor can be void
     {
-	    outlog<<"At line no: "<<lines<<" factor : variable "<<endl<<endl;
-		outlog<<$1->getname()<<endl<<endl;
+	    RULE_LOG<<"At line no: "<<ctx->lines<<" factor : variable "<<endl<<endl;
+		RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-		$$ = new symbol_info($1->getname(),"fctr");
+		$$ = compile_arena.make<symbol_info>(0,SYM_FCTR);
 		$$->setvartype($1->getvartype());
 		$$->set_ast_node($1->get_ast_node());
 	}
 	| id_name LPAREN argument_list RPAREN
 	{
-	    outlog<<"At line no: "<<lines<<" factor : ID LPAREN argument_list RPAREN "<<endl<<endl;
-	    outlog<<$1->getname()<<"("<<$3->getname()<<")"<<endl<<endl;
+	    RULE_LOG<<"At line no: "<<ctx->lines<<" factor : ID LPAREN argument_list RPAREN "<<endl<<endl;
+	    RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 	
-	    $$ = new symbol_info($1->getname()+"("+$3->getname()+")","fctr");
-	    $$->setvartype("error");
+	    $$ = compile_arena.make<symbol_info>(0,SYM_FCTR);
+	    $$->setvartype(TYPE_ERROR);
 	
 	    int flag = 0;
 	
 	    // Type checking (existing code)
-	    if(symtbl->Lookup_in_table($1->getname())==NULL) //undeclared function
+	    symbol_info *func = ctx->symtbl->Lookup_in_table($1->getnameid());
+	    
+	    if(func==NULL) //undeclared function
 	    {
-	        outerror<<"At line no: "<<lines<<" Undeclared function: "<<$1->getname()<<endl<<endl;
-	        outlog<<"At line no: "<<lines<<" Undeclared function: "<<$1->getname()<<endl<<endl;
-	        errors++;
+	        ctx->outerror<<"At line no: "<<ctx->lines<<" Undeclared function: "<<$1->getname()<<endl<<endl;
+	        ERROR_LOG<<"At line no: "<<ctx->lines<<" Undeclared function: "<<$1->getname()<<endl<<endl;
+	        ctx->errors++;
 	    }
 	    else
 	    {
-	        if((symtbl->Lookup_in_table($1->getname()))->getidtype()=="func_dec") //declared but not defined
+	        if(func->getidtype() == ID_FUNC_DEC) //declared but not defined
 	        {
-	            outerror<<"At line no: "<<lines<<" Undefined function: "<<$1->getname()<<endl<<endl;
-	            outlog<<"At line no: "<<lines<<" Undefined function: "<<$1->getname()<<endl<<endl;
-	            errors++;
+	            ctx->outerror<<"At line no: "<<ctx->lines<<" Undefined function: "<<$1->getname()<<endl<<endl;
+	            ERROR_LOG<<"At line no: "<<ctx->lines<<" Undefined function: "<<$1->getname()<<endl<<endl;
+	            ctx->errors++;
 	        }
-	        else if((symtbl->Lookup_in_table($1->getname()))->getidtype()=="func_def")
+	        else if(func->getidtype() == ID_FUNC_DEF)
 	        {
-	            vector<string> templist = (symtbl->Lookup_in_table($1->getname()))->getparamlist();
+	            const vector<data_type>& templist = func->getparamlist();
 	
-	            if(arglist.size()!=templist.size()) //number of prameters don't match
+	            if(ctx->arglist.size()!=templist.size()) //number of prameters don't match
 	            {
-	                outerror<<"At line no: "<<lines<<" Inconsistencies in number of arguments in function call: "<<$1->getname()<<endl<<endl;
-	                outlog<<"At line no: "<<lines<<" Inconsistencies in number of arguments in function call: "<<$1->getname()<<endl<<endl;
-	                errors++;
+	                ctx->outerror<<"At line no: "<<ctx->lines<<" Inconsistencies in number of arguments in function call: "<<$1->getname()<<endl<<endl;
+	                ERROR_LOG<<"At line no: "<<ctx->lines<<" Inconsistencies in number of arguments in function call: "<<$1->getname()<<endl<<endl;
+	                ctx->errors++;
 	            }
 	            else if(templist.size()!=0)
 	            {
 	                for(int i = 0; i < templist.size(); i++)
 	                {
-	                    if(arglist[i]!=templist[i])
+	                    if(ctx->arglist[i]!=templist[i])
 	                    {
-	                        if(arglist[i] == "int" && templist[i] == "float") {}
-	                        else if(arglist[i]!="error")
+	                        if(ctx->arglist[i] == TYPE_INT && templist[i] == TYPE_FLOAT) {}
+	                        else if(ctx->arglist[i] != TYPE_ERROR)
 	                        {
 	                            flag = 1;
-	                            outerror<<"At line no: "<<lines<<" "<<"argument "<<i+1<<" type mismatch in function call: "<<$1->getname()<<endl<<endl;
-	                            outlog<<"At line no: "<<lines<<" "<<"argument "<<i+1<<" type mismatch in function call: "<<$1->getname()<<endl<<endl;
-	                            errors++;
+	                            ctx->outerror<<"At line no: "<<ctx->lines<<" "<<"argument "<<i+1<<" type mismatch in function call: "<<$1->getname()<<endl<<endl;
+	                            ERROR_LOG<<"At line no: "<<ctx->lines<<" "<<"argument "<<i+1<<" type mismatch in function call: "<<$1->getname()<<endl<<endl;
+	                            ctx->errors++;
 	                        }
 	                    }
 	                }                   
 	            }
-	            if(!flag) $$->setvartype((symtbl->Lookup_in_table($1->getname()))->getvartype());
+	            if(!flag) $$->setvartype(func->getvartype());
 	        }
 	    }
 	
 	    // Create function call node
-	    FuncCallNode* funcCall = new FuncCallNode($1->getname(), $$->getvartype());
+	    FuncCallNode* funcCall = compile_arena.make<FuncCallNode>($1->getnameid(), $$->getvartype());
 	
 	    // Get arguments from the ArgumentsNode if it exists
 	    if ($3->get_ast_node()) {
@@ -1175,107 +1245,107 @@ factor	: variable  // factor can be void
 	
 	    $$->set_ast_node(funcCall);
 	
-	    arglist.clear();
+	    ctx->arglist.clear();
 	}
 	| LPAREN expression RPAREN
 	{
-	   	outlog<<"At line no: "<<lines<<" factor : LPAREN expression RPAREN "<<endl<<endl;
-		outlog<<"("<<$2->getname()<<")"<<endl<<endl;
+	   	RULE_LOG<<"At line no: "<<ctx->lines<<" factor : LPAREN expression RPAREN "<<endl<<endl;
+		RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 		
-		$$ = new symbol_info("("+$2->getname()+")","fctr");
+		$$ = compile_arena.make<symbol_info>(0,SYM_FCTR);
 		$$->setvartype($2->getvartype());
 		$$->set_ast_node($2->get_ast_node()); // Pass through the expression AST
 	}
 	| CONST_INT 
 	{
-	    outlog<<"At line no: "<<lines<<" factor : CONST_INT "<<endl<<endl;
-		outlog<<$1->getname()<<endl<<endl;
+	    RULE_LOG<<"At line no: "<<ctx->lines<<" factor : CONST_INT "<<endl<<endl;
+		RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-		$$ = new symbol_info($1->getname(),"fctr");
-		$$->setvartype("int");
+		$$ = compile_arena.make<symbol_info>(0,SYM_FCTR);
+		$$->setvartype(TYPE_INT);
 		
 		// Create AST node for integer constant
-		ConstNode* intNode = new ConstNode($1->getname(), "int");
+		ConstNode* intNode = compile_arena.make<ConstNode>($1.int_value);
 		$$->set_ast_node(intNode);
 	}
 	| CONST_FLOAT
 	{
-	    outlog<<"At line no: "<<lines<<" factor : CONST_FLOAT "<<endl<<endl;
-		outlog<<$1->getname()<<endl<<endl;
+	    RULE_LOG<<"At line no: "<<ctx->lines<<" factor : CONST_FLOAT "<<endl<<endl;
+		RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-		$$ = new symbol_info($1->getname(),"fctr");
-		$$->setvartype("float");
+		$$ = compile_arena.make<symbol_info>(0,SYM_FCTR);
+		$$->setvartype(TYPE_FLOAT);
 		
 		// Create AST node for float constant
-		ConstNode* floatNode = new ConstNode($1->getname(), "float");
+		ConstNode* floatNode = compile_arena.make<ConstNode>($1.float_value);
 		$$->set_ast_node(floatNode);
 	}
 	| variable INCOP 
 	{
-	    outlog<<"At line no: "<<lines<<" factor : variable INCOP "<<endl<<endl;
-		outlog<<$1->getname()<<"++"<<endl<<endl;
+	    RULE_LOG<<"At line no: "<<ctx->lines<<" factor : variable INCOP "<<endl<<endl;
+		RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-		$$ = new symbol_info($1->getname()+"++","fctr");
+		$$ = compile_arena.make<symbol_info>(0,SYM_FCTR);
 		$$->setvartype($1->getvartype());
 		
 		// Create AST nodes for increment
 		// For x++, equivalent to (x = x + 1)
 		VarNode* varNode = (VarNode*)$1->get_ast_node();
-		ConstNode* oneNode = new ConstNode("1", "int");
-		BinaryOpNode* addNode = new BinaryOpNode("+", varNode, oneNode, $1->getvartype());
-		AssignNode* assignNode = new AssignNode(varNode, addNode, $1->getvartype());
+		ConstNode* oneNode = compile_arena.make<ConstNode>(1);
+		BinaryOpNode* addNode = compile_arena.make<BinaryOpNode>(TAC_ADD, varNode, oneNode, $1->getvartype());
+		AssignNode* assignNode = compile_arena.make<AssignNode>(varNode, addNode, $1->getvartype());
 		$$->set_ast_node(assignNode);
 	}
 	| variable DECOP
 	{
-	    outlog<<"At line no: "<<lines<<" factor : variable DECOP "<<endl<<endl;
-		outlog<<$1->getname()<<"--"<<endl<<endl;
+	    RULE_LOG<<"At line no: "<<ctx->lines<<" factor : variable DECOP "<<endl<<endl;
+		RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
 			
-		$$ = new symbol_info($1->getname()+"--","fctr");
+		$$ = compile_arena.make<symbol_info>(0,SYM_FCTR);
 		$$->setvartype($1->getvartype());
 		
 		// Create AST nodes for decrement
 		// For x--, equivalent to (x = x - 1)
 		VarNode* varNode = (VarNode*)$1->get_ast_node();
-		ConstNode* oneNode = new ConstNode("1", "int");
-		BinaryOpNode* subNode = new BinaryOpNode("-", varNode, oneNode, $1->getvartype());
-		AssignNode* assignNode = new AssignNode(varNode, subNode, $1->getvartype());
+		ConstNode* oneNode = compile_arena.make<ConstNode>(1);
+		BinaryOpNode* subNode = compile_arena.make<BinaryOpNode>(TAC_SUB, varNode, oneNode, $1->getvartype());
+		AssignNode* assignNode = compile_arena.make<AssignNode>(varNode, subNode, $1->getvartype());
 		$$->set_ast_node(assignNode);
 	}
 	;
 	
 argument_list : arguments
               {
-                    outlog<<"At line no: "<<lines<<" argument_list : arguments "<<endl<<endl;
-                    outlog<<$1->getname()<<endl<<endl;
+                    RULE_LOG<<"At line no: "<<ctx->lines<<" argument_list : arguments "<<endl<<endl;
+                    RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
                         
                     $$ = $1; // Pass through the arguments node
               }
               |
               {
-                    outlog<<"At line no: "<<lines<<" argument_list :  "<<endl<<endl;
-                    outlog<<""<<endl<<endl;
+                    RULE_LOG<<"At line no: "<<ctx->lines<<" argument_list :  "<<endl<<endl;
+                    RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
                         
-                    $$ = new symbol_info("","arg_list");
+                    $$ = compile_arena.make<symbol_info>(0,SYM_ARG_LIST);
                     // Create empty arguments node
-                    ArgumentsNode* args = new ArgumentsNode();
+                    ArgumentsNode* args = compile_arena.make<ArgumentsNode>();
                     $$->set_ast_node(args);
               }
               ;
     
 arguments : arguments COMMA logic_expression
           {
-                outlog<<"At line no: "<<lines<<" arguments : arguments COMMA logic_expression "<<endl<<endl;
-                outlog<<$1->getname()<<","<<$3->getname()<<endl<<endl;
+                RULE_LOG<<"At line no: "<<ctx->lines<<" arguments : arguments COMMA logic_expression "<<endl<<endl;
+                RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
                         
-                $$ = new symbol_info($1->getname()+","+$3->getname(),"arg");
+                $$ = compile_arena.make<symbol_info>(0,SYM_ARG);
                 
                 // Get existing arguments node or create new one
                 ArgumentsNode* args;
                 if ($1->get_ast_node()) {
                     args = dynamic_cast<ArgumentsNode*>($1->get_ast_node());
                 } else {
-                    args = new ArgumentsNode();
+                    args = compile_arena.make<ArgumentsNode>();
                 }
                 
                 // Add the new argument
@@ -1284,85 +1354,377 @@ arguments : arguments COMMA logic_expression
                 }
                 
                 $$->set_ast_node(args);
-                arglist.push_back($3->getvartype());
+                ctx->arglist.push_back($3->getvartype());
           }
           | logic_expression
           {
-                outlog<<"At line no: "<<lines<<" arguments : logic_expression "<<endl<<endl;
-                outlog<<$1->getname()<<endl<<endl;
+                RULE_LOG<<"At line no: "<<ctx->lines<<" arguments : logic_expression "<<endl<<endl;
+                RULE_LOG<<ctx->span_text(@$)<<endl<<endl;
                         
-                $$ = new symbol_info($1->getname(),"arg");
+                $$ = compile_arena.make<symbol_info>(0,SYM_ARG);
                 
                 // Create a new arguments node with single argument
-                ArgumentsNode* args = new ArgumentsNode();
+                ArgumentsNode* args = compile_arena.make<ArgumentsNode>();
                 if ($1->get_ast_node()) {  // FIXED: Changed from $3 to $1
                     args->add_argument(dynamic_cast<ExprNode*>($1->get_ast_node()));
                 }
                 
                 $$->set_ast_node(args);
-                arglist.push_back($1->getvartype());
+                ctx->arglist.push_back($1->getvartype());
           }
           ;
  
 
 %%
 
-int main(int argc, char *argv[])
+void yyerror(YYLTYPE *loc, compile_context *ctx, yyscan_t scanner, const char *s)
 {
-	if(argc != 2) 
-	{
-		cout<<"Please input file name"<<endl;
-		return 0;
-	}
-	yyin = fopen(argv[1], "r");
-	outlog.open("log.txt", ios::trunc);
-	outerror.open("error.txt", ios::trunc);
-	outcode.open("code.txt", ios::trunc);
+	ERROR_LOG<<"At line "<<ctx->lines<<" "<<s<<endl<<endl;
+	ctx->outerror<<"At line "<<ctx->lines<<" "<<s<<endl<<endl;
+	ctx->errors++;
+	ctx->reset_declaration_state();
+}
 
-	if(yyin == NULL)
+/* Reentrant scanner interface, generated by flex */
+struct yy_buffer_state;
+int yylex_init_extra(compile_context *extra, yyscan_t *scanner);
+int yylex_destroy(yyscan_t scanner);
+yy_buffer_state *yy_scan_bytes(const char *bytes, int len, yyscan_t scanner);
+void yy_delete_buffer(yy_buffer_state *buffer, yyscan_t scanner);
+
+// Compiles ctx->input to the output files of ctx, telling what it did on ctx->console.
+// Runs on the calling thread and touches no state but ctx and that thread's interner and arena.
+void compile(compile_context *ctx)
+{
+	FILE *in = fopen(ctx->input.c_str(), "r");
+	if(in == NULL)
 	{
-		cout<<"Couldn't open file"<<endl;
-		return 0;
+		ctx->console<<"Couldn't open file"<<endl;
+		ctx->errors++;
+		return;
 	}
 	
+	// Keep the input in memory so grammar symbols can be logged from their spans; the scanner reads the same copy
+	char buf[1<<16];
+	size_t n;
+	while((n = fread(buf, 1, sizeof(buf), in)) > 0) ctx->source_text.append(buf, n);
+	fclose(in);
+	
+	ctx->outlog.set_level(ctx->options.level);
+	ctx->outlog.open(ctx->output_name("log.txt").c_str());
+	ctx->outerror.open(ctx->output_name("error.txt").c_str());
+	if(ctx->options.emit_text) ctx->outcode.open(ctx->output_name("code.txt"), ios::trunc);
+	if(ctx->options.emit_binary) ctx->outbin.open(ctx->output_name("code.tac"), ios::trunc | ios::binary);
+	if(ctx->options.emit_asm) ctx->outasm.open(ctx->output_name("code.s"), ios::trunc);
+	if(ctx->options.emit_c) ctx->outc.open(ctx->output_name("code.c"), ios::trunc);
+	
 	// First pass: Parse the input and build AST
-	cout << "==== Pass 1: Parsing input and building AST ====" << endl;
-	outlog << "==== Pass 1: Parsing input and building AST ====" << endl;
+	ctx->console << "==== Pass 1: Parsing input and building AST ====" << endl;
+	RULE_LOG << "==== Pass 1: Parsing input and building AST ====" << endl;
 	
-	symtbl->enter_scope(outlog);
-	yyparse();
+	// With --stream, code is generated during the parse (see stream_unit), otherwise from the whole AST after it
+	unique_ptr<tac_cache> cache;
+	if(!ctx->options.cache_dir.empty()) cache = make_unique<tac_cache>(ctx->options.cache_dir);
+	unique_ptr<ThreeAddrCodeGenerator> generator;
+	if(ctx->options.stream)
+	{
+		generator = make_unique<ThreeAddrCodeGenerator>(ctx->ast_root, ctx->outcode, ctx->options.opt_level);
+		generator->use_cache(cache.get());
+		generator->begin_stream(ctx->options.emit_binary || ctx->options.emit_asm || ctx->options.emit_c);
+		ctx->streamer = generator.get();
+		ctx->unit_mark = compile_arena.mark();
+	}
 	
-	outlog << endl << "Symbol Table after first pass:" << endl;
-	symtbl->Print_all_scope(outlog);
+	ctx->symtbl->enter_scope(ctx->outlog);
+	yyscan_t scanner;
+	yylex_init_extra(ctx, &scanner);
+	yy_buffer_state *input_buffer = yy_scan_bytes(ctx->source_text.data(), ctx->source_text.size(), scanner);
+	yyparse(ctx, scanner);
+	yy_delete_buffer(input_buffer, scanner);
+	yylex_destroy(scanner);
+	
+	FULL_LOG << endl << "Symbol Table after first pass:" << endl;
+	ctx->symtbl->Print_all_scope(ctx->outlog);
 	
 	// Only proceed to second pass if no errors
-	if (errors == 0 && ast_root) {
-		cout << "==== Pass 2: Generating Three-Address Code from AST ====" << endl;
-		outlog << endl << "==== Pass 2: Generating Three-Address Code from AST ====" << endl;
+	if (ctx->errors == 0 && ctx->ast_root) {
+		ctx->console << "==== Pass 2: Generating Three-Address Code from AST ====" << endl;
+		RULE_LOG << endl << "==== Pass 2: Generating Three-Address Code from AST ====" << endl;
 		
 		// Generate three-address code (second pass)
-		outlog << "Generating Three-Address Code..." << endl;
-		ThreeAddrCodeGenerator tacGen(ast_root, outcode);
-		tacGen.generate();
+		RULE_LOG << "Generating Three-Address Code..." << endl;
+		if(ctx->options.opt_level >= 1)
+		{
+			int folded = ctx->folded; //units already streamed were folded on their own
+			ctx->ast_root->fold(folded);
+			ctx->console << "Constant folding removed " << folded << " AST nodes" << endl;
+			RULE_LOG << "Constant folding removed " << folded << " AST nodes" << endl;
+		}
 		
-		outlog << "Three-Address Code Generation Complete" << endl;
-		cout << "Three-Address Code Generation Complete. Output written to code.txt" << endl;
+		if(generator) generator->end_stream(ctx->global_slots);
+		else
+		{
+			generator = make_unique<ThreeAddrCodeGenerator>(ctx->ast_root, ctx->outcode, ctx->options.opt_level, ctx->options.codegen_jobs);
+			generator->use_cache(cache.get());
+		}
+		ThreeAddrCodeGenerator& tacGen = *generator;
+		if(ctx->options.emit_text) tacGen.generate();
+		if(ctx->options.emit_binary) tacGen.generate_binary(ctx->outbin);
+		string asm_error;
+		if(ctx->options.emit_asm && !tacGen.generate_asm(ctx->outasm, asm_error))
+		{
+			ctx->console << "x86-64 code generation failed: " << asm_error << endl;
+			ERROR_LOG << "x86-64 code generation failed: " << asm_error << endl;
+		}
+		string c_error;
+		if(ctx->options.emit_c && !tacGen.generate_c(ctx->outc, c_error))
+		{
+			ctx->console << "C code generation failed: " << c_error << endl;
+			ERROR_LOG << "C code generation failed: " << c_error << endl;
+		}
+		// wall time goes to the console only, so the log stays the same from run to run
+		ctx->console << "Code generation and optimization: " << tacGen.get_build_ms() << " ms on "
+		             << tacGen.get_jobs() << (tacGen.get_jobs() == 1 ? " thread" : " threads") << endl;
+		if(cache)
+		{
+			const tac_cache_stats& cs = cache->get_stats();
+			ctx->console << "Function cache: " << cs.hits << " hits, " << cs.misses << " misses, " << cs.stored << " stored" << endl;
+		}
+		
+		const tac_opt_stats& stats = tacGen.get_stats();
+		if(ctx->options.opt_level >= 1)
+		{
+			ctx->console << "TAC optimization: " << stats.instructions_before << " -> " << stats.instructions_after << " instructions" << endl;
+			RULE_LOG << "TAC optimization: " << stats.instructions_before << " -> " << stats.instructions_after << " instructions" << endl;
+			ctx->console << "Value numbering reused " << stats.values_reused << " computed values" << endl;
+			RULE_LOG << "Value numbering reused " << stats.values_reused << " computed values" << endl;
+			ctx->console << "Jumps and branches: " << stats.jumps_before << " -> " << stats.jumps_after << endl;
+			RULE_LOG << "Jumps and branches: " << stats.jumps_before << " -> " << stats.jumps_after << endl;
+			
+			int temps_before = 0, peak_live = 0;
+			for(const tac_temp_stats& t : stats.temps)
+			{
+				temps_before += t.temps_before;
+				peak_live = max(peak_live, t.peak_live);
+				RULE_LOG << "Function " << names.str(tacGen.get_program().functions[t.function].name) << ": "
+				         << t.temps_before << " temps, peak live " << t.peak_live << endl;
+			}
+			ctx->console << "Temps: " << temps_before << " before renumbering, peak live in one function " << peak_live << endl;
+			
+			int hoisted = 0, loops_hoisted_from = 0, reduced = 0, tests_replaced = 0;
+			for(const tac_loop_stats& l : stats.loops)
+			{
+				hoisted += l.hoisted;
+				loops_hoisted_from += l.hoisted > 0;
+				reduced += l.reduced;
+				tests_replaced += l.tests_replaced;
+				RULE_LOG << "Function " << names.str(tacGen.get_program().functions[l.function].name) << ": loop at L" << l.header
+				         << ", depth " << l.depth << ", " << l.blocks << " blocks, hoisted " << l.hoisted
+				         << ", strength-reduced " << l.reduced << ", tests replaced " << l.tests_replaced << endl;
+			}
+			ctx->console << "Loop-invariant code motion: " << hoisted << " computations hoisted out of " << loops_hoisted_from
+			     << " of " << stats.loops.size() << " loops" << endl;
+			ctx->console << "Induction variables: " << reduced << " multiplies strength-reduced, " << tests_replaced << " loop tests replaced" << endl;
+		}
+		
+		RULE_LOG << "Three-Address Code Generation Complete" << endl;
+		if(ctx->options.emit_asm)
+		{
+			const x86_stats& x86 = tacGen.get_asm_stats();
+			ctx->console << "x86-64 registers: " << x86.in_registers << " of " << x86.values << " values, "
+			     << x86.spilled << " on the stack" << endl;
+			RULE_LOG << "x86-64 registers: " << x86.in_registers << " of " << x86.values << " values, "
+			         << x86.spilled << " on the stack" << endl;
+		}
+		
+		vector<string> written;
+		if(ctx->options.emit_text) written.push_back(ctx->output_name("code.txt"));
+		if(ctx->options.emit_binary) written.push_back(ctx->output_name("code.tac"));
+		if(ctx->options.emit_asm) written.push_back(ctx->output_name("code.s"));
+		if(ctx->options.emit_c) written.push_back(ctx->output_name("code.c"));
+		ctx->console << "Three-Address Code Generation Complete. Output written to ";
+		for(size_t i = 0; i < written.size(); i++)
+			ctx->console << (i == 0 ? "" : i + 1 == written.size() ? " and " : ", ") << written[i];
+		ctx->console << endl;
 	} else {
-		cout << "Three-Address Code generation skipped due to errors" << endl;
-		outlog << endl << "Three-Address Code generation skipped due to errors" << endl;
-		outcode << "// Three-Address Code generation failed due to errors" << endl;
+		ctx->console << "Three-Address Code generation skipped due to errors" << endl;
+		ERROR_LOG << endl << "Three-Address Code generation skipped due to errors" << endl;
+		if(ctx->streamer && ctx->options.emit_text) //drop the units streamed before the first error
+		{
+			ctx->outcode.close();
+			ctx->outcode.open(ctx->output_name("code.txt"), ios::trunc);
+		}
+		ctx->outcode << "// Three-Address Code generation failed due to errors" << endl;
 	}
 	
-	outlog<<endl<<"Total lines: "<<lines<<endl;
-	outlog<<"Total errors: "<<errors<<endl;
-	outerror<<"Total errors: "<<errors<<endl;
+	ERROR_LOG<<endl<<"Total lines: "<<ctx->lines<<endl;
+	ERROR_LOG<<"Total errors: "<<ctx->errors<<endl;
+	ERROR_LOG<<"AST and semantic value memory: "<<compile_arena.bytes_used()<<" bytes used, "<<compile_arena.bytes_reserved()<<" bytes reserved"<<endl;
+	
+	if(ctx->streamer)
+	{
+		ctx->console << "Streaming: at most " << compile_arena.bytes_peak() << " bytes of AST and semantic values at once" << endl;
+	}
 	
-	outlog.close();
-	outerror.close();
-	outcode.close();
+	ctx->ast_root = NULL;
+	ctx->streamer = NULL;
+	compile_arena.release();
+	ctx->outerror<<"Total errors: "<<ctx->errors<<endl;
+	
+	ctx->outlog.close();
+	ctx->outerror.close();
+	ctx->outcode.close();
+	ctx->outbin.close();
+	ctx->outasm.close();
+	ctx->outc.close();
+}
+
+// Compiles one file on the calling thread and returns what it reported
+string compile_file(const string& input, const string& output_prefix, const compile_options& options, int& errors)
+{
+	names = string_interner(); //ids are only meaningful within one compilation
+	compile_context ctx(input, output_prefix, options);
+	compile(&ctx);
+	errors = ctx.errors;
+	return ctx.console.str();
+}
 
+int main(int argc, char *argv[])
+{
+	// two_pass_compiler [--log=off|errors|rules|full] [--emit=text|binary|both|asm|c[,...]] [--opt=0|1] [--jobs=N]
+	//                   [--cache=DIR [--cache-size=MB]] [--stream] file...
+	// logs everything and emits text by default. With several files, each one's outputs are
+	// named after it (dir/name.c gives dir/name.log.txt, dir/name.code.txt, ...) and the files
+	// are compiled on N threads, one per core by default. A single file uses the N threads to
+	// generate and optimize its functions. --cache keeps the code of every function in DIR and
+	// reuses it while the function and what it refers to are unchanged; once done, the least
+	// recently used entries are deleted down to --cache-size (256 MB by default). --stream
+	// generates each function as soon as it is parsed and frees it, on one thread.
+	compile_options options;
+	int jobs = max(1u, thread::hardware_concurrency());
+	vector<string> inputs;
+	for(int i = 1; i < argc; i++)
+	{
+		string_view arg = argv[i];
+		if(arg.substr(0, 6) == "--log=")
+		{
+			if(!parse_log_level(arg.substr(6), options.level))
+			{
+				cout<<"Unknown log level "<<arg.substr(6)<<", expected off, errors, rules or full"<<endl;
+				return 0;
+			}
+		}
+		else if(arg.substr(0, 7) == "--emit=")
+		{
+			// a comma-separated list of outputs
+			options.emit_text = options.emit_binary = options.emit_asm = options.emit_c = false;
+			string_view list = arg.substr(7);
+			while(!list.empty())
+			{
+				size_t comma = list.find(',');
+				string_view emit = list.substr(0, comma);
+				list = comma == string_view::npos ? string_view() : list.substr(comma + 1);
+				if(emit != "text" && emit != "binary" && emit != "both" && emit != "asm" && emit != "c")
+				{
+					cout<<"Unknown output format "<<emit<<", expected text, binary, both, asm or c"<<endl;
+					return 0;
+				}
+				options.emit_text |= emit == "text" || emit == "both";
+				options.emit_binary |= emit == "binary" || emit == "both";
+				options.emit_asm |= emit == "asm";
+				options.emit_c |= emit == "c";
+			}
+		}
+		else if(arg.substr(0, 6) == "--opt=")
+		{
+			string_view opt = arg.substr(6);
+			if(opt != "0" && opt != "1")
+			{
+				cout<<"Unknown optimization level "<<opt<<", expected 0 or 1"<<endl;
+				return 0;
+			}
+			options.opt_level = opt[0] - '0';
+		}
+		else if(arg.substr(0, 7) == "--jobs=")
+		{
+			jobs = atoi(argv[i] + 7);
+			if(jobs < 1)
+			{
+				cout<<"Unknown job count "<<arg.substr(7)<<", expected a positive number"<<endl;
+				return 0;
+			}
+		}
+		else if(arg.substr(0, 8) == "--cache=")
+		{
+			options.cache_dir = string(arg.substr(8));
+		}
+		else if(arg.substr(0, 13) == "--cache-size=")
+		{
+			long long mb = atoll(argv[i] + 13);
+			if(mb < 1)
+			{
+				cout<<"Unknown cache size "<<arg.substr(13)<<", expected a positive number of megabytes"<<endl;
+				return 0;
+			}
+			options.cache_bytes = (uintmax_t)mb << 20;
+		}
+		else if(arg == "--stream")
+		{
+			options.stream = true;
+		}
+		else inputs.push_back(argv[i]);
+	}
+	if(inputs.empty()) 
+	{
+		cout<<"Please input file name"<<endl;
+		return 0;
+	}
 	
-	fclose(yyin);
+	// A single file keeps the plain output names
+	auto output_prefix = [&](const string& input) {
+		if(inputs.size() == 1) return string();
+		size_t dot = input.rfind('.');
+		size_t slash = input.rfind('/');
+		if(dot == string::npos || (slash != string::npos && dot < slash)) dot = input.size();
+		return input.substr(0, dot) + ".";
+	};
+	
+	// Workers take the next file until none is left; each report is printed whole as its file finishes
+	auto start = chrono::steady_clock::now();
+	atomic<size_t> next_input(0);
+	atomic<int> failed(0);
+	mutex console_lock;
+	auto worker = [&]() {
+		for(size_t i; (i = next_input++) < inputs.size(); )
+		{
+			int errors = 0;
+			string report = compile_file(inputs[i], output_prefix(inputs[i]), options, errors);
+			if(errors) failed++;
+			lock_guard<mutex> guard(console_lock);
+			if(inputs.size() > 1) cout << "==== " << inputs[i] << " ====" << endl;
+			cout << report << flush;
+		}
+	};
+	// One file spends the threads on its functions; several files are spread over them instead
+	if(inputs.size() == 1) options.codegen_jobs = jobs;
+	jobs = min<size_t>(jobs, inputs.size());
+	vector<thread> pool;
+	for(int j = 1; j < jobs; j++) pool.emplace_back(worker);
+	worker();
+	for(thread& t : pool) t.join();
+	
+	if(inputs.size() > 1)
+	{
+		double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+		cout << "Compiled " << inputs.size() << " files, " << failed << " with errors, in " << ms << " ms on " << jobs << " threads" << endl;
+	}
+	if(!options.cache_dir.empty())
+	{
+		tac_cache_trim trim = tac_cache::trim(options.cache_dir, options.cache_bytes);
+		cout << "Function cache: " << trim.entries << " entries, " << (trim.bytes + 1023) / 1024 << " KB";
+		if(trim.removed) cout << ", " << trim.removed << " least recently used removed";
+		cout << endl;
+	}
 	
 	return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,136 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Bump allocator for one compilation.
+// Owns every AST node and parser semantic value; nothing is freed one by one,
+// release() runs the pending destructors and drops all blocks in one step.
+// rewind() does the same for everything allocated since a mark(), which lets a
+// streaming compilation drop each unit once its code is out.
+class arena {
+    private:
+        struct dtor_entry {
+            void (*destroy)(void*);
+            void* obj;
+        };
+
+        vector<pair<char*, size_t>> blocks; // start, size
+        vector<dtor_entry> dtors;
+        char* cur;
+        size_t left;
+        size_t block_size;
+        size_t used;
+        size_t reserved; // sum of the sizes in blocks
+        size_t peak; // most bytes ever used at once
+        char* spare; // a block_size block kept by rewind() for the next grow()
+
+        template <typename T>
+        static void destroy_obj(void* p) { static_cast<T*>(p)->~T(); }
+
+        void* grow(size_t size, size_t align) {
+            // Oversized requests get a block of their own so the current block keeps its tail
+            size_t sz = size + align > block_size ? size + align : block_size;
+            char* block = sz == block_size && spare ? spare : static_cast<char*>(malloc(sz));
+            if (!block) throw bad_alloc();
+            if (block == spare) spare = nullptr;
+            blocks.push_back({block, sz});
+            reserved += sz;
+            if (sz == block_size) {
+                cur = block;
+                left = sz;
+                return allocate(size, align);
+            }
+            uintptr_t p = (reinterpret_cast<uintptr_t>(block) + align - 1) & ~(uintptr_t)(align - 1);
+            used += size;
+            return reinterpret_cast<void*>(p);
+        }
+
+    public:
+        arena(size_t block = 1 << 20)
+            : cur(nullptr), left(0), block_size(block), used(0), reserved(0), peak(0), spare(nullptr) {}
+        arena(const arena&) = delete;
+        arena& operator=(const arena&) = delete;
+        ~arena() { release(); }
+
+        void* allocate(size_t size, size_t align = alignof(max_align_t)) {
+            uintptr_t p = (reinterpret_cast<uintptr_t>(cur) + align - 1) & ~(uintptr_t)(align - 1);
+            size_t pad = p - reinterpret_cast<uintptr_t>(cur);
+            if (!cur || pad + size > left) return grow(size, align);
+            cur += pad + size;
+            left -= pad + size;
+            used += size;
+            return reinterpret_cast<void*>(p);
+        }
+
+        // Construct a T in the arena; its destructor runs at release()
+        template <typename T, typename... Args>
+        T* make(Args&&... args) {
+            T* obj = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+            if (!is_trivially_destructible<T>::value) {
+                dtors.push_back({&arena::destroy_obj<T>, obj});
+            }
+            return obj;
+        }
+
+        size_t bytes_used() const { return used; }
+        size_t bytes_reserved() const { return reserved + (spare ? block_size : 0); }
+        size_t bytes_peak() const { return max(peak, used); }
+
+        // Where the arena stands, for rewind()
+        struct position {
+            size_t blocks, dtors;
+            char* cur;
+            size_t left, used, reserved;
+        };
+
+        position mark() const { return {blocks.size(), dtors.size(), cur, left, used, reserved}; }
+
+        // Destroys and frees everything made since m was taken; the objects made before it stay
+        void rewind(const position& m) {
+            peak = bytes_peak();
+            for (size_t i = dtors.size(); i-- > m.dtors;) {
+                dtors[i].destroy(dtors[i].obj);
+            }
+            dtors.resize(m.dtors);
+            for (size_t i = m.blocks; i < blocks.size(); i++) {
+                if (blocks[i].second == block_size && !spare) spare = blocks[i].first;
+                else free(blocks[i].first);
+            }
+            blocks.resize(m.blocks);
+            cur = m.cur;
+            left = m.left;
+            used = m.used;
+            reserved = m.reserved;
+        }
+
+        void release() {
+            for (size_t i = dtors.size(); i-- > 0;) {
+                dtors[i].destroy(dtors[i].obj);
+            }
+            dtors.clear();
+            for (auto block : blocks) free(block.first);
+            blocks.clear();
+            free(spare);
+            spare = nullptr;
+            cur = nullptr;
+            left = 0;
+            used = 0;
+            reserved = 0;
+            peak = 0;
+        }
+};
+
+// Arena of the compilation running on this thread, defined by the parser
+extern thread_local arena compile_arena;
+
+#endif // ARENA_H
@@ -6,72 +6,98 @@
 #include <string>
 #include <fstream>
 #include <map>
+#include <climits>
+#include "arena.h"
+#include "types.h"
+#include "interner.h"
+#include "tac.h"
 
 
 using namespace std;
-string temp_cond;
 
+// All nodes are allocated in the compilation arena, which frees them in one step.
+// Destructors must not delete child nodes.
+// generate_code gets slot_map, which holds for each slot of the current function the operand
+// that carries the variable: the variable itself, or the temp a parameter was copied into.
+// fold simplifies constant expressions below a node before code generation. It returns the
+// node that takes this one's place and adds the number of nodes it dropped to removed.
 class ASTNode {
     public:
         virtual ~ASTNode() {}
-        virtual string generate_code(ofstream& outcode, map<string, string>& symbol_to_temp, int& temp_count, int& label_count) const = 0;
+        virtual tac_operand generate_code(tac_program& code, vector<tac_operand>& slot_map, int& temp_count, int& label_count) const = 0;
+        virtual ASTNode* fold(int& removed) { return this; }
 };
 
 
 class ExprNode : public ASTNode {
     protected:
-        string node_type; //Type information(int, float, void, etc.)
+        data_type node_type; //Type information(int, float, void, etc.)
     public:
-        ExprNode(string type) : node_type(type) {}
-        virtual string get_type() const { return node_type; }
+        ExprNode(data_type type) : node_type(type) {}
+        virtual data_type get_type() const { return node_type; }
+        ExprNode* fold(int& removed) override { return this; }
+        // True when evaluating the expression cannot assign, call a function or change state
+        virtual bool is_pure() const { return false; }
+        // Nodes in the subtree, counted when folding drops a pure subtree
+        virtual int node_count() const { return 1; }
+        // Jumps to target when the expression's truth value is jump_if and falls through otherwise.
+        // Conditions are generated this way, so that && || and ! become jumps rather than values.
+        virtual void generate_branch(tac_program& code, vector<tac_operand>& slot_map,
+                            int& temp_count, int& label_count, tac_operand target, bool jump_if) const {
+            tac_operand value = generate_code(code, slot_map, temp_count, label_count);
+            code.emit(jump_if ? TAC_IF : TAC_IFFALSE, TYPE_NONE, target, value);
+        }
 };
 
 // VarNode class modification 
 class VarNode : public ExprNode {
     private:
-        string name;
+        int name; // interned
+        tac_operand storage; // slot of a function variable, or a global, resolved by the parser
         ExprNode* index; // For array access, nullptr for simple variables
-        string element_type; 
+        data_type element_type; 
     
     public:
-        VarNode(string name, string type, ExprNode* idx = nullptr, string elem_type = "")
-            : ExprNode(type), name(name), index(idx), element_type(elem_type) {}
-        
-        ~VarNode() { if(index) delete index; }
+        VarNode(int name, data_type type, tac_operand storage, ExprNode* idx = nullptr, data_type elem_type = TYPE_NONE)
+            : ExprNode(type), name(name), storage(storage), index(idx), element_type(elem_type) {}
         
         bool has_index() const { return index != nullptr; }
         
-        string generate_index_code(ofstream& outcode, map<string, string>& symbol_to_temp,
+        // Operand that holds the variable in the function being generated
+        tac_operand location(const vector<tac_operand>& slot_map) const {
+            return storage.kind == OPND_VAR ? slot_map[storage.value] : storage;
+        }
+        
+        tac_operand generate_index_code(tac_program& code, vector<tac_operand>& slot_map,
                                   int& temp_count, int& label_count) const {
-            if (!index) return "0"; 
+            if (!index) return int_operand(0); 
 
 
-            string idx_temp = index->generate_code(outcode, symbol_to_temp, temp_count, label_count);
+            tac_operand idx_temp = index->generate_code(code, slot_map, temp_count, label_count);
             
-            string idx_result;
+            tac_operand idx_result;
             
             
-            if (index->get_type() == "float") {
+            if (index->get_type() == TYPE_FLOAT) {
 
-                idx_result = "t" + to_string(temp_count++);
-                outcode << idx_result << " = (int)" << idx_temp << endl;
+                idx_result = temp_operand(temp_count++);
+                code.emit(TAC_FTOI, TYPE_INT, idx_result, idx_temp);
             } else {
 
-                idx_result = "t" + to_string(temp_count++);
-                outcode << idx_result << " = " << idx_temp << endl;
+                idx_result = temp_operand(temp_count++);
+                code.emit(TAC_COPY, TYPE_INT, idx_result, idx_temp);
             }
             
 
-            if (!element_type.empty()) {
-                string offset_temp = "t" + to_string(temp_count++);
+            if (element_type != TYPE_NONE) {
+                tac_operand offset_temp = temp_operand(temp_count++);
                 
                 int size_multiplier = 1; 
-                if (element_type == "int") size_multiplier = 4;
-                else if (element_type == "float") size_multiplier = 4;
-                else if (element_type == "double") size_multiplier = 8;
+                if (element_type == TYPE_INT) size_multiplier = 4;
+                else if (element_type == TYPE_FLOAT) size_multiplier = 4;
                 
                 if (size_multiplier > 1) {
-                    outcode << offset_temp << " = " << idx_result << " * " << size_multiplier << endl;
+                    code.emit(TAC_MUL, TYPE_INT, offset_temp, idx_result, int_operand(size_multiplier));
                     return offset_temp;
                 }
             }
@@ -79,27 +105,31 @@ class VarNode : public ExprNode {
             return idx_result;
         }
         
-        string generate_code(ofstream& outcode, map<string, string>& symbol_to_temp,
+        tac_operand generate_code(tac_program& code, vector<tac_operand>& slot_map,
                             int& temp_count, int& label_count) const override {
 
-            if (symbol_to_temp.find(name) == symbol_to_temp.end()) {
-                symbol_to_temp[name] = "t" + to_string(temp_count++);
-            }
-            string var_temp = symbol_to_temp[name];
+            tac_operand var_temp = location(slot_map);
             
             if (has_index()) {
                 
-                string idx_temp = generate_index_code(outcode, symbol_to_temp, temp_count, label_count);
-                string result_temp = "t" + to_string(temp_count++);
-                outcode << result_temp << " = " << var_temp << "[" << idx_temp << "]" << endl;
+                tac_operand idx_temp = generate_index_code(code, slot_map, temp_count, label_count);
+                tac_operand result_temp = temp_operand(temp_count++);
+                code.emit(TAC_LOAD, node_type, result_temp, var_temp, idx_temp);
                 return result_temp;
             } else {
                 return var_temp;
             }
         }
-        string get_name() const { return name; }
-        string get_element_type() const { return element_type; }
-        void set_element_type(string type) { element_type = type; }
+        VarNode* fold(int& removed) override {
+            if (index) index = index->fold(removed);
+            return this;
+        }
+        bool is_pure() const override { return !index || index->is_pure(); }
+        int node_count() const override { return 1 + (index ? index->node_count() : 0); }
+        
+        int get_name() const { return name; }
+        data_type get_element_type() const { return element_type; }
+        void set_element_type(data_type type) { element_type = type; }
 };
     
 
@@ -107,16 +137,28 @@ class VarNode : public ExprNode {
 
 class ConstNode : public ExprNode {
     private:
-        string value;
+        int int_value; // used when the type is TYPE_INT
+        double float_value; // used when the type is TYPE_FLOAT
 
     public:
-        ConstNode(string val, string type) : ExprNode(type), value(val) {}
+        ConstNode(int val) : ExprNode(TYPE_INT), int_value(val), float_value(0) {}
+        ConstNode(double val) : ExprNode(TYPE_FLOAT), int_value(0), float_value(val) {}
+        
+        int as_int() const { return int_value; }
+        double as_float() const { return node_type == TYPE_FLOAT ? float_value : int_value; } // int promoted
+        bool is_int(int v) const { return node_type == TYPE_INT && int_value == v; }
+        bool is_pure() const override { return true; }
         
-        string generate_code(ofstream& outcode, map<string, string>& symbol_to_temp,
+        tac_operand generate_code(tac_program& code, vector<tac_operand>& slot_map,
                             int& temp_count, int& label_count) const override {
-            string const_temp = "t" + to_string(temp_count++);
-            outcode << const_temp << " = " << value << endl;
-            return const_temp;
+            // constants are immediate operands, no temp is spent on them
+            if (node_type == TYPE_FLOAT) return code.float_operand(float_value);
+            return int_operand(int_value);
+        }
+        
+        void generate_branch(tac_program& code, vector<tac_operand>& slot_map,
+                            int& temp_count, int& label_count, tac_operand target, bool jump_if) const override {
+            if ((as_float() != 0) == jump_if) code.emit(TAC_GOTO, TYPE_NONE, target);
         }
 };
 
@@ -124,54 +166,196 @@ class ConstNode : public ExprNode {
 
 class BinaryOpNode : public ExprNode {
     private:
-        string op;
+        tac_opcode op;
         ExprNode* left;
         ExprNode* right;
 
     public:
-        BinaryOpNode(string op, ExprNode* left, ExprNode* right, string result_type)
+        BinaryOpNode(tac_opcode op, ExprNode* left, ExprNode* right, data_type result_type)
             : ExprNode(result_type), op(op), left(left), right(right) {}
         
-        ~BinaryOpNode() {
-            delete left;
-            delete right;
-        }
-        
-        string generate_code(ofstream& outcode, map<string, string>& symbol_to_temp,
+        tac_operand generate_code(tac_program& code, vector<tac_operand>& slot_map,
                             int& temp_count, int& label_count) const override {
-            string left_temp = left->generate_code(outcode, symbol_to_temp, temp_count, label_count);
-            string right_temp = right->generate_code(outcode, symbol_to_temp, temp_count, label_count);
+            if (is_logical()) {
+                // result starts as what a short circuit yields and is flipped when none happens
+                bool is_and = op == TAC_AND;
+                tac_operand result_temp = temp_operand(temp_count++);
+                tac_operand done_label = label_operand(label_count++);
+                code.emit(TAC_COPY, node_type, result_temp, int_operand(is_and ? 0 : 1));
+                generate_branch(code, slot_map, temp_count, label_count, done_label, !is_and);
+                code.emit(TAC_COPY, node_type, result_temp, int_operand(is_and ? 1 : 0));
+                code.emit(TAC_LABEL, TYPE_NONE, done_label);
+                return result_temp;
+            }
+            
+            tac_operand left_temp = left->generate_code(code, slot_map, temp_count, label_count);
+            tac_operand right_temp = right->generate_code(code, slot_map, temp_count, label_count);
             
-            string result_temp = "t" + to_string(temp_count++);
+            tac_operand result_temp = temp_operand(temp_count++);
             
-            outcode << result_temp << " = " << left_temp << " " << op << " " << right_temp << endl;
-            temp_cond= result_temp;
+            code.emit(op, node_type, result_temp, left_temp, right_temp);
             return result_temp;
         }
+        
+        // The right operand of && and || only runs when the left one does not decide the result
+        void generate_branch(tac_program& code, vector<tac_operand>& slot_map,
+                            int& temp_count, int& label_count, tac_operand target, bool jump_if) const override {
+            if (!is_logical()) {
+                ExprNode::generate_branch(code, slot_map, temp_count, label_count, target, jump_if);
+                return;
+            }
+            bool is_and = op == TAC_AND;
+            if (jump_if != is_and) {
+                // a false operand makes && false, a true one makes || true
+                left->generate_branch(code, slot_map, temp_count, label_count, target, jump_if);
+                right->generate_branch(code, slot_map, temp_count, label_count, target, jump_if);
+            } else {
+                tac_operand skip_label = label_operand(label_count++);
+                left->generate_branch(code, slot_map, temp_count, label_count, skip_label, !jump_if);
+                right->generate_branch(code, slot_map, temp_count, label_count, target, jump_if);
+                code.emit(TAC_LABEL, TYPE_NONE, skip_label);
+            }
+        }
+        
+        ExprNode* fold(int& removed) override {
+            left = left->fold(removed);
+            right = right->fold(removed);
+            tac_opcode opcode = op;
+            ConstNode* l = dynamic_cast<ConstNode*>(left);
+            ConstNode* r = dynamic_cast<ConstNode*>(right);
+            
+            if (l && r) {
+                ConstNode* result = evaluate(opcode, l, r);
+                if (!result) return this;
+                removed += 2;
+                return result;
+            }
+            // 0 && x and 1 || x never evaluate x, whatever it does
+            if (l && is_logical() && (l->as_float() != 0) == (opcode == TAC_OR)) {
+                removed += 1 + right->node_count();
+                return compile_arena.make<ConstNode>(opcode == TAC_OR ? 1 : 0);
+            }
+            
+            // x+0, 0+x and x-0 on ints; a float x+0 would turn -0.0 into 0.0
+            if ((opcode == TAC_ADD || opcode == TAC_SUB) && node_type == TYPE_INT) {
+                if (r && r->is_int(0)) { removed += 2; return left; }
+                if (opcode == TAC_ADD && l && l->is_int(0)) { removed += 2; return right; }
+            }
+            // x*1, 1*x and x/1, as long as dropping the 1 does not change the result type
+            if (opcode == TAC_MUL || opcode == TAC_DIV) {
+                if (r && r->is_int(1) && left->get_type() == node_type) { removed += 2; return left; }
+                if (opcode == TAC_MUL && l && l->is_int(1) && right->get_type() == node_type) { removed += 2; return right; }
+            }
+            if (opcode == TAC_MUL && node_type == TYPE_INT) {
+                // x*0 and 0*x, unless x has effects that must still happen
+                if (r && r->is_int(0) && left->is_pure()) { removed += 1 + left->node_count(); return right; }
+                if (l && l->is_int(0) && right->is_pure()) { removed += 1 + right->node_count(); return left; }
+                // x * 2^k becomes x << k
+                if (l && !r) {
+                    swap(left, right);
+                    swap(l, r);
+                }
+                if (r && r->as_int() > 1 && (r->as_int() & (r->as_int() - 1)) == 0) {
+                    int shift = 0;
+                    while ((1 << shift) != r->as_int()) shift++;
+                    op = TAC_SHL;
+                    right = compile_arena.make<ConstNode>(shift);
+                }
+            }
+            return this;
+        }
+        
+        bool is_pure() const override { return left->is_pure() && right->is_pure(); }
+        int node_count() const override { return 1 + left->node_count() + right->node_count(); }
+        
+    private:
+        bool is_logical() const { return op == TAC_AND || op == TAC_OR; }
+        
+        // The constant op yields on l and r under the grammar's promotion rules: arithmetic on an
+        // int and a float is done in float, comparisons and logical operators give an int.
+        // Returns nullptr for what must be left to run time, like a division by zero.
+        ConstNode* evaluate(tac_opcode opcode, const ConstNode* l, const ConstNode* r) const {
+            if (l->get_type() == TYPE_FLOAT || r->get_type() == TYPE_FLOAT) {
+                double a = l->as_float(), b = r->as_float();
+                switch (opcode) {
+                    case TAC_ADD: return compile_arena.make<ConstNode>(a + b);
+                    case TAC_SUB: return compile_arena.make<ConstNode>(a - b);
+                    case TAC_MUL: return compile_arena.make<ConstNode>(a * b);
+                    case TAC_DIV: return b == 0 ? nullptr : compile_arena.make<ConstNode>(a / b);
+                    case TAC_LT: return compile_arena.make<ConstNode>((int)(a < b));
+                    case TAC_GT: return compile_arena.make<ConstNode>((int)(a > b));
+                    case TAC_LE: return compile_arena.make<ConstNode>((int)(a <= b));
+                    case TAC_GE: return compile_arena.make<ConstNode>((int)(a >= b));
+                    case TAC_EQ: return compile_arena.make<ConstNode>((int)(a == b));
+                    case TAC_NE: return compile_arena.make<ConstNode>((int)(a != b));
+                    case TAC_AND: return compile_arena.make<ConstNode>((int)(a != 0 && b != 0));
+                    case TAC_OR: return compile_arena.make<ConstNode>((int)(a != 0 || b != 0));
+                    default: return nullptr;
+                }
+            }
+            // ints wrap around like the target's 32-bit arithmetic
+            int a = l->as_int(), b = r->as_int();
+            bool bad_divide = b == 0 || (a == INT_MIN && b == -1);
+            switch (opcode) {
+                case TAC_ADD: return compile_arena.make<ConstNode>((int)((unsigned)a + (unsigned)b));
+                case TAC_SUB: return compile_arena.make<ConstNode>((int)((unsigned)a - (unsigned)b));
+                case TAC_MUL: return compile_arena.make<ConstNode>((int)((unsigned)a * (unsigned)b));
+                case TAC_DIV: return bad_divide ? nullptr : compile_arena.make<ConstNode>(a / b);
+                case TAC_MOD: return bad_divide ? nullptr : compile_arena.make<ConstNode>(a % b);
+                case TAC_SHL: return compile_arena.make<ConstNode>((int)((unsigned)a << (b & 31)));
+                case TAC_LT: return compile_arena.make<ConstNode>((int)(a < b));
+                case TAC_GT: return compile_arena.make<ConstNode>((int)(a > b));
+                case TAC_LE: return compile_arena.make<ConstNode>((int)(a <= b));
+                case TAC_GE: return compile_arena.make<ConstNode>((int)(a >= b));
+                case TAC_EQ: return compile_arena.make<ConstNode>((int)(a == b));
+                case TAC_NE: return compile_arena.make<ConstNode>((int)(a != b));
+                case TAC_AND: return compile_arena.make<ConstNode>((int)(a != 0 && b != 0));
+                case TAC_OR: return compile_arena.make<ConstNode>((int)(a != 0 || b != 0));
+                default: return nullptr;
+            }
+        }
 };
 
 // Unary operation node
 
 class UnaryOpNode : public ExprNode {
     private:
-        string op;
+        tac_opcode op; // TAC_NEG, TAC_NOT, or TAC_COPY for unary +
         ExprNode* expr;
 
     public:
-        UnaryOpNode(string op, ExprNode* expr, string result_type)
+        UnaryOpNode(tac_opcode op, ExprNode* expr, data_type result_type)
             : ExprNode(result_type), op(op), expr(expr) {}
         
-        ~UnaryOpNode() { delete expr; }
-        
-        string generate_code(ofstream& outcode, map<string, string>& symbol_to_temp,
+        tac_operand generate_code(tac_program& code, vector<tac_operand>& slot_map,
                             int& temp_count, int& label_count) const override {
-            string expr_temp = expr->generate_code(outcode, symbol_to_temp, temp_count, label_count);
+            tac_operand expr_temp = expr->generate_code(code, slot_map, temp_count, label_count);
 
-            string result_temp = "t" + to_string(temp_count++);
+            tac_operand result_temp = temp_operand(temp_count++);
             
-            outcode <<result_temp << " = " << op << expr_temp << endl;
+            code.emit(op, node_type, result_temp, expr_temp);
             return result_temp;
         }
+        
+        void generate_branch(tac_program& code, vector<tac_operand>& slot_map,
+                            int& temp_count, int& label_count, tac_operand target, bool jump_if) const override {
+            if (op == TAC_NOT) expr->generate_branch(code, slot_map, temp_count, label_count, target, !jump_if);
+            else ExprNode::generate_branch(code, slot_map, temp_count, label_count, target, jump_if);
+        }
+        
+        ExprNode* fold(int& removed) override {
+            expr = expr->fold(removed);
+            if (op == TAC_COPY && expr->get_type() == node_type) { removed += 1; return expr; }
+            ConstNode* c = dynamic_cast<ConstNode*>(expr);
+            if (!c) return this;
+            removed += 1;
+            if (op == TAC_NOT) return compile_arena.make<ConstNode>((int)(c->as_float() == 0));
+            if (c->get_type() == TYPE_FLOAT) return compile_arena.make<ConstNode>(op == TAC_NEG ? -c->as_float() : c->as_float());
+            return compile_arena.make<ConstNode>(op == TAC_NEG ? (int)(0u - (unsigned)c->as_int()) : c->as_int());
+        }
+        
+        bool is_pure() const override { return expr->is_pure(); }
+        int node_count() const override { return 1 + expr->node_count(); }
 };
 
 // Assignment node
@@ -182,69 +366,66 @@ class AssignNode : public ExprNode {
         ExprNode* rhs;
 
     public:
-        AssignNode(VarNode* lhs, ExprNode* rhs, string result_type)
+        AssignNode(VarNode* lhs, ExprNode* rhs, data_type result_type)
             : ExprNode(result_type), lhs(lhs), rhs(rhs) {}
         
-        ~AssignNode() {
-            delete lhs;
-            delete rhs;
-        }
-        
-        string generate_code(ofstream& outcode, map<string, string>& symbol_to_temp,
+        tac_operand generate_code(tac_program& code, vector<tac_operand>& slot_map,
                             int& temp_count, int& label_count) const override {
-            string rhs_temp = rhs->generate_code(outcode, symbol_to_temp, temp_count, label_count);
+            tac_operand rhs_temp = rhs->generate_code(code, slot_map, temp_count, label_count);
             
             if (lhs->has_index()) { 
-                string array_temp = symbol_to_temp[lhs->get_name()]; 
-                string idx_temp = lhs->generate_index_code(outcode, symbol_to_temp, temp_count, label_count);
+                tac_operand array_temp = lhs->location(slot_map); 
+                tac_operand idx_temp = lhs->generate_index_code(code, slot_map, temp_count, label_count);
                 
                 
-                if (lhs->get_element_type() == "int" && rhs->get_type() == "float") {
-                    string converted_temp = "t" + to_string(temp_count++);
-                    outcode << converted_temp << " = (int)" << rhs_temp << endl;
-                    outcode << array_temp << "[" << idx_temp << "] = " << converted_temp << endl;
+                if (lhs->get_element_type() == TYPE_INT && rhs->get_type() == TYPE_FLOAT) {
+                    tac_operand converted_temp = temp_operand(temp_count++);
+                    code.emit(TAC_FTOI, TYPE_INT, converted_temp, rhs_temp);
+                    code.emit(TAC_STORE, TYPE_INT, array_temp, idx_temp, converted_temp);
                 } 
-                else if (lhs->get_element_type() == "float" && rhs->get_type() == "int") {
-                    string converted_temp = "t" + to_string(temp_count++);
-                    outcode << converted_temp << " = (float)" << rhs_temp << endl;
-                    outcode << array_temp << "[" << idx_temp << "] = " << converted_temp << endl;
+                else if (lhs->get_element_type() == TYPE_FLOAT && rhs->get_type() == TYPE_INT) {
+                    tac_operand converted_temp = temp_operand(temp_count++);
+                    code.emit(TAC_ITOF, TYPE_FLOAT, converted_temp, rhs_temp);
+                    code.emit(TAC_STORE, TYPE_FLOAT, array_temp, idx_temp, converted_temp);
                 }
                 else {
-                    outcode << array_temp << "[" << idx_temp << "] = " << rhs_temp << endl;
+                    code.emit(TAC_STORE, lhs->get_type(), array_temp, idx_temp, rhs_temp);
                 }
             } else { 
-                string var_name = lhs->get_name();
-                if (symbol_to_temp.find(var_name) == symbol_to_temp.end()) {
-                    symbol_to_temp[var_name] = "t" + to_string(temp_count++);
-                }
+                tac_operand lhs_temp = lhs->location(slot_map);
                 
-                string lhs_temp = symbol_to_temp[var_name];
                 
-                
-                if (lhs->get_type() == "int" && rhs->get_type() == "float") {
-                    string converted_temp = "t" + to_string(temp_count++);
-                    outcode << converted_temp << " = (int)" << rhs_temp << endl;
-                    outcode << lhs_temp << " = " << converted_temp << endl;
+                if (lhs->get_type() == TYPE_INT && rhs->get_type() == TYPE_FLOAT) {
+                    tac_operand converted_temp = temp_operand(temp_count++);
+                    code.emit(TAC_FTOI, TYPE_INT, converted_temp, rhs_temp);
+                    code.emit(TAC_COPY, TYPE_INT, lhs_temp, converted_temp);
                 } 
-                else if (lhs->get_type() == "float" && rhs->get_type() == "int") {
-                    string converted_temp = "t" + to_string(temp_count++);
-                    outcode << converted_temp << " = (float)" << rhs_temp << endl;
-                    outcode << lhs_temp << " = " << converted_temp << endl;
+                else if (lhs->get_type() == TYPE_FLOAT && rhs->get_type() == TYPE_INT) {
+                    tac_operand converted_temp = temp_operand(temp_count++);
+                    code.emit(TAC_ITOF, TYPE_FLOAT, converted_temp, rhs_temp);
+                    code.emit(TAC_COPY, TYPE_FLOAT, lhs_temp, converted_temp);
                 }
                 else {
-                    outcode << lhs_temp << " = " << rhs_temp << endl;
+                    code.emit(TAC_COPY, lhs->get_type(), lhs_temp, rhs_temp);
                 }
             }
             return rhs_temp;
         }
+        
+        ExprNode* fold(int& removed) override {
+            rhs = rhs->fold(removed);
+            lhs = lhs->fold(removed);
+            return this;
+        }
 };
 
 // Statement node types
 
 class StmtNode : public ASTNode {
     public:
-        virtual string generate_code(ofstream& outcode, map<string, string>& symbol_to_temp,
+        virtual tac_operand generate_code(tac_program& code, vector<tac_operand>& slot_map,
                                     int& temp_count, int& label_count) const = 0;
+        StmtNode* fold(int& removed) override { return this; }
     };
 
 
@@ -255,14 +436,20 @@ class ExprStmtNode : public StmtNode {
 
     public:
         ExprStmtNode(ExprNode* e) : expr(e) {}
-        ~ExprStmtNode() { if(expr) delete expr; }
         
-        string generate_code(ofstream& outcode, map<string, string>& symbol_to_temp,
+        ExprNode* get_expr() const { return expr; } // nullptr for an empty statement
+        
+        tac_operand generate_code(tac_program& code, vector<tac_operand>& slot_map,
                             int& temp_count, int& label_count) const override {
             if (expr) {
-                expr->generate_code(outcode, symbol_to_temp, temp_count, label_count);
+                expr->generate_code(code, slot_map, temp_count, label_count);
             }
-            return ""; 
+            return tac_operand(); 
+        }
+        
+        StmtNode* fold(int& removed) override {
+            if (expr) expr = expr->fold(removed);
+            return this;
         }
 };
 
@@ -273,22 +460,22 @@ class BlockNode : public StmtNode {
         vector<StmtNode*> statements;
 
     public:
-        ~BlockNode() {
-            for (auto stmt : statements) {
-                delete stmt;
-            }
-        }
         
         void add_statement(StmtNode* stmt) {
             if (stmt) statements.push_back(stmt);
         }
         
-        string generate_code(ofstream& outcode, map<string, string>& symbol_to_temp,
+        tac_operand generate_code(tac_program& code, vector<tac_operand>& slot_map,
                             int& temp_count, int& label_count) const override {
             for (auto stmt : statements) {
-                stmt->generate_code(outcode, symbol_to_temp, temp_count, label_count);
+                stmt->generate_code(code, slot_map, temp_count, label_count);
             }
-            return "";
+            return tac_operand();
+        }
+        
+        StmtNode* fold(int& removed) override {
+            for (auto& stmt : statements) stmt = stmt->fold(removed);
+            return this;
         }
 };
 
@@ -304,42 +491,35 @@ class IfNode : public StmtNode {
         IfNode(ExprNode* cond, StmtNode* then_stmt, StmtNode* else_stmt = nullptr)
             : condition(cond), then_block(then_stmt), else_block(else_stmt) {}
         
-        ~IfNode() {
-            delete condition;
-            delete then_block;
-            if (else_block) delete else_block;
-        }
-        
-        string generate_code(ofstream& outcode, map<string, string>& symbol_to_temp,
+        tac_operand generate_code(tac_program& code, vector<tac_operand>& slot_map,
                             int& temp_count, int& label_count) const override {
             
-            string cond_temp = condition->generate_code(outcode, symbol_to_temp, temp_count, label_count);
-            
-            
-            int then_label = label_count++;
-            int else_label = label_count++;
-            
+            tac_operand else_label = label_operand(label_count++);
             
-            outcode << "if " << cond_temp << " goto L" << then_label << endl;
-            outcode << "goto L" << else_label << endl;
-            outcode << "L" << then_label << ":" << endl;
+            condition->generate_branch(code, slot_map, temp_count, label_count, else_label, false);
             
-            
-            then_block->generate_code(outcode, symbol_to_temp, temp_count, label_count);
+            then_block->generate_code(code, slot_map, temp_count, label_count);
             
             
             if (else_block) {
-                int end_label = label_count++;
-                outcode << "goto L" << end_label << endl;
-                outcode << "L" << else_label << ":" << endl;
-                else_block->generate_code(outcode, symbol_to_temp, temp_count, label_count);
-                outcode << "L" << end_label << ":" << endl;
+                tac_operand end_label = label_operand(label_count++);
+                code.emit(TAC_GOTO, TYPE_NONE, end_label);
+                code.emit(TAC_LABEL, TYPE_NONE, else_label);
+                else_block->generate_code(code, slot_map, temp_count, label_count);
+                code.emit(TAC_LABEL, TYPE_NONE, end_label);
             } else {
                 
-                outcode << "L" << else_label << ":" << endl;
+                code.emit(TAC_LABEL, TYPE_NONE, else_label);
             }
             
-            return "";
+            return tac_operand();
+        }
+        
+        StmtNode* fold(int& removed) override {
+            condition = condition->fold(removed);
+            then_block = then_block->fold(removed);
+            if (else_block) else_block = else_block->fold(removed);
+            return this;
         }
 };
 // While statement node
@@ -353,35 +533,29 @@ class WhileNode : public StmtNode {
         WhileNode(ExprNode* cond, StmtNode* body_stmt)
             : condition(cond), body(body_stmt) {}
         
-        ~WhileNode() {
-            delete condition;
-            delete body;
-        }
-        
-        string generate_code(ofstream& outcode, map<string, string>& symbol_to_temp,
+        tac_operand generate_code(tac_program& code, vector<tac_operand>& slot_map,
                             int& temp_count, int& label_count) const override {
-            int start_label = label_count++;
-            int body_label = label_count++;
-            int end_label = label_count++; 
-            
-            outcode << "L" << start_label << ":" << endl;
-            
-            string cond_temp = condition->generate_code(outcode, symbol_to_temp, temp_count, label_count);
-            
+            tac_operand start_label = label_operand(label_count++);
+            tac_operand end_label = label_operand(label_count++); 
             
-            outcode << "if " << cond_temp << " goto L" << body_label << endl;
-            outcode << "goto L" << end_label << endl;
+            code.emit(TAC_LABEL, TYPE_NONE, start_label);
             
+            condition->generate_branch(code, slot_map, temp_count, label_count, end_label, false);
             
-            outcode << "L" << body_label << ":" << endl;
-            body->generate_code(outcode, symbol_to_temp, temp_count, label_count); 
+            body->generate_code(code, slot_map, temp_count, label_count); 
 
             
             
-            outcode << "goto L" << start_label << endl;
-            outcode << "L" << end_label << ":" << endl;
+            code.emit(TAC_GOTO, TYPE_NONE, start_label);
+            code.emit(TAC_LABEL, TYPE_NONE, end_label);
             
-            return "";
+            return tac_operand();
+        }
+        
+        StmtNode* fold(int& removed) override {
+            condition = condition->fold(removed);
+            body = body->fold(removed);
+            return this;
         }
 };
 
@@ -396,49 +570,45 @@ class ForNode : public StmtNode {
         ForNode(ExprNode* init_expr, ExprNode* cond_expr, ExprNode* update_expr, StmtNode* body_stmt)
             : init(init_expr), condition(cond_expr), update(update_expr), body(body_stmt) {}
         
-        ~ForNode() {
-            if (init) delete init;
-            if (condition) delete condition;
-            if (update) delete update;
-            delete body;
-        }
-        
-        string generate_code(ofstream& outcode, map<string, string>& symbol_to_temp,
+        tac_operand generate_code(tac_program& code, vector<tac_operand>& slot_map,
                             int& temp_count, int& label_count) const override {
        
             if (init) {
-                init->generate_code(outcode, symbol_to_temp, temp_count, label_count);
+                init->generate_code(code, slot_map, temp_count, label_count);
             }
             
-            int cond_label = label_count++;
-            int body_label = label_count++;
-            int end_label = label_count++;
+            tac_operand cond_label = label_operand(label_count++);
+            tac_operand end_label = label_operand(label_count++);
             
            
-            outcode << "L" << cond_label << ":" << endl;
+            code.emit(TAC_LABEL, TYPE_NONE, cond_label);
 
             if (condition) {
-                string cond_temp = condition->generate_code(outcode, symbol_to_temp, temp_count, label_count);
-                outcode << "if " << temp_cond << " goto L" << body_label << endl;
-                outcode << "goto L" << end_label << endl;
+                condition->generate_branch(code, slot_map, temp_count, label_count, end_label, false);
             }
-            temp_cond= "";
             
 
-            outcode << "L" << body_label << ":" << endl;
-            body->generate_code(outcode, symbol_to_temp, temp_count, label_count);
+            body->generate_code(code, slot_map, temp_count, label_count);
             
     
             if (update) {
-                update->generate_code(outcode, symbol_to_temp, temp_count, label_count);
+                update->generate_code(code, slot_map, temp_count, label_count);
             }
             
            
-            outcode << "goto L" << cond_label << endl;
-            outcode << "L" << end_label << ":" << endl;
+            code.emit(TAC_GOTO, TYPE_NONE, cond_label);
+            code.emit(TAC_LABEL, TYPE_NONE, end_label);
             
             
-            return "";
+            return tac_operand();
+        }
+        
+        StmtNode* fold(int& removed) override {
+            if (init) init = init->fold(removed);
+            if (condition) condition = condition->fold(removed);
+            if (update) update = update->fold(removed);
+            body = body->fold(removed);
+            return this;
         }
     };
 // Return statement node
@@ -449,19 +619,23 @@ class ReturnNode : public StmtNode {
 
     public:
         ReturnNode(ExprNode* e) : expr(e) {}
-        ~ReturnNode() { if (expr) delete expr; }
         
-        string generate_code(ofstream& outcode, map<string, string>& symbol_to_temp,
+        tac_operand generate_code(tac_program& code, vector<tac_operand>& slot_map,
                             int& temp_count, int& label_count) const override {
             if (expr) {
                 
-                string ret_temp = expr->generate_code(outcode, symbol_to_temp, temp_count, label_count);
-                outcode << "return " << ret_temp << endl;
+                tac_operand ret_temp = expr->generate_code(code, slot_map, temp_count, label_count);
+                code.emit(TAC_RETURN, expr->get_type(), tac_operand(), ret_temp);
             } else {
                 
-                outcode << "return" << endl;
+                code.emit(TAC_RETURN, TYPE_VOID, tac_operand());
             }
-            return "";
+            return tac_operand();
+        }
+        
+        StmtNode* fold(int& removed) override {
+            if (expr) expr = expr->fold(removed);
+            return this;
         }
 };
 
@@ -469,60 +643,42 @@ class ReturnNode : public StmtNode {
 
 class DeclNode : public StmtNode {
     private:
-        string type;
-        vector<pair<string, int>> vars; 
-        map<string, VarNode*> var_nodes; 
+        data_type type;
+        vector<pair<int, int>> vars; // interned name, array size
+        vector<tac_operand> storage; // slot or global of each variable
+        map<int, VarNode*> var_nodes; 
 
     public:
-        DeclNode(string t) : type(t) {}
-        
-        ~DeclNode() {
-            
-            for (auto& pair : var_nodes) {
-                delete pair.second;
-            }
-        }
+        DeclNode(data_type t) : type(t) {}
         
-        void add_var(string name, int array_size = 0) {
+        void add_var(int name, int array_size, tac_operand where) {
             vars.push_back(make_pair(name, array_size));
+            storage.push_back(where);
             
             
             if (array_size > 0) {
-                VarNode* node = new VarNode(name, type + "[]", nullptr, type);
+                VarNode* node = compile_arena.make<VarNode>(name, type, where, nullptr, type);
                 var_nodes[name] = node;
             }
         }
         
-        string generate_code(ofstream& outcode, map<string, string>& symbol_to_temp,
+        tac_operand generate_code(tac_program& code, vector<tac_operand>& slot_map,
                             int& temp_count, int& label_count) const override {
-            for (auto var : vars) {
-                string var_name = var.first;
-                int array_size = var.second;
-                
-               
-                if (symbol_to_temp.find(var_name) == symbol_to_temp.end()) {
-                    symbol_to_temp[var_name] = var.first; 
-                }
-                
-                if (array_size > 0) {
-                    outcode << "// Declaration: " << type << " " << var_name << "[" << array_size << "]" << endl;
-                } else {
-                    outcode << "// Declaration: " << type << " " << var_name << endl;
-                }
+            for (size_t i = 0; i < vars.size(); ++i) {
+                code.emit(TAC_DECL, type, storage[i], int_operand(vars[i].second));
             }
-            return "";
+            return tac_operand();
         }
         
-        string get_type() const { return type; }
-        const vector<pair<string, int>>& get_vars() const { return vars; }
-        
+        data_type get_type() const { return type; }
+        const vector<pair<int, int>>& get_vars() const { return vars; }
         
-        string get_element_type(string var_name) const {
+        data_type get_element_type(int var_name) const {
             auto it = var_nodes.find(var_name);
             if (it != var_nodes.end()) {
                 return it->second->get_element_type();
             }
-            return "";
+            return TYPE_NONE;
         }
 };
 
@@ -530,16 +686,17 @@ class DeclNode : public StmtNode {
 
 class FuncDeclNode : public ASTNode {
     private:
-        string return_type;
-        string name;
-        vector<pair<string, string>> params; 
+        data_type return_type;
+        int name; // interned
+        vector<pair<data_type, int>> params; // type, interned name
+        vector<tac_slot> slots; // parameters and locals, indexed by VarNode storage
         BlockNode* body;
+        string cache_key; // names the function's entry in the code cache (tac_cache.h), empty when not caching
 
     public:
-        FuncDeclNode(string ret_type, string n) : return_type(ret_type), name(n), body(nullptr) {}
-        ~FuncDeclNode() { if (body) delete body; }
+        FuncDeclNode(data_type ret_type, int n) : return_type(ret_type), name(n), body(nullptr) {}
         
-        void add_param(string type, string name) {
+        void add_param(data_type type, int name) {
             params.push_back(make_pair(type, name));
         }
         
@@ -547,35 +704,46 @@ class FuncDeclNode : public ASTNode {
             body = b;
         }
         
-        string generate_code(ofstream& outcode, map<string, string>& symbol_to_temp,
+        void set_slots(const vector<tac_slot>& s) {
+            slots = s;
+        }
+        
+        void set_cache_key(const string& key) {
+            cache_key = key;
+        }
+        
+        const string& get_cache_key() const {
+            return cache_key;
+        }
+        
+        tac_operand generate_code(tac_program& code, vector<tac_operand>& slot_map,
                             int& temp_count, int& label_count) const override {
             
-            symbol_to_temp.clear();
-            
-            outcode << "// Function: " << return_type << " " << name << "(";
-            
-            
-            for (size_t i = 0; i < params.size(); ++i) {
-                outcode << params[i].first << " " << params[i].second;
-                if (i < params.size() - 1) {
-                    outcode << ", ";
-                }
+            slot_map.resize(slots.size());
+            for (size_t i = 0; i < slots.size(); ++i) {
+                slot_map[i] = var_operand(i);
             }
-            outcode << ")" << endl;
+            
+            code.functions.push_back({name, return_type, params, slots});
+            code.emit(TAC_FUNC, return_type, tac_operand(), tac_operand(OPND_FUNC, name),
+                      int_operand(code.functions.size() - 1));
             
             for (size_t i = 0; i < params.size(); ++i) {
-                string param_name = params[i].second;
-                
-                string temp_var = "t" + to_string(temp_count++);
-                symbol_to_temp[param_name] = temp_var;
-                outcode << temp_var << " = " << param_name << endl;
+                tac_operand temp_var = temp_operand(temp_count++);
+                slot_map[i] = temp_var;
+                code.emit(TAC_COPY, params[i].first, temp_var, var_operand(i));
             }
             
             if (body) {
-                body->generate_code(outcode, symbol_to_temp, temp_count, label_count);
+                body->generate_code(code, slot_map, temp_count, label_count);
             }
             
-            return "";
+            return tac_operand();
+        }
+        
+        FuncDeclNode* fold(int& removed) override {
+            if (body) body->fold(removed);
+            return this;
         }
 };
 
@@ -586,9 +754,6 @@ private:
     vector<ExprNode*> args;
 
 public:
-    ~ArgumentsNode() {
-        // Don't delete args here - they'll be transferred to FuncCallNode
-    }
     
     void add_argument(ExprNode* arg) {
         if (arg) args.push_back(arg);
@@ -609,9 +774,9 @@ public:
         return args;
     }
     
-    string generate_code(ofstream& outcode, map<string, string>& symbol_to_temp,
+    tac_operand generate_code(tac_program& code, vector<tac_operand>& slot_map,
                         int& temp_count, int& label_count) const override {
-        return "";
+        return tac_operand();
     }
 };
 
@@ -619,48 +784,46 @@ public:
 
 class FuncCallNode : public ExprNode {
 private:
-    string func_name;
+    int func_name; // interned
     vector<ExprNode*> arguments;
 
 public:
-    FuncCallNode(string name, string result_type)
+    FuncCallNode(int name, data_type result_type)
         : ExprNode(result_type), func_name(name) {}
     
-    ~FuncCallNode() {
-        for (auto arg : arguments) {
-            delete arg;
-        }
-    }
-    
     void add_argument(ExprNode* arg) {
         if (arg) arguments.push_back(arg);
     }
     
-    string generate_code(ofstream& outcode, map<string, string>& symbol_to_temp,
+    tac_operand generate_code(tac_program& code, vector<tac_operand>& slot_map,
                         int& temp_count, int& label_count) const override {
         
         
-        vector<string> arg_temps;
+        vector<tac_operand> arg_temps;
         for (auto arg : arguments) {
-            string arg_temp = arg->generate_code(outcode, symbol_to_temp, temp_count, label_count);
+            tac_operand arg_temp = arg->generate_code(code, slot_map, temp_count, label_count);
             arg_temps.push_back(arg_temp);
         }
         
         
-        for (const auto& arg_temp : arg_temps) {
-            string temp_var = "t" + to_string(temp_count++);
-            outcode << temp_var << " = " << arg_temp << endl;
-            outcode << "param " << temp_var << endl;
+        for (size_t i = 0; i < arg_temps.size(); ++i) {
+            tac_operand temp_var = temp_operand(temp_count++);
+            code.emit(TAC_COPY, arguments[i]->get_type(), temp_var, arg_temps[i]);
+            code.emit(TAC_PARAM, arguments[i]->get_type(), tac_operand(), temp_var);
         }
         
-       
-        string result_temp = "t" + to_string(temp_count++);
+        tac_operand result_temp = temp_operand(temp_count++);
         
         
-        outcode << result_temp << " = call " << func_name << ", " << arg_temps.size() << endl;
+        code.emit(TAC_CALL, node_type, result_temp, tac_operand(OPND_FUNC, func_name), int_operand(arg_temps.size()));
         
         return result_temp;
     }
+    
+    ExprNode* fold(int& removed) override {
+        for (auto& arg : arguments) arg = arg->fold(removed);
+        return this;
+    }
 };
 
 // Program node (root of AST)
@@ -668,26 +831,36 @@ public:
 class ProgramNode : public ASTNode {
     private:
         vector<ASTNode*> units;
+        vector<tac_slot> globals; // indexed by global VarNode storage
 
     public:
-        ~ProgramNode() {
-            for (auto unit : units) {
-                delete unit;
-            }
+        
+        void set_globals(const vector<tac_slot>& g) {
+            globals = g;
         }
         
         void add_unit(ASTNode* unit) {
             if (unit) units.push_back(unit);
         }
         
-        string generate_code(ofstream& outcode, map<string, string>& symbol_to_temp,
+        // Functions and global declarations in source order; each generates code on its own
+        const vector<ASTNode*>& get_units() const { return units; }
+        const vector<tac_slot>& get_globals() const { return globals; }
+        
+        tac_operand generate_code(tac_program& code, vector<tac_operand>& slot_map,
                             int& temp_count, int& label_count) const override {
 
+            code.globals = globals;
             for (auto unit : units) {
-                unit->generate_code(outcode, symbol_to_temp, temp_count, label_count);
+                unit->generate_code(code, slot_map, temp_count, label_count);
             }
             
-            return "";
+            return tac_operand();
+        }
+        
+        ProgramNode* fold(int& removed) override {
+            for (auto& unit : units) unit = unit->fold(removed);
+            return this;
         }
 };
 
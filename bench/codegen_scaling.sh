@@ -0,0 +1,42 @@
+#!/bin/bash
+# Times pass 2 (code generation and optimization) of one input with many functions on 1, 2, 4, ...
+# threads, and checks that every thread count writes the same code.
+# Run from the repository root after script.sh has built two_pass_compiler:
+#   bench/codegen_scaling.sh [functions] [max threads]
+functions=${1:-2000}
+max_jobs=${2:-$(nproc)}
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+
+# every function has loops, branches and float math for the optimizer to work on, and calls the one before it
+{
+	echo 'int G;'
+	for ((f = 0; f < functions; f++)); do
+		echo "int f$f(int n, int m) {"
+		echo '    int a[16], i, s, t, u;'
+		echo '    float x;'
+		echo '    s = 0; t = 1; u = 2;'
+		for ((k = 0; k < 4; k++)); do
+			echo '    for (i = 0; i < n; i++) { a[i] = a[i] + t * u; s = s + a[i] * 2; }'
+			echo '    if (s > m && t < 3) { s = s - 1; } else { t = t + 2 * 3; }'
+			echo '    while (i < n * 2) { { int q; q = i * 4 + 0; s = s + q * 1; } i = i + 1; }'
+			echo '    x = s * 1.5 + t / 2.0;'
+			echo '    u = (s + t) * (s + t) - u % 7;'
+		done
+		if ((f > 0)); then echo "    s = s + f$((f - 1))(n - 1, m);"; fi
+		echo '    return s;'
+		echo '}'
+	done
+	echo "int main() { int r; r = f$((functions - 1))(10, 3); return r; }"
+} > "$dir/input.c"
+
+compiler=$(pwd)/two_pass_compiler
+echo "$functions functions, $(wc -l < "$dir/input.c") lines"
+for ((jobs = 1; jobs <= max_jobs; jobs *= 2)); do
+	mkdir "$dir/$jobs"
+	(cd "$dir/$jobs" && "$compiler" --log=off --emit=both --jobs=$jobs ../input.c | grep "Code generation and optimization")
+	if ((jobs > 1)) && ! cmp -s "$dir/1/code.tac" "$dir/$jobs/code.tac"; then
+		echo "code.tac differs between 1 and $jobs threads"
+		exit 1
+	fi
+done
@@ -0,0 +1,66 @@
+// Scanner throughput: tokens per second of the flex scanner alone, without the parser.
+// Build from the repository root after script.sh has generated y.tab.h and lex.yy.c:
+//   g++ -O2 -I. -fpermissive -w bench/lexer_bench.cpp lex.yy.c -o lexer_bench
+// Usage: ./lexer_bench file.c [rounds]
+
+#include "compile_context.h"
+#include "y.tab.h"
+#include <chrono>
+#include <cstdio>
+
+thread_local string_interner names;
+thread_local arena compile_arena;
+
+// Reentrant scanner interface, generated by flex
+struct yy_buffer_state;
+int yylex(YYSTYPE *yylval, YYLTYPE *yylloc, yyscan_t scanner);
+int yylex_init_extra(compile_context *extra, yyscan_t *scanner);
+int yylex_destroy(yyscan_t scanner);
+yy_buffer_state *yy_scan_bytes(const char *bytes, int len, yyscan_t scanner);
+void yy_delete_buffer(yy_buffer_state *buffer, yyscan_t scanner);
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2) {
+        printf("Usage: %s file.c [rounds]\n", argv[0]);
+        return 1;
+    }
+    int rounds = argc > 2 ? atoi(argv[2]) : 20;
+
+    compile_context ctx(argv[1], "", compile_options());
+    FILE *in = fopen(argv[1], "rb");
+    if (in == NULL) {
+        printf("Couldn't open file\n");
+        return 1;
+    }
+    char buf[1 << 16];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), in)) > 0) ctx.source_text.append(buf, n);
+    fclose(in);
+
+    // every round scans the whole file with a fresh scanner, as a compilation does
+    long long tokens = 0, kinds = 0;
+    auto start = chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        ctx.src_offset = 0;
+        ctx.lines = 1;
+        yyscan_t scanner;
+        yylex_init_extra(&ctx, &scanner);
+        yy_buffer_state *input = yy_scan_bytes(ctx.source_text.data(), ctx.source_text.size(), scanner);
+        YYSTYPE value;
+        YYLTYPE location;
+        for (int kind; (kind = yylex(&value, &location, scanner)) != 0; ) {
+            tokens++;
+            kinds += kind; // keeps the loop from being optimized away
+        }
+        yy_delete_buffer(input, scanner);
+        yylex_destroy(scanner);
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    double bytes = (double)ctx.source_text.size() * rounds;
+    printf("%lld tokens (checksum %lld) in %.1f ms\n", tokens, kinds, seconds * 1000);
+    printf("%.2f Mtokens/s, %.1f MB/s, %.1f ns/token\n", tokens / seconds / 1e6, bytes / seconds / 1e6, seconds * 1e9 / tokens);
+    printf("Arena: %zu bytes used\n", compile_arena.bytes_used());
+    return 0;
+}
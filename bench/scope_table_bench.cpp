@@ -0,0 +1,204 @@
+// Microbenchmark: flat symbol_table vs the old chain of per-scope chained tables.
+// Build from the repository root:
+//   g++ -O2 -I. bench/scope_table_bench.cpp -o scope_table_bench -pthread
+// Usage: ./scope_table_bench [symbols] [lookup rounds] [nesting depth]
+
+#include "symbol_table.h"
+#include <chrono>
+
+thread_local string_interner names;
+
+// The chained table each scope_table used to own: character-sum hash into 10 buckets
+class chained_scope_table
+{
+private:
+    symbol_info** chains;
+    int tbl_size;
+    int hash_func(int name)
+    {
+        const string& symbol = names.str(name);
+        int sum = 0;
+        for (int i = 0; i < symbol.size(); i++) sum += (int)symbol[i];
+        return sum%tbl_size;
+    }
+public:
+    chained_scope_table(int n)
+    {
+        tbl_size = n;
+        chains = new symbol_info*[n]();
+    }
+    symbol_info* Lookup_in_scope(int name)
+    {
+        symbol_info *curr_sym = chains[hash_func(name)];
+        while(curr_sym != NULL && curr_sym->getnameid() != name) curr_sym = curr_sym->get_next();
+        return curr_sym;
+    }
+    bool Insert_in_scope(int name, sym_kind type)
+    {
+        int hash_val = hash_func(name);
+        symbol_info *buffer = NULL, *curr_sym = chains[hash_val];
+        while(curr_sym != NULL)
+        {
+            if(curr_sym->getnameid() == name) return false;
+            buffer = curr_sym;
+            curr_sym = curr_sym->get_next();
+        }
+        if(buffer == NULL) chains[hash_val] = new symbol_info(name,type);
+        else buffer->set_next(new symbol_info(name,type));
+        return true;
+    }
+    bool Delete_from_scope(int name)
+    {
+        int hash_val = hash_func(name);
+        symbol_info *buffer = NULL, *curr_sym = chains[hash_val];
+        while(curr_sym != NULL && curr_sym->getnameid() != name)
+        {
+            buffer = curr_sym;
+            curr_sym = curr_sym->get_next();
+        }
+        if(curr_sym == NULL) return false;
+        if(buffer == NULL) chains[hash_val] = curr_sym->get_next();
+        else buffer->set_next(curr_sym->get_next());
+        curr_sym->set_next(NULL);
+        delete curr_sym;
+        return true;
+    }
+    ~chained_scope_table()
+    {
+        for(int i = 0; i < tbl_size; i++)
+        {
+            while(chains[i] != NULL)
+            {
+                symbol_info *next = chains[i]->get_next();
+                delete chains[i];
+                chains[i] = next;
+            }
+        }
+        delete[] chains;
+    }
+};
+
+// The old symbol_table: one chained table per scope, lookups walk outwards scope by scope
+class chained_symbol_table
+{
+private:
+    vector<chained_scope_table*> scopes;
+public:
+    void enter_scope() { scopes.push_back(new chained_scope_table(10)); }
+    void exit_scope() { delete scopes.back(); scopes.pop_back(); }
+    bool Insert_in_table(int name, sym_kind type) { return scopes.back()->Insert_in_scope(name, type); }
+    bool Remove_from_table(int name) { return scopes.back()->Delete_from_scope(name); }
+    symbol_info* Lookup_in_table(int name)
+    {
+        for(int i = scopes.size()-1; i >= 0; i--)
+        {
+            symbol_info *sym = scopes[i]->Lookup_in_scope(name);
+            if(sym != NULL) return sym;
+        }
+        return NULL;
+    }
+    ~chained_symbol_table() { while(!scopes.empty()) exit_scope(); }
+};
+
+// Both tables behind the same calls; the flat one has logging off
+struct flat_table
+{
+    symbol_table table;
+    log_sink sink{LOG_OFF};
+    void enter_scope() { table.enter_scope(sink); }
+    void exit_scope() { table.exit_scope(sink); }
+    bool Insert_in_table(int name, sym_kind type) { return table.Insert_in_table(name, type) != NULL; }
+    bool Remove_from_table(int name) { return table.Remove_from_table(name); }
+    symbol_info* Lookup_in_table(int name) { return table.Lookup_in_table(name); }
+};
+
+using clk = chrono::steady_clock;
+
+static double ns(clk::time_point a, clk::time_point b, size_t ops)
+{
+    return chrono::duration<double, nano>(b - a).count() / ops;
+}
+
+// One scope holding every symbol
+template <typename Table>
+void run_flat(const char* label, const vector<int>& ids, const vector<int>& misses, int rounds)
+{
+    Table table;
+    table.enter_scope();
+
+    auto t0 = clk::now();
+    for(int id : ids) table.Insert_in_table(id, SYM_ID);
+    auto t1 = clk::now();
+    size_t found = 0;
+    for(int r = 0; r < rounds; r++)
+        for(int id : ids) found += table.Lookup_in_table(id) != NULL;
+    auto t2 = clk::now();
+    for(int r = 0; r < rounds; r++)
+        for(int id : misses) found += table.Lookup_in_table(id) != NULL;
+    auto t3 = clk::now();
+    for(size_t i = 0; i < ids.size(); i += 2) table.Remove_from_table(ids[i]);
+    auto t4 = clk::now();
+
+    if(found != ids.size() * rounds) cout<<"unexpected lookup result"<<endl;
+    printf("%-22s insert %8.1f ns  hit %8.1f ns  miss %8.1f ns  delete %8.1f ns\n", label,
+           ns(t0, t1, ids.size()), ns(t1, t2, ids.size() * rounds),
+           ns(t2, t3, misses.size() * rounds), ns(t3, t4, (ids.size() + 1) / 2));
+}
+
+// Globals in the outermost scope, a few locals per block, lookups from the innermost block
+template <typename Table>
+void run_nested(const char* label, const vector<int>& ids, int depth, int rounds)
+{
+    Table table;
+    int globals = ids.size() / 2;
+    int per_scope = (ids.size() - globals) / depth;
+
+    auto t0 = clk::now();
+    table.enter_scope();
+    for(int i = 0; i < globals; i++) table.Insert_in_table(ids[i], SYM_ID);
+    for(int d = 0; d < depth; d++)
+    {
+        table.enter_scope();
+        for(int i = 0; i < per_scope; i++) table.Insert_in_table(ids[globals + d*per_scope + i], SYM_ID);
+    }
+    auto t1 = clk::now();
+    size_t found = 0;
+    for(int r = 0; r < rounds; r++)
+        for(int i = 0; i < globals; i++) found += table.Lookup_in_table(ids[i]) != NULL;
+    auto t2 = clk::now();
+    for(int d = 0; d <= depth; d++) table.exit_scope();
+    auto t3 = clk::now();
+
+    if(found != (size_t)globals * rounds) cout<<"unexpected lookup result"<<endl;
+    printf("%-22s build %8.1f ns  global hit %8.1f ns  unwind %8.1f ns\n", label,
+           ns(t0, t1, globals + depth*per_scope), ns(t1, t2, (size_t)globals * rounds),
+           ns(t2, t3, globals + depth*per_scope));
+}
+
+int main(int argc, char *argv[])
+{
+    int n = argc > 1 ? atoi(argv[1]) : 5000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 20;
+    int depth = argc > 3 ? atoi(argv[3]) : 16;
+
+    // identifiers like a compiler sees: short names, anagrams (ab/ba) and numbered temporaries
+    vector<int> ids, misses;
+    for(int i = 0; i < n; i++)
+    {
+        string name;
+        if(i % 3 == 0) name = "var" + to_string(i);
+        else if(i % 3 == 1) { name = to_string(i); reverse(name.begin(), name.end()); name = "x" + name; }
+        else name = string(1, 'a' + i % 26) + string(1, 'a' + (i / 26) % 26) + to_string(i / 676);
+        ids.push_back(names.intern(name));
+        misses.push_back(names.intern("missing_" + to_string(i)));
+    }
+
+    cout<<n<<" symbols, "<<rounds<<" lookup rounds, one scope"<<endl;
+    run_flat<chained_symbol_table>("chained (10 buckets)", ids, misses, rounds);
+    run_flat<flat_table>("flat symbol_table", ids, misses, rounds);
+
+    cout<<endl<<"globals looked up from "<<depth<<" nested scopes"<<endl;
+    run_nested<chained_symbol_table>("chained (10 buckets)", ids, depth, rounds);
+    run_nested<flat_table>("flat symbol_table", ids, depth, rounds);
+    return 0;
+}
@@ -0,0 +1,142 @@
+#ifndef COMPILE_CONTEXT_H
+#define COMPILE_CONTEXT_H
+
+#include "ast.h"
+#include "log_sink.h"
+#include "symbol_table.h"
+#include "tac_cache.h"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+
+class ThreeAddrCodeGenerator;
+
+// What the driver asks of every compilation
+struct compile_options
+{
+    log_level level = LOG_FULL;
+    bool emit_text = true, emit_binary = false, emit_asm = false, emit_c = false;
+    int opt_level = 1; //0 emits the straight translation of the AST
+    int codegen_jobs = 1; //threads generating and optimizing the functions of one file
+    string cache_dir; //function code cache (tac_cache.h), empty for none
+    uintmax_t cache_bytes = 256u << 20; //the cache is trimmed to this size after compiling
+    bool stream = false; //generate every unit as soon as it is parsed and free it
+};
+
+// Everything one compilation owns: its input, the parser's working state, the symbol table
+// and the output files. The parser and the scanner are reentrant and reach it through their
+// extra argument, so any number of files can be compiled at once, one per thread. The
+// interner and the arena are per thread (see interner.h and arena.h); a compilation resets
+// them when it starts and releases them when it is done.
+class compile_context
+{
+public:
+    string input; //path of the source file
+    string output_prefix; //every output file is named output_prefix + its usual name
+    compile_options options;
+    ostringstream console; //what the compilation reports, printed by the driver
+
+    string source_text; //whole input, grammar symbols refer into it by span
+    int src_offset = 0; //byte offset of the current token in the input
+    int lines = 1;
+    int errors = 0;
+    vector<source_span> tokens; //every token but whitespace, recorded only when caching
+
+    log_sink outlog; //log.txt, written at the level chosen on the command line
+    log_sink outerror; //error.txt, always written
+    ofstream outcode; //code.txt, three-address code as text
+    ofstream outbin; //code.tac, three-address code in binary form
+    ofstream outasm; //code.s, x86-64 assembly
+    ofstream outc; //code.c, C translation
+
+    unique_ptr<symbol_table> symtbl = make_unique<symbol_table>();
+    ProgramNode* ast_root = compile_arena.make<ProgramNode>();
+
+    ThreeAddrCodeGenerator* streamer = NULL; //set with --stream, takes each unit as it is reduced
+    arena::position unit_mark; //with --stream, where the arena stood before the current unit
+    int folded = 0; //AST nodes removed by constant folding while streaming
+
+    vector<pair<int,int>> varlist; //for variable declarartion list : interned name, array size (0 for normal variable)
+    vector<data_type>paramlist; //for parameter list fot func dec and func def
+    vector<int>paramname; //for func def, interned names (0 if not given)
+    vector<data_type>arglist; //to store types of function argument
+    vector<tac_slot> global_slots; //variables of the global scope, in declaration order
+    vector<tac_slot> func_slots; //parameters and locals of the function being parsed
+
+    int is_func = 0; //is compound statement in function definition
+
+    data_type ret_type = TYPE_NONE, func_ret_type = TYPE_NONE;
+    int func_name = 0;
+
+    compile_context(const string& input, const string& output_prefix, const compile_options& options)
+        : input(input), output_prefix(output_prefix), options(options) {}
+
+    string output_name(const char* name) const
+    {
+        return output_prefix + name;
+    }
+
+    string_view span_text(const source_span& span) const //source text of a grammar symbol, only materialized for logging
+    {
+        return string_view(source_text).substr(span.offset, span.length);
+    }
+
+    void assign_slot(symbol_info *sym) //number a newly declared variable among the globals or its function's variables
+    {
+        vector<tac_slot>& slots = symtbl->getID() == 1 ? global_slots : func_slots;
+        sym->setslot(slots.size());
+        slots.push_back({sym->getnameid(), sym->getvartype(), sym->getarraysize()});
+    }
+
+    string function_cache_key(const source_span& span) //of the function defined at span, see tac_cache.h
+    {
+        tac_cache_key key;
+        key.add((int64_t)tac_cache_version);
+        key.add((int64_t)tac_file_version);
+        key.add((int64_t)options.opt_level);
+        auto first = lower_bound(tokens.begin(), tokens.end(), span.offset,
+                                 [](const source_span& t, int offset) { return t.offset < offset; });
+        vector<string_view> identifiers;
+        unordered_set<string_view> seen;
+        for (auto t = first; t != tokens.end() && t->offset < span.offset + span.length; ++t) {
+            string_view text = span_text(*t);
+            key.add(text);
+            if ((isalpha((unsigned char)text[0]) || text[0] == '_') && seen.insert(text).second) identifiers.push_back(text);
+        }
+        //the function's code also depends on what it refers to outside itself
+        for (string_view name : identifiers) {
+            symbol_info *sym = symtbl->Lookup_in_table(names.intern(name));
+            if (sym == NULL) continue;
+            key.add(name);
+            key.add((int64_t)sym->getidtype());
+            key.add((int64_t)sym->getvartype());
+            key.add((int64_t)sym->getslot());
+            key.add((int64_t)sym->getarraysize());
+            for (data_type p : sym->getparamlist()) key.add((int64_t)p);
+            key.add((int64_t)sym->getparamlist().size());
+        }
+        return key.hex();
+    }
+
+    void reset_declaration_state() //after a syntax error, drop what the broken declaration collected
+    {
+        varlist.clear();
+        paramlist.clear();
+        paramname.clear();
+        arglist.clear();
+        is_func = 0;
+        ret_type = TYPE_NONE;
+        func_name = 0;
+        func_ret_type = TYPE_NONE;
+    }
+};
+
+#endif // COMPILE_CONTEXT_H
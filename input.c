@@ -1,3 +1,5 @@
+float x, y;
+
 int func(int a, float b) {
     return a+b;
 }
@@ -10,4 +12,6 @@ void main () {
     c = func(a, b);
 
     float d;
+    y = -2.5;
+    x = -y;
 }
\ No newline at end of file
@@ -0,0 +1,53 @@
+#ifndef INTERNER_H
+#define INTERNER_H
+
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// Stores every distinct identifier once and names it by a dense integer id,
+// so name comparisons are integer compares and symbols do not own string copies.
+// Id 0 is always the empty string.
+class string_interner
+{
+private:
+    deque<string> storage; // deque keeps the strings in place as it grows
+    vector<const string*> by_id;
+    unordered_map<string_view, int> ids;
+public:
+    string_interner()
+    {
+        intern("");
+    }
+
+    int intern(string_view text)
+    {
+        auto it = ids.find(text);
+        if(it != ids.end()) return it->second;
+
+        storage.emplace_back(text);
+        int id = by_id.size();
+        by_id.push_back(&storage.back());
+        ids.emplace(string_view(storage.back()), id);
+        return id;
+    }
+
+    const string& str(int id) const
+    {
+        return *by_id[id];
+    }
+
+    int size() const
+    {
+        return by_id.size();
+    }
+};
+
+// Interner of the compilation running on this thread, defined by the parser
+extern thread_local string_interner names;
+
+#endif // INTERNER_H
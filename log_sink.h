@@ -0,0 +1,157 @@
+#ifndef LOG_SINK_H
+#define LOG_SINK_H
+
+#include <charconv>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+// How much a compile writes to its log, each level includes the ones before it
+enum log_level { LOG_OFF, LOG_ERRORS, LOG_RULES, LOG_FULL };
+
+// Parses "off", "errors", "rules" or "full"; returns false for anything else
+inline bool parse_log_level(string_view s, log_level& level)
+{
+    if (s == "off") level = LOG_OFF;
+    else if (s == "errors") level = LOG_ERRORS;
+    else if (s == "rules") level = LOG_RULES;
+    else if (s == "full") level = LOG_FULL;
+    else return false;
+    return true;
+}
+
+// Streams into sink only when it is enabled for level; otherwise the whole << chain,
+// formatting included, is skipped
+#define LOG_IF(sink, level) if (!(sink).enabled(level)) ; else (sink)
+
+// Buffered output file drained by a background writer thread.
+// Text is formatted into a large in-memory buffer; full buffers are handed to the writer
+// and recycled once written, so the compiler thread only waits on the disk when it is
+// max_pending buffers ahead. endl only ends the line, nothing is flushed before close().
+class log_sink {
+    private:
+        static const size_t buffer_size = 1 << 20;
+        static const size_t max_pending = 8;
+
+        FILE* file = nullptr;
+        log_level level;
+        string buf;
+
+        thread writer;
+        mutex lock;
+        condition_variable ready; //a buffer is pending or the sink is closing
+        condition_variable space; //the writer took a pending buffer
+        deque<string> pending; //filled buffers, oldest first
+        vector<string> spare; //written buffers kept for their capacity
+        bool closing = false;
+
+        void drain() {
+            unique_lock<mutex> guard(lock);
+            while (true) {
+                ready.wait(guard, [this] { return closing || !pending.empty(); });
+                if (pending.empty()) return;
+                string out = std::move(pending.front());
+                pending.pop_front();
+                guard.unlock();
+                space.notify_one();
+                fwrite(out.data(), 1, out.size(), file);
+                out.clear();
+                guard.lock();
+                spare.push_back(std::move(out));
+            }
+        }
+
+        void hand_off() {
+            string next;
+            {
+                unique_lock<mutex> guard(lock);
+                space.wait(guard, [this] { return pending.size() < max_pending; });
+                pending.push_back(std::move(buf));
+                if (!spare.empty()) {
+                    next = std::move(spare.back());
+                    spare.pop_back();
+                }
+            }
+            ready.notify_one();
+            buf = std::move(next);
+            buf.reserve(buffer_size);
+        }
+
+        void append(const char* s, size_t n) {
+            buf.append(s, n);
+            if (buf.size() >= buffer_size) hand_off();
+        }
+
+        template <typename T>
+        void append_number(T value) {
+            char tmp[32];
+            if constexpr (is_floating_point<T>::value) {
+                append(tmp, snprintf(tmp, sizeof(tmp), "%g", (double)value)); //same digits as ostream
+            } else {
+                auto res = to_chars(tmp, tmp + sizeof(tmp), value);
+                append(tmp, res.ptr - tmp);
+            }
+        }
+
+    public:
+        log_sink(log_level level = LOG_FULL) : level(level) {}
+        log_sink(const log_sink&) = delete;
+        log_sink& operator=(const log_sink&) = delete;
+        ~log_sink() { close(); }
+
+        // Truncates path and starts the writer; nothing is written at LOG_OFF
+        bool open(const char* path) {
+            close();
+            file = fopen(path, "w");
+            if (!file) return false;
+            if (level != LOG_OFF) {
+                closing = false;
+                buf.reserve(buffer_size);
+                writer = thread(&log_sink::drain, this);
+            }
+            return true;
+        }
+
+        // Writes out everything buffered and closes the file
+        void close() {
+            if (writer.joinable()) {
+                if (!buf.empty()) hand_off();
+                {
+                    lock_guard<mutex> guard(lock);
+                    closing = true;
+                }
+                ready.notify_one();
+                writer.join();
+            }
+            if (file) fclose(file);
+            file = nullptr;
+            buf.clear();
+            spare.clear();
+        }
+
+        void set_level(log_level l) { level = l; } //takes effect at the next open()
+        log_level get_level() const { return level; }
+        bool enabled(log_level l) const { return l <= level && writer.joinable(); }
+
+        log_sink& operator<<(string_view s) { append(s.data(), s.size()); return *this; }
+        log_sink& operator<<(const char* s) { return *this << string_view(s); }
+        log_sink& operator<<(const string& s) { return *this << string_view(s); }
+        log_sink& operator<<(char c) { append(&c, 1); return *this; }
+
+        template <typename T, typename enable_if<is_arithmetic<T>::value && !is_same<T, bool>::value, int>::type = 0>
+        log_sink& operator<<(T value) { append_number(value); return *this; }
+
+        // endl and friends: a newline, never a flush
+        log_sink& operator<<(ostream& (*)(ostream&)) { append("\n", 1); return *this; }
+};
+
+#endif // LOG_SINK_H
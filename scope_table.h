@@ -1,55 +1,21 @@
 #include "symbol_info.h"
+#include "log_sink.h"
 
+// One open scope. Its symbols are the bindings symbol_table pushed after the scope was entered,
+// so a scope owns no storage of its own: entering one allocates nothing and leaving it pops them.
 class scope_table
 {
 private:
-    symbol_info** chains;
-    int tbl_size;
-    int num_chld = 0;
     int ID;
-    scope_table *parent_scope = NULL;
-    int hash_func(string symbol)
-    {
-        int sum = 0;
-        for (int i = 0; i < symbol.size(); i++)
-        {
-            sum += (int)symbol[i];
-        }
-        return sum%tbl_size;
-    }
+    int first_binding; //index of the scope's first symbol in the symbol table's binding log
+    int num_chld = 0;
 public:
-    scope_table(){}
-    scope_table(int n, int ID)
+    scope_table(int ID, int first)
     {
-        tbl_size = n;
-
-        chains = new symbol_info*[n];
-
-        for(int i = 0; i < n; i++)
-        {
-            chains[i] = NULL;
-        }
         this->ID = ID;
+        first_binding = first;
     }
 
-    void set_prnt(scope_table *table)
-    {
-        parent_scope = table;
-        if(parent_scope!=NULL) parent_scope->incrs_chld();
-        //set_scope_table_ID();
-    }
-
-    scope_table* get_prnt()
-    {
-        return parent_scope;
-    }
-
-    // void set_scope_table_ID()
-    // {
-    //     if(parent_scope) ID = parent_scope->getID()+"."+to_string(parent_scope->get_num_chld());
-    //     else ID = "1";
-    // }
-
     int get_num_chld()
     {
         return num_chld;
@@ -65,195 +31,63 @@ public:
         return ID;
     }
 
-    symbol_info* Lookup_in_scope(string name)
+    int get_first()
     {
-        int pos=0;
-        int hash_val = hash_func(name);
-        symbol_info *curr_sym = chains[hash_val];
-
-        while(curr_sym != NULL)
-        {
-            if (curr_sym->getname() == name)
-            {
-                return curr_sym;
-            }
-            else
-            {
-                pos++;
-                curr_sym = curr_sym->get_next();
-            }
-        }
-
-        return curr_sym;
+        return first_binding;
     }
 
-    bool Insert_in_scope(string name, string type)
+    void Print_scope(log_sink& outlog, symbol_info* const* syms, int count)
     {
-        int pos = 0;
-        symbol_info *new_sym = new symbol_info(name,type);
-
-        int hash_val = hash_func(name);
+    	string s = "";
+    	s+="ScopeTable # "+to_string(ID)+"\n";
+        //cout<<"ScopeTable # "<<ID<<endl;
 
-        if(chains[hash_val]==NULL)
-        {
-            chains[hash_val] = new_sym;
-            return true;
-        }
-        else
+        for(int i = 0; i < count; i++)
         {
-            if (chains[hash_val]->getname() == name)
-            {
-                return false;
-            }
+            s+=to_string(i)+" --> ";
+            //cout<<i<<" --> ";
 
-            pos++;
-            symbol_info *buffer = chains[hash_val];
-            symbol_info *curr_sym = chains[hash_val]->get_next();
-
-            while(true)
+            symbol_info *curr_sym = syms[i];
+            s+="\n< "+curr_sym->getname()+" : "+sym_kind_name(curr_sym->gettype())+" >\n";
+            if (curr_sym->getidtype() == ID_FUNC_DEF)
             {
-                if(curr_sym == NULL)
-                {
-                    buffer->set_next(new_sym);
-                    return true;
-                }
-                else
+                const vector<data_type>& params = curr_sym->getparamlist();
+                const vector<int>& param_names = curr_sym->getparamname();
+                s+="Function Definition\n";
+                s+=string("Return Type: ")+type_name(curr_sym->getvartype())+"\n";
+                s+="Number of Parameters: "+to_string(params.size())+"\n";
+                s+="Parameter Details: ";
+                for(int i = 0; i<params.size(); i++)
                 {
-                    if (curr_sym->getname() == name)
-                    {
-                        return false;
-                    }
-                    pos++;
-                    buffer = curr_sym;
-                    curr_sym = curr_sym->get_next();
+                    s+=string(type_name(params[i])) + " " + names.str(param_names[i]);
+                    if(i!=params.size()-1) s+=", ";
                 }
+                //cout<<"Function Definition"<<endl;
             }
-        }
-    }
-
-    bool Delete_from_scope(string name)
-    {
-        int pos = 0;
-        int hash_val = hash_func(name);
-        symbol_info *curr_sym = chains[hash_val];
-
-
-        if(curr_sym == NULL)
-        {
-            return false;
-        }
-
-        else if (curr_sym->getname() == name)
-        {
-            chains[hash_val] = curr_sym->get_next();
-            curr_sym->set_next(NULL);
-            delete curr_sym;
-            curr_sym = NULL;
-            return true;
-        }
-
-        else
-        {
-            pos++;
-            symbol_info *buffer = curr_sym;
-            curr_sym = curr_sym->get_next();
-            while(curr_sym!=NULL)
+            else if (curr_sym->getidtype() == ID_VAR)
             {
-                if (curr_sym->getname() == name)
-                {
-                    buffer->set_next(curr_sym->get_next());
-                    curr_sym->set_next(NULL);
-                    delete curr_sym;
-                    curr_sym = NULL;
-                    return true;
-                }
-                else
-                {
-                    pos++;
-                    buffer = curr_sym;
-                    curr_sym = curr_sym->get_next();
-                }
+                s+="Variable\n";
+                s+=string("Type: ")+type_name(curr_sym->getvartype())+"\n";
+                //cout<<"Variable"<<endl;
             }
-            return false;
-        }
-    }
-
-    void Print_scope(ofstream& outlog)
-    {
-    	string s = "";
-    	s+="ScopeTable # "+to_string(ID)+"\n";
-        //cout<<"ScopeTable # "<<ID<<endl;
-
-        for(int i = 0; i < tbl_size; i++)
-        {
-            if(chains[i]!=NULL)
+            else if (curr_sym->getidtype() == ID_ARRAY)
             {
-            	s+=to_string(i)+" --> ";
-            	//cout<<i<<" --> ";
-
-		        symbol_info *curr_sym = chains[i];
-
-		        while(curr_sym!=NULL)
-		        {
-		        	s+="\n< "+curr_sym->getname()+" : "+curr_sym->gettype()+" >\n";
-                    if (curr_sym->getidtype() == "func_def")
-                    {
-                        s+="Function Definition\n";
-                        s+="Return Type: "+curr_sym->getvartype()+"\n";
-                        s+="Number of Parameters: "+to_string(curr_sym->getparamlist().size())+"\n";
-                        s+="Parameter Details: ";
-                        for(int i = 0; i<curr_sym->getparamlist().size(); i++)
-                        {
-                            s+=curr_sym->getparamlist()[i] + " " + curr_sym->getparamname()[i];
-                            if(i!=curr_sym->getparamlist().size()-1) s+=", ";
-                        }
-                        //cout<<"Function Definition"<<endl;
-                    }
-                    else if (curr_sym->getidtype() == "var")
-                    {
-                        s+="Variable\n";
-                        s+="Type: "+curr_sym->getvartype()+"\n";
-                        //cout<<"Variable"<<endl;
-                    }
-                    else if (curr_sym->getidtype() == "array")
-                    {
-                        s+="Array\n";
-                        s+="Type: "+curr_sym->getvartype()+"\n";
-                        s+="Size: "+to_string(curr_sym->getarraysize())+"\n";
-                        //cout<<"Array"<<endl;
-                    }
-                    else
-                    {
-                        s+="Error\n";
-                        //cout<<"Error"<<endl;
-                    }
-		            //cout<<"< "<<curr_sym->getname()<<" : "<<curr_sym->gettype()<<" > ";
-		            curr_sym = curr_sym->get_next();
-		        }
-				s+="\n";
-		        //cout<<endl;
+                s+="Array\n";
+                s+=string("Type: ")+type_name(curr_sym->getvartype())+"\n";
+                s+="Size: "+to_string(curr_sym->getarraysize())+"\n";
+                //cout<<"Array"<<endl;
+            }
+            else
+            {
+                s+="Error\n";
+                //cout<<"Error"<<endl;
             }
+            s+="\n";
+            //cout<<endl;
         }
 		s+="\n";
 		outlog<<s;
         //cout<<endl;
         //return s;
     }
-
-    ~scope_table()
-    {
-        //cout<<"delete scope"<<endl;
-        for(int i = 0; i<tbl_size; i++)
-        {
-            while(chains[i]!=NULL)
-            {
-                symbol_info *buffer = chains[i];
-                chains[i] = chains[i]->get_next();
-                buffer->set_next(NULL);
-                delete buffer;
-                buffer = NULL;
-            }
-        }
-        delete[] chains;
-    }
-};
\ No newline at end of file
+};
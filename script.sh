@@ -1,19 +1,21 @@
 #!/bin/bash
 
 # First pass: Generate AST and symbol table
-yacc -d -y --debug --verbose 21201139_23341101.y
+yacc -d -y -Wno-yacc --debug --verbose 21201139_23341101.y
 echo 'Generated the parser C file and header file'
-g++ -w -c -o y.o y.tab.c
+g++ -O2 -w -c -o y.o y.tab.c
 echo 'Generated the parser object file'
 flex 21201139_23341101.l
 echo 'Generated the scanner C file'
-g++ -fpermissive -w -c -o l.o lex.yy.c
+g++ -O2 -fpermissive -w -c -o l.o lex.yy.c
 echo 'Generated the scanner object file'
-g++ y.o l.o -o two_pass_compiler
+g++ y.o l.o -o two_pass_compiler -pthread
+g++ -O2 -I. tools/tacvm.cpp -o tacvm
+echo 'Built the TAC virtual machine'
 echo 'All ready, running the two-pass compiler...'
 
 # Run the compiler on the input file
-./two_pass_compiler input.c
+./two_pass_compiler --emit=both,asm,c input.c
 echo 'Compilation completed.'
 
 # Display output files
@@ -22,4 +24,15 @@ cat log.txt
 echo '------------ Error output ------------'
 cat error.txt
 echo '------------ Three Address Code ------------'
-cat code.txt
\ No newline at end of file
+cat code.txt
+echo
+echo '------------ Running the TAC ------------'
+./tacvm code.tac
+echo
+echo '------------ Running the native build ------------'
+gcc code.s -o program && ./program
+echo "main returned $?"
+echo
+echo '------------ Running the C translation ------------'
+gcc -O2 code.c -o program_c && ./program_c
+echo "main returned $?"
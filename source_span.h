@@ -0,0 +1,15 @@
+#ifndef SOURCE_SPAN_H
+#define SOURCE_SPAN_H
+
+// Location of a grammar symbol in the input buffer, used as the bison location type.
+// Keeping only offsets lets the parser log a symbol's text without rebuilding it.
+struct source_span
+{
+    int offset;
+    int length;
+};
+
+#define YYLTYPE source_span
+#define YYLTYPE_IS_DECLARED 1
+
+#endif // SOURCE_SPAN_H
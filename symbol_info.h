@@ -2,29 +2,59 @@
 #define SYMBOL_INFO_H
 
 #include <bits/stdc++.h>
+#include "source_span.h"
+#include "types.h"
+#include "interner.h"
 using namespace std;
 
 // Forward declaration of ASTNode
 class ASTNode;
 
+// What a symbol_info stands for: a declared name or a grammar symbol (tokens are token_value, see token.h)
+enum sym_kind : unsigned char
+{
+    SYM_ID, SYM_TYPE,
+    SYM_PROGRAM, SYM_UNIT, SYM_FUNC_DEF, SYM_PARAM_LIST, SYM_COMP_STMNT, SYM_VAR_DEC,
+    SYM_STMNTS, SYM_STMNT, SYM_EXPR_STMT, SYM_VARBL, SYM_EXPR, SYM_LGC_EXPR, SYM_REL_EXPR,
+    SYM_SIMP_EXPR, SYM_TERM, SYM_UN_EXPR, SYM_FCTR, SYM_ARG_LIST, SYM_ARG
+};
+
+inline const char* sym_kind_name(sym_kind kind)
+{
+    static const char* kind_names[] = {
+        "ID", "type",
+        "program", "unit", "func_def", "param_list", "comp_stmnt", "var_dec",
+        "stmnts", "stmnt", "expr_stmt", "varbl", "expr", "lgc_expr", "rel_expr",
+        "simp_expr", "term", "un_expr", "fctr", "arg_list", "arg"
+    };
+    return kind_names[kind];
+}
+
 class symbol_info
 {
 private:
-    string sym_name;
-    string sym_type;
-    string ID_type; //var, array, func_dec, func_def
-    string var_type; //int, float, void, error
+    int sym_name; //interned name
+    sym_kind sym_type;
+    id_kind ID_type; //var, array, func_dec, func_def
+    data_type var_type; //int, float, void, error
     int array_size;
-    vector<string> param_list;//for functions
-    vector<string> param_name;
-    symbol_info *next_sym;
+    int scope_id; //scope that declared the symbol
+    int slot; //variable's index among its function's slots, or among the globals
+    vector<data_type> param_list;//for functions
+    vector<int> param_name; //interned, 0 if the parameter is unnamed
+    symbol_info *next_sym; //binding of the same name this one shadows
     ASTNode* ast_node; // Pointer to AST node
 public:
     //symbol_info(){}
-    symbol_info(string name, string type)
+    symbol_info(int name, sym_kind type)
     {
         sym_name = name;
         sym_type = type;
+        ID_type = ID_NONE;
+        var_type = TYPE_NONE;
+        array_size = 0;
+        scope_id = 0;
+        slot = -1;
         next_sym = NULL;
         ast_node = NULL;
     }
@@ -39,31 +69,35 @@ public:
         return next_sym;
     }
 
-    string getname()
+    int getnameid()
     {
         return sym_name;
     }
-    string gettype()
+    const string& getname()
+    {
+        return names.str(sym_name);
+    }
+    sym_kind gettype()
     {
         return sym_type;
     }
     
-    string getvartype()
+    data_type getvartype()
     {
         return var_type;
     }
     
-    void setvartype(string tp)
+    void setvartype(data_type tp)
     {
     	var_type = tp;
     }
     
-    string getidtype()
+    id_kind getidtype()
     {
         return ID_type;
     }
     
-    void setidtype(string tp)
+    void setidtype(id_kind tp)
     {
     	ID_type = tp;
     }
@@ -78,26 +112,46 @@ public:
     	array_size = sz;
     }
     
-    void setparamlist(vector<string> list)
+    void setparamlist(const vector<data_type>& list)
     {
     	param_list = list;
     }
     
-    vector<string> getparamlist()
+    const vector<data_type>& getparamlist()
     {
     	return param_list;
     }
     
-    vector<string> getparamname()
+    const vector<int>& getparamname()
     {
     	return param_name;
     }
     
-    void setparamname(vector<string> list)
+    void setparamname(const vector<int>& list)
     {
     	param_name = list;
     }
     
+    int getscope()
+    {
+        return scope_id;
+    }
+    
+    void setscope(int id)
+    {
+    	scope_id = id;
+    }
+    
+    int getslot()
+    {
+        return slot;
+    }
+    
+    void setslot(int s)
+    {
+    	slot = s;
+    }
+    
     int getparamsize()
     {
     	return param_list.size();
@@ -116,11 +170,11 @@ public:
 
     ~symbol_info()
     {
-        delete next_sym;
+        // next_sym is still owned by its own scope
         param_list.clear();
         param_name.clear();
         // Don't delete ast_node here - will be managed separately
     }
 };
 
-#endif // SYMBOL_INFO_H
\ No newline at end of file
+#endif // SYMBOL_INFO_H
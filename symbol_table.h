@@ -1,67 +1,162 @@
 #include "scope_table.h"
 
+// Flat scoped symbol table: one hash map from an interned name to its innermost binding.
+// A binding links to the one it shadows through next_sym, and every binding is also pushed
+// on a log, so leaving a scope just pops the scope's own bindings and restores what they hid.
+// Lookup costs the same at any nesting depth.
 class symbol_table
 {
 private:
-    scope_table *curr_scope = NULL;
+    vector<scope_table> scopes; //open scopes, innermost last
+    vector<symbol_info*> bindings; //live symbols in insertion order, scope after scope
+    symbol_info** slots = NULL; //innermost binding of each name, open addressing with linear probing
+    int tbl_size = 0; //always a power of two
+    int num_names = 0;
     int scope_size = 10;
     int ID = 0;
+    unsigned hash_func(int name)
+    {
+        //FNV-1a over the bytes of the interned id
+        unsigned hash = 2166136261u;
+        for (int i = 0; i < 4; i++)
+        {
+            hash ^= (name >> (8*i)) & 0xff;
+            hash *= 16777619u;
+        }
+        return hash & (tbl_size-1);
+    }
+    int find_slot(int name) //slot holding name, or the empty slot ending its probe sequence
+    {
+        int i = hash_func(name);
+        while(slots[i] != NULL && slots[i]->getnameid() != name)
+        {
+            i = (i+1) & (tbl_size-1);
+        }
+        return i;
+    }
+    void grow()
+    {
+        symbol_info **old = slots;
+        int old_size = tbl_size;
+
+        tbl_size *= 2;
+        slots = new symbol_info*[tbl_size]();
+        for(int i = 0; i < old_size; i++)
+        {
+            if(old[i] != NULL) slots[find_slot(old[i]->getnameid())] = old[i];
+        }
+        delete[] old;
+    }
+    void unbind(symbol_info *symbol) //make the binding symbol shadowed visible again
+    {
+        int pos = find_slot(symbol->getnameid());
+        if(symbol->get_next() != NULL)
+        {
+            slots[pos] = symbol->get_next();
+            return;
+        }
+
+        slots[pos] = NULL;
+        num_names--;
+
+        //shift back later entries of the probe run so lookups never stop at the hole
+        int hole = pos;
+        int i = (pos+1) & (tbl_size-1);
+        while(slots[i] != NULL)
+        {
+            int home = hash_func(slots[i]->getnameid());
+            if(((i-home) & (tbl_size-1)) >= ((i-hole) & (tbl_size-1)))
+            {
+                slots[hole] = slots[i];
+                slots[i] = NULL;
+                hole = i;
+            }
+            i = (i+1) & (tbl_size-1);
+        }
+    }
 public:
 	int getID()
 	{
-		return curr_scope->getID();
+		return scopes.back().getID();
 	}
     void set_size(int n)
     {
         scope_size = n;
     }
-    void enter_scope(ofstream& outlog)
+    void enter_scope(log_sink& outlog)
     {
+        if(slots == NULL)
+        {
+            tbl_size = 8;
+            while(tbl_size < scope_size) tbl_size *= 2;
+            slots = new symbol_info*[tbl_size]();
+        }
+
         ID+=1;
-        scope_table *new_scope = new scope_table(scope_size, ID);
-        new_scope->set_prnt(curr_scope);
-        curr_scope = new_scope;
-        outlog<<"New ScopeTable with ID "<<curr_scope->getID()<<" created"<<endl<<endl;
-        //if(new_scope->getID() != "1")cout<<curr_scope->getID()<<" "<<(curr_scope->get_prnt())->getID()<<endl;
+        if(!scopes.empty()) scopes.back().incrs_chld();
+        scopes.push_back(scope_table(ID, bindings.size()));
+        LOG_IF(outlog, LOG_FULL)<<"New ScopeTable with ID "<<ID<<" created"<<endl<<endl;
     }
 
-    void exit_scope(ofstream& outlog)
+    void exit_scope(log_sink& outlog)
     {
-    	outlog<<"Scopetable with ID "<<curr_scope->getID()<<" removed"<<endl<<endl;
-        scope_table *buffer = curr_scope;
-        curr_scope = curr_scope->get_prnt();
-        delete buffer;
-        buffer = NULL;
-        //cout<<curr_scope->getID()<<endl;
+    	LOG_IF(outlog, LOG_FULL)<<"Scopetable with ID "<<scopes.back().getID()<<" removed"<<endl<<endl;
+        size_t first = scopes.back().get_first();
+        while(bindings.size() > first)
+        {
+            symbol_info *symbol = bindings.back();
+            bindings.pop_back();
+            unbind(symbol);
+            delete symbol;
+        }
+        scopes.pop_back();
     }
 
-    bool Insert_in_table(string name, string type)
+    //returns the new symbol, or NULL if the name is already declared in the current scope
+    symbol_info* Insert_in_table(int name, sym_kind type)
     {
-        if(curr_scope->Insert_in_scope(name,type)) return true;
-        else return false;
-    }
+        int pos = find_slot(name);
+        symbol_info *shadowed = slots[pos];
+        if(shadowed != NULL && shadowed->getscope() == getID())
+        {
+            return NULL;
+        }
 
-    bool Remove_from_table(string name)
-    {
-        if(curr_scope->Delete_from_scope(name)) return true;
-        else return false;
+        if(shadowed == NULL && (num_names+1)*4 > tbl_size*3) //keep the load factor under 3/4
+        {
+            grow();
+            pos = find_slot(name);
+        }
+        if(shadowed == NULL) num_names++;
+
+        symbol_info *symbol = new symbol_info(name, type);
+        symbol->setscope(getID());
+        symbol->set_next(shadowed);
+        slots[pos] = symbol;
+        bindings.push_back(symbol);
+        return symbol;
     }
 
-    symbol_info* Lookup_in_table(string name)
+    bool Remove_from_table(int name)
     {
-        symbol_info *symbol = curr_scope->Lookup_in_scope(name);
-        scope_table *buffer_scope = curr_scope->get_prnt();
-        if(symbol==NULL)
+        symbol_info *symbol = slots[find_slot(name)];
+        if(symbol == NULL || symbol->getscope() != getID())
         {
-            while(buffer_scope!=NULL)
-            {
-                symbol = buffer_scope->Lookup_in_scope(name);
-                if(symbol!=NULL) return symbol;
-                buffer_scope = buffer_scope->get_prnt();
-            }
+            return false;
         }
-        
-        return symbol;
+
+        unbind(symbol);
+        //linear in the scope, but only a function defined inside another one is removed, which is
+        //an error; erasing keeps the scope's bindings in declaration order for Print_scope
+        bindings.erase(find(bindings.begin() + scopes.back().get_first(), bindings.end(), symbol));
+        delete symbol;
+        return true;
+    }
+
+    symbol_info* Lookup_in_table(int name)
+    {
+        if(slots == NULL) return NULL; //no scope entered yet
+        return slots[find_slot(name)];
     }
 
     void Print_current_scope()
@@ -69,22 +164,24 @@ public:
         //curr_scope->Print_scope();
     }
 
-    void Print_all_scope(ofstream& outlog)
+    void Print_all_scope(log_sink& outlog)
     {
+        if(!outlog.enabled(LOG_FULL)) return;
         outlog<<"################################"<<endl<<endl;
-        scope_table *buffer = curr_scope;
-
-        while(buffer!=NULL)
+        int end = bindings.size();
+        for(int i = scopes.size()-1; i >= 0; i--)
         {
-            buffer->Print_scope(outlog);
-            buffer = buffer->get_prnt();
+            int first = scopes[i].get_first();
+            scopes[i].Print_scope(outlog, bindings.data()+first, end-first);
+            end = first;
         }
         outlog<<"################################"<<endl<<endl;
     }
 
     ~symbol_table()
     {
-        delete curr_scope;
+        for(auto symbol : bindings) delete symbol;
+        delete[] slots;
     }
 
 };
@@ -0,0 +1,322 @@
+#ifndef TAC_H
+#define TAC_H
+
+#include <algorithm>
+#include <charconv>
+#include <string_view>
+#include <string>
+#include <vector>
+#include "types.h"
+#include "interner.h"
+
+using namespace std;
+
+// Three-address code kept in memory as quadruples: an opcode and up to three operands.
+// Code generation appends quads to a tac_program; passes can rewrite them before
+// the whole program is printed as text in one go.
+
+enum tac_opcode : unsigned char {
+    TAC_COPY,     // dst = a
+    TAC_ADD, TAC_SUB, TAC_MUL, TAC_DIV, TAC_MOD,  // dst = a op b
+    TAC_SHL,      // dst = a << b, ints only
+    TAC_LT, TAC_GT, TAC_LE, TAC_GE, TAC_EQ, TAC_NE,
+    TAC_AND, TAC_OR,
+    TAC_NEG,      // dst = -a
+    TAC_NOT,      // dst = !a
+    TAC_ITOF,     // dst = (float)a
+    TAC_FTOI,     // dst = (int)a
+    TAC_LOAD,     // dst = a[b]
+    TAC_STORE,    // dst[a] = b
+    TAC_LABEL,    // dst:
+    TAC_GOTO,     // goto dst
+    TAC_IF,       // if a goto dst
+    TAC_IFFALSE,  // ifFalse a goto dst
+    TAC_PARAM,    // param a
+    TAC_CALL,     // dst = call a, b
+    TAC_RETURN,   // return a
+    TAC_FUNC,     // start of function a, b is its index in tac_program::functions
+    TAC_DECL      // declaration of variable dst, a is the array size (0 for scalars)
+};
+
+enum operand_kind : unsigned char {
+    OPND_NONE,
+    OPND_TEMP,    // value is the temp number
+    OPND_VAR,     // value is the variable's slot in the enclosing function
+    OPND_INT,     // value is the constant itself
+    OPND_FLOAT,   // value indexes tac_program::floats
+    OPND_LABEL,   // value is the label number
+    OPND_FUNC,    // value is the interned function name
+    OPND_GLOBAL   // value indexes tac_program::globals
+};
+
+struct tac_operand {
+    operand_kind kind = OPND_NONE;
+    int value = 0;
+
+    tac_operand() {}
+    tac_operand(operand_kind k, int v) : kind(k), value(v) {}
+
+    bool is_none() const { return kind == OPND_NONE; }
+    bool operator==(const tac_operand& o) const { return kind == o.kind && value == o.value; }
+    bool operator!=(const tac_operand& o) const { return !(*this == o); }
+};
+
+inline tac_operand temp_operand(int n) { return tac_operand(OPND_TEMP, n); }
+inline tac_operand var_operand(int slot) { return tac_operand(OPND_VAR, slot); }
+inline tac_operand int_operand(int v) { return tac_operand(OPND_INT, v); }
+inline tac_operand label_operand(int n) { return tac_operand(OPND_LABEL, n); }
+
+struct tac_quad {
+    tac_opcode op;
+    data_type type; // type of the value the quad produces, or of the declared variable
+    tac_operand dst, a, b;
+};
+
+inline bool is_jump(tac_opcode op) { return op == TAC_GOTO || op == TAC_IF || op == TAC_IFFALSE; }
+
+// Opcodes that compute dst from a and b and do nothing else: no store, jump or call
+inline bool is_pure_def(tac_opcode op) { return op <= TAC_LOAD; }
+
+// The operand a quad assigns, or nullptr. Stores write array memory, not a scalar.
+inline tac_operand* quad_def(tac_quad& q) {
+    return is_pure_def(q.op) || q.op == TAC_CALL ? &q.dst : nullptr;
+}
+
+// Calls f on every operand whose value q reads; arrays count as read by their loads and stores.
+// Declarations, function names and labels are not reads.
+template <typename F>
+inline void for_each_use(tac_quad& q, F f) {
+    auto use = [&](tac_operand& o) { if (!o.is_none()) f(o); };
+    if (is_pure_def(q.op)) { use(q.a); use(q.b); }
+    else if (q.op == TAC_STORE) { use(q.dst); use(q.a); use(q.b); }
+    else if (q.op == TAC_IF || q.op == TAC_IFFALSE || q.op == TAC_PARAM || q.op == TAC_RETURN) use(q.a);
+}
+
+// A named variable: a global, or a parameter or local of one function
+struct tac_slot {
+    int name; // interned
+    data_type type;
+    int array_size; // 0 for scalars
+};
+
+struct tac_function {
+    int name; // interned
+    data_type return_type;
+    vector<pair<data_type, int>> params; // type, interned name
+    vector<tac_slot> slots; // named parameters first, then locals in declaration order
+};
+
+inline const char* opcode_symbol(tac_opcode op) {
+    switch (op) {
+        case TAC_ADD: return "+";
+        case TAC_SUB: return "-";
+        case TAC_MUL: return "*";
+        case TAC_DIV: return "/";
+        case TAC_MOD: return "%";
+        case TAC_SHL: return "<<";
+        case TAC_LT: return "<";
+        case TAC_GT: return ">";
+        case TAC_LE: return "<=";
+        case TAC_GE: return ">=";
+        case TAC_EQ: return "==";
+        case TAC_NE: return "!=";
+        case TAC_AND: return "&&";
+        case TAC_OR: return "||";
+        case TAC_NEG: return "-";
+        case TAC_NOT: return "!";
+        default: return "";
+    }
+}
+
+class tac_program {
+    public:
+        vector<tac_quad> quads;
+        vector<double> floats; // float constants, referenced by OPND_FLOAT operands
+        vector<tac_function> functions;
+        vector<tac_slot> globals;
+
+        void emit(tac_opcode op, data_type type, tac_operand dst,
+                  tac_operand a = tac_operand(), tac_operand b = tac_operand()) {
+            quads.push_back({op, type, dst, a, b});
+        }
+
+        // Quads that do work when run; labels, function headers and declarations are only markers
+        size_t instruction_count() const {
+            size_t n = 0;
+            for (const tac_quad& q : quads) {
+                if (q.op != TAC_LABEL && q.op != TAC_FUNC && q.op != TAC_DECL) n++;
+            }
+            return n;
+        }
+
+        // Appends part, a unit generated as a program of its own: its float constants, functions
+        // and labels are renumbered to follow this program's. label_base is the first label this
+        // program does not use yet and moves past the labels of part.
+        void append(const tac_program& part, int& label_base) {
+            int float_base = floats.size(), function_base = functions.size(), labels_used = 0;
+            floats.insert(floats.end(), part.floats.begin(), part.floats.end());
+            functions.insert(functions.end(), part.functions.begin(), part.functions.end());
+            for (tac_quad q : part.quads) {
+                for (tac_operand* o : {&q.dst, &q.a, &q.b}) {
+                    if (o->kind == OPND_FLOAT) o->value += float_base;
+                    else if (o->kind == OPND_LABEL) {
+                        labels_used = max(labels_used, o->value + 1);
+                        o->value += label_base;
+                    }
+                }
+                if (q.op == TAC_FUNC) q.b.value += function_base;
+                quads.push_back(q);
+            }
+            label_base += labels_used;
+        }
+
+        tac_operand float_operand(double v) {
+            floats.push_back(v);
+            return tac_operand(OPND_FLOAT, floats.size() - 1);
+        }
+
+        // fn is the function the operand appears in, it names OPND_VAR slots
+        void append_operand(string& out, const tac_operand& o, const tac_function* fn) const {
+            char buf[32];
+            switch (o.kind) {
+                case OPND_NONE:
+                    break;
+                case OPND_TEMP:
+                    out += 't';
+                    out += to_string(o.value);
+                    break;
+                case OPND_VAR:
+                    out += names.str(fn->slots[o.value].name);
+                    break;
+                case OPND_GLOBAL:
+                    out += names.str(globals[o.value].name);
+                    break;
+                case OPND_FUNC:
+                    out += names.str(o.value);
+                    break;
+                case OPND_INT:
+                    out += to_string(o.value);
+                    break;
+                case OPND_FLOAT: {
+                    // shortest text that reads back as the same double, kept recognizable as a float
+                    char* end = to_chars(buf, buf + sizeof(buf), floats[o.value]).ptr;
+                    string_view text(buf, end - buf);
+                    out += text;
+                    if (text.find_first_of(".eEn") == string_view::npos) out += ".0";
+                    break;
+                }
+                case OPND_LABEL:
+                    out += 'L';
+                    out += to_string(o.value);
+                    break;
+            }
+        }
+
+        // Appends the text form of q, one line
+        void append_quad(string& out, const tac_quad& q, const tac_function* fn) const {
+            auto append_operand = [&](string& out, const tac_operand& o) { this->append_operand(out, o, fn); };
+            switch (q.op) {
+                case TAC_COPY:
+                    append_operand(out, q.dst); out += " = "; append_operand(out, q.a);
+                    break;
+                case TAC_NEG:
+                case TAC_NOT:
+                    append_operand(out, q.dst); out += " = "; out += opcode_symbol(q.op); append_operand(out, q.a);
+                    break;
+                case TAC_ITOF:
+                    append_operand(out, q.dst); out += " = (float)"; append_operand(out, q.a);
+                    break;
+                case TAC_FTOI:
+                    append_operand(out, q.dst); out += " = (int)"; append_operand(out, q.a);
+                    break;
+                case TAC_LOAD:
+                    append_operand(out, q.dst); out += " = "; append_operand(out, q.a);
+                    out += '['; append_operand(out, q.b); out += ']';
+                    break;
+                case TAC_STORE:
+                    append_operand(out, q.dst); out += '['; append_operand(out, q.a); out += "] = ";
+                    append_operand(out, q.b);
+                    break;
+                case TAC_LABEL:
+                    append_operand(out, q.dst); out += ':';
+                    break;
+                case TAC_GOTO:
+                    out += "goto "; append_operand(out, q.dst);
+                    break;
+                case TAC_IF:
+                    out += "if "; append_operand(out, q.a); out += " goto "; append_operand(out, q.dst);
+                    break;
+                case TAC_IFFALSE:
+                    out += "ifFalse "; append_operand(out, q.a); out += " goto "; append_operand(out, q.dst);
+                    break;
+                case TAC_PARAM:
+                    out += "param "; append_operand(out, q.a);
+                    break;
+                case TAC_CALL:
+                    append_operand(out, q.dst); out += " = call "; append_operand(out, q.a);
+                    out += ", "; append_operand(out, q.b);
+                    break;
+                case TAC_RETURN:
+                    out += "return";
+                    if (!q.a.is_none()) { out += ' '; append_operand(out, q.a); }
+                    break;
+                case TAC_FUNC: {
+                    const tac_function& f = functions[q.b.value];
+                    out += "// Function: "; out += type_name(f.return_type); out += ' ';
+                    out += names.str(f.name); out += '(';
+                    for (size_t i = 0; i < f.params.size(); ++i) {
+                        if (i) out += ", ";
+                        out += type_name(f.params[i].first); out += ' '; out += names.str(f.params[i].second);
+                    }
+                    out += ')';
+                    break;
+                }
+                case TAC_DECL:
+                    out += "// Declaration: "; out += type_name(q.type); out += ' '; append_operand(out, q.dst);
+                    if (q.a.value > 0) { out += '['; out += to_string(q.a.value); out += ']'; }
+                    break;
+                default: // binary operators
+                    append_operand(out, q.dst); out += " = "; append_operand(out, q.a);
+                    out += ' '; out += opcode_symbol(q.op); out += ' '; append_operand(out, q.b);
+                    break;
+            }
+            out += '\n';
+        }
+
+        // Text of the quads from first on; first must start a unit, a function or a declaration
+        void print(string& out, size_t first = 0) const {
+            out.reserve(out.size() + (quads.size() - first) * 16);
+            const tac_function* fn = nullptr;
+            for (size_t i = first; i < quads.size(); i++) {
+                const tac_quad& q = quads[i];
+                if (q.op == TAC_FUNC) fn = &functions[q.b.value];
+                append_quad(out, q, fn);
+            }
+        }
+
+        // The full code.txt text: banner, quads and end marker
+        void print_listing(string& out) const {
+            print_listing_start(out);
+            print(out);
+            print_listing_end(out);
+        }
+
+        void print_listing_start(string& out) const {
+            out += "//========== THREE ADDRESS CODE ==========\n";
+            out += "\n";
+            out += "// This code was generated by a two-pass compiler\n";
+            out += "// Format: \n";
+            out += "// - t0, t1, etc. are temporary variables\n";
+            out += "// - L0, L1, etc. are labels for jumps\n";
+            out += "// - Operations follow the three-address code format\n";
+            out += "\n";
+            out += "//Three Address Code\n\n";
+        }
+
+        void print_listing_end(string& out) const {
+            out += "\n";
+            out += "//========== END OF CODE ==========\n";
+        }
+};
+
+#endif // TAC_H
@@ -0,0 +1,314 @@
+#ifndef TAC_BINARY_H
+#define TAC_BINARY_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "tac.h"
+
+using namespace std;
+
+// Binary form of a tac_program, laid out so a consumer can mmap the file and walk it in place.
+// All fields are little-endian and every section starts on an 8-byte boundary:
+//
+//   tac_file_header
+//   double           floats[float_count]          OPND_FLOAT operands index this
+//   tac_file_func    functions[function_count]
+//   tac_file_param   params[param_count]          each function owns a contiguous run
+//   tac_file_slot    slots[slot_count]            each function owns a contiguous run
+//   tac_file_slot    globals[global_count]
+//   tac_file_quad    quads[quad_count]
+//   uint32_t         string_offsets[string_count] into string_data
+//   char             string_data[string_data_size] NUL-terminated names
+//
+// Names refer to the string pool instead of the compiler's interner, so a file stands on its own.
+// OPND_VAR and OPND_GLOBAL operands keep their slot numbers. A reader must reject files whose
+// version it does not know.
+
+static const char tac_file_magic[4] = {'T', 'A', 'C', 'B'};
+static const uint16_t tac_file_version = 4;
+
+struct tac_file_header {
+    char magic[4];
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t file_size;
+    uint32_t float_count, float_offset;
+    uint32_t function_count, function_offset;
+    uint32_t param_count, param_offset;
+    uint32_t slot_count, slot_offset;
+    uint32_t global_count, global_offset;
+    uint32_t quad_count, quad_offset;
+    uint32_t string_count, string_offset;
+    uint32_t string_data_size, string_data_offset;
+    uint32_t reserved;
+};
+
+struct tac_file_func {
+    uint32_t name; // string index
+    uint32_t first_param;
+    uint32_t param_count;
+    uint32_t first_quad; // its TAC_FUNC quad
+    uint32_t first_slot;
+    uint32_t slot_count;
+    uint8_t return_type;
+    uint8_t pad[3];
+};
+
+struct tac_file_param {
+    uint32_t name; // string index, 0 is the empty string
+    uint8_t type;
+    uint8_t pad[3];
+};
+
+struct tac_file_slot {
+    uint32_t name; // string index
+    uint8_t type;
+    uint8_t pad[3];
+    int32_t array_size;
+};
+
+struct tac_file_quad {
+    uint8_t op;
+    uint8_t type;
+    uint8_t dst_kind, a_kind, b_kind;
+    uint8_t pad[3];
+    int32_t dst, a, b;
+};
+
+static_assert(sizeof(tac_file_header) == 80, "tac_file_header layout changed");
+static_assert(sizeof(tac_file_func) == 28, "tac_file_func layout changed");
+static_assert(sizeof(tac_file_param) == 8, "tac_file_param layout changed");
+static_assert(sizeof(tac_file_slot) == 12, "tac_file_slot layout changed");
+static_assert(sizeof(tac_file_quad) == 20, "tac_file_quad layout changed");
+
+// Serializes code into out
+inline void write_tac_binary(const tac_program& code, string& out) {
+    // Pool every name the program mentions, in first-use order; the empty string is index 0
+    vector<int> pool_names;
+    unordered_map<int, uint32_t> pool_index;
+    auto pool = [&](int name) -> uint32_t {
+        auto it = pool_index.find(name);
+        if (it != pool_index.end()) return it->second;
+        uint32_t idx = pool_names.size();
+        pool_names.push_back(name);
+        pool_index.emplace(name, idx);
+        return idx;
+    };
+    pool(0);
+
+    auto encode = [&](const tac_operand& o) -> int32_t {
+        return o.kind == OPND_FUNC ? pool(o.value) : o.value;
+    };
+
+    vector<tac_file_quad> quads;
+    quads.reserve(code.quads.size());
+    vector<uint32_t> func_start(code.functions.size(), 0);
+    for (size_t i = 0; i < code.quads.size(); i++) {
+        const tac_quad& q = code.quads[i];
+        if (q.op == TAC_FUNC) func_start[q.b.value] = i;
+        tac_file_quad r = {};
+        r.op = q.op;
+        r.type = q.type;
+        r.dst_kind = q.dst.kind;
+        r.a_kind = q.a.kind;
+        r.b_kind = q.b.kind;
+        r.dst = encode(q.dst);
+        r.a = encode(q.a);
+        r.b = encode(q.b);
+        quads.push_back(r);
+    }
+
+    vector<tac_file_func> funcs;
+    vector<tac_file_param> params;
+    vector<tac_file_slot> slots;
+    auto encode_slot = [&](const tac_slot& s) {
+        tac_file_slot r = {};
+        r.name = pool(s.name);
+        r.type = s.type;
+        r.array_size = s.array_size;
+        return r;
+    };
+    for (size_t i = 0; i < code.functions.size(); i++) {
+        const tac_function& f = code.functions[i];
+        tac_file_func r = {};
+        r.name = pool(f.name);
+        r.first_param = params.size();
+        r.param_count = f.params.size();
+        r.first_quad = func_start[i];
+        r.first_slot = slots.size();
+        r.slot_count = f.slots.size();
+        r.return_type = f.return_type;
+        funcs.push_back(r);
+        for (auto& p : f.params) {
+            tac_file_param fp = {};
+            fp.name = pool(p.second);
+            fp.type = p.first;
+            params.push_back(fp);
+        }
+        for (auto& s : f.slots) slots.push_back(encode_slot(s));
+    }
+    vector<tac_file_slot> globals;
+    for (auto& s : code.globals) globals.push_back(encode_slot(s));
+
+    vector<uint32_t> string_offsets;
+    string string_data;
+    for (int name : pool_names) {
+        string_offsets.push_back(string_data.size());
+        string_data += names.str(name);
+        string_data += '\0';
+    }
+
+    auto align = [](size_t n) { return (n + 7) & ~(size_t)7; };
+    tac_file_header h = {};
+    memcpy(h.magic, tac_file_magic, 4);
+    h.version = tac_file_version;
+    h.header_size = sizeof(tac_file_header);
+    size_t pos = sizeof(tac_file_header);
+    h.float_count = code.floats.size();
+    h.float_offset = pos;
+    pos = align(pos + code.floats.size() * sizeof(double));
+    h.function_count = funcs.size();
+    h.function_offset = pos;
+    pos = align(pos + funcs.size() * sizeof(tac_file_func));
+    h.param_count = params.size();
+    h.param_offset = pos;
+    pos = align(pos + params.size() * sizeof(tac_file_param));
+    h.slot_count = slots.size();
+    h.slot_offset = pos;
+    pos = align(pos + slots.size() * sizeof(tac_file_slot));
+    h.global_count = globals.size();
+    h.global_offset = pos;
+    pos = align(pos + globals.size() * sizeof(tac_file_slot));
+    h.quad_count = quads.size();
+    h.quad_offset = pos;
+    pos = align(pos + quads.size() * sizeof(tac_file_quad));
+    h.string_count = string_offsets.size();
+    h.string_offset = pos;
+    pos = align(pos + string_offsets.size() * sizeof(uint32_t));
+    h.string_data_size = string_data.size();
+    h.string_data_offset = pos;
+    pos = align(pos + string_data.size());
+    h.file_size = pos;
+
+    size_t base = out.size();
+    out.resize(base + pos, '\0');
+    char* p = &out[base];
+    memcpy(p, &h, sizeof(h));
+    if (!code.floats.empty()) memcpy(p + h.float_offset, code.floats.data(), code.floats.size() * sizeof(double));
+    if (!funcs.empty()) memcpy(p + h.function_offset, funcs.data(), funcs.size() * sizeof(tac_file_func));
+    if (!params.empty()) memcpy(p + h.param_offset, params.data(), params.size() * sizeof(tac_file_param));
+    if (!slots.empty()) memcpy(p + h.slot_offset, slots.data(), slots.size() * sizeof(tac_file_slot));
+    if (!globals.empty()) memcpy(p + h.global_offset, globals.data(), globals.size() * sizeof(tac_file_slot));
+    if (!quads.empty()) memcpy(p + h.quad_offset, quads.data(), quads.size() * sizeof(tac_file_quad));
+    memcpy(p + h.string_offset, string_offsets.data(), string_offsets.size() * sizeof(uint32_t));
+    memcpy(p + h.string_data_offset, string_data.data(), string_data.size());
+}
+
+// Read-only view of a binary TAC image already in memory, typically an mmap of the file.
+// Nothing is copied; the accessors point into the image.
+class tac_image {
+    private:
+        const char* base = nullptr;
+        size_t size = 0;
+
+        bool section_fits(uint32_t offset, uint32_t count, size_t elem) const {
+            return offset % 8 == 0 && offset <= size && (size - offset) / elem >= count;
+        }
+
+    public:
+        // Checks magic, version and that every section lies inside the image
+        bool open(const void* data, size_t len) {
+            base = static_cast<const char*>(data);
+            size = len;
+            if (size < sizeof(tac_file_header)) return false;
+            const tac_file_header& h = header();
+            if (memcmp(h.magic, tac_file_magic, 4) != 0) return false;
+            if (h.version != tac_file_version || h.header_size != sizeof(tac_file_header)) return false;
+            if (h.file_size > size) return false;
+            if (!section_fits(h.float_offset, h.float_count, sizeof(double))) return false;
+            if (!section_fits(h.function_offset, h.function_count, sizeof(tac_file_func))) return false;
+            if (!section_fits(h.param_offset, h.param_count, sizeof(tac_file_param))) return false;
+            if (!section_fits(h.slot_offset, h.slot_count, sizeof(tac_file_slot))) return false;
+            if (!section_fits(h.global_offset, h.global_count, sizeof(tac_file_slot))) return false;
+            if (!section_fits(h.quad_offset, h.quad_count, sizeof(tac_file_quad))) return false;
+            if (!section_fits(h.string_offset, h.string_count, sizeof(uint32_t))) return false;
+            if (!section_fits(h.string_data_offset, h.string_data_size, 1)) return false;
+            if (h.string_data_size == 0 || base[h.string_data_offset + h.string_data_size - 1] != '\0') return false;
+            for (uint32_t i = 0; i < h.string_count; i++) {
+                if (string_offsets()[i] >= h.string_data_size) return false;
+            }
+            return true;
+        }
+
+        const tac_file_header& header() const { return *reinterpret_cast<const tac_file_header*>(base); }
+        const double* floats() const { return reinterpret_cast<const double*>(base + header().float_offset); }
+        const tac_file_func* functions() const { return reinterpret_cast<const tac_file_func*>(base + header().function_offset); }
+        const tac_file_param* params() const { return reinterpret_cast<const tac_file_param*>(base + header().param_offset); }
+        const tac_file_slot* slots() const { return reinterpret_cast<const tac_file_slot*>(base + header().slot_offset); }
+        const tac_file_slot* globals() const { return reinterpret_cast<const tac_file_slot*>(base + header().global_offset); }
+        const tac_file_quad* quads() const { return reinterpret_cast<const tac_file_quad*>(base + header().quad_offset); }
+        const uint32_t* string_offsets() const { return reinterpret_cast<const uint32_t*>(base + header().string_offset); }
+        const char* str(uint32_t i) const { return base + header().string_data_offset + string_offsets()[i]; }
+
+        // Rebuilds an in-memory program, interning the pooled names.
+        // Fails on opcodes, operand kinds or indexes the program could not print.
+        bool load(tac_program& code) const {
+            const tac_file_header& h = header();
+            vector<int> name_of(h.string_count);
+            for (uint32_t i = 0; i < h.string_count; i++) name_of[i] = names.intern(str(i));
+
+            bool ok = true;
+            const tac_function* owner = nullptr; // function of the quads being decoded
+            auto decode = [&](uint8_t kind, int32_t value) {
+                if (kind > OPND_GLOBAL) ok = false;
+                else if (kind == OPND_FUNC) {
+                    if ((uint32_t)value < h.string_count) value = name_of[value];
+                    else ok = false;
+                }
+                else if (kind == OPND_VAR && (!owner || (uint32_t)value >= owner->slots.size())) ok = false;
+                else if (kind == OPND_GLOBAL && (uint32_t)value >= h.global_count) ok = false;
+                else if (kind == OPND_FLOAT && (uint32_t)value >= h.float_count) ok = false;
+                return tac_operand((operand_kind)kind, value);
+            };
+            auto decode_slot = [&](const tac_file_slot& s) {
+                return tac_slot{s.name < h.string_count ? name_of[s.name] : 0, (data_type)s.type, s.array_size};
+            };
+
+            code.floats.assign(floats(), floats() + h.float_count);
+            code.functions.clear();
+            for (uint32_t i = 0; i < h.function_count; i++) {
+                const tac_file_func& f = functions()[i];
+                tac_function fn;
+                fn.name = f.name < h.string_count ? name_of[f.name] : 0;
+                fn.return_type = (data_type)f.return_type;
+                for (uint32_t j = 0; j < f.param_count && f.first_param + j < h.param_count; j++) {
+                    const tac_file_param& p = params()[f.first_param + j];
+                    fn.params.push_back(make_pair((data_type)p.type, p.name < h.string_count ? name_of[p.name] : 0));
+                }
+                for (uint32_t j = 0; j < f.slot_count && f.first_slot + j < h.slot_count; j++) {
+                    fn.slots.push_back(decode_slot(slots()[f.first_slot + j]));
+                }
+                code.functions.push_back(fn);
+            }
+            code.globals.clear();
+            for (uint32_t i = 0; i < h.global_count; i++) code.globals.push_back(decode_slot(globals()[i]));
+            code.quads.clear();
+            code.quads.reserve(h.quad_count);
+            for (uint32_t i = 0; i < h.quad_count; i++) {
+                const tac_file_quad& r = quads()[i];
+                if (r.op > TAC_DECL) return false;
+                if (r.op == TAC_FUNC) {
+                    if ((uint32_t)r.b >= h.function_count) return false;
+                    owner = &code.functions[r.b];
+                }
+                code.quads.push_back({(tac_opcode)r.op, (data_type)r.type,
+                                      decode(r.dst_kind, r.dst), decode(r.a_kind, r.a), decode(r.b_kind, r.b)});
+            }
+            return ok;
+        }
+};
+
+#endif // TAC_BINARY_H
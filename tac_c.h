@@ -0,0 +1,333 @@
+#ifndef TAC_C_H
+#define TAC_C_H
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "tac.h"
+#include "tac_cfg.h"
+#include "tac_typing.h"
+
+using namespace std;
+
+// Portable C from a tac_program, quad for quad: one C function per source function, temps and
+// named locals as C locals, labels and gotos as they are. The result computes what the TAC
+// virtual machine does, so a C compiler's optimizer can be measured against ours: floats are
+// doubles, int arithmetic wraps instead of overflowing, division by -1 cannot trap, and every
+// local and array starts out zero.
+
+// Header of every generated file: the operations C leaves undefined where the TAC does not
+static const char* const tac_c_prelude =
+    "static inline int tac_add(int a, int b) { return (int)((unsigned)a + (unsigned)b); }\n"
+    "static inline int tac_sub(int a, int b) { return (int)((unsigned)a - (unsigned)b); }\n"
+    "static inline int tac_mul(int a, int b) { return (int)((unsigned)a * (unsigned)b); }\n"
+    "static inline int tac_div(int a, int b) { return b == -1 ? (int)(0u - (unsigned)a) : a / b; }\n"
+    "static inline int tac_mod(int a, int b) { return b == -1 ? 0 : a % b; }\n"
+    "static inline int tac_shl(int a, int b) { return (int)((unsigned)a << (b & 31)); }\n"
+    "static inline int tac_neg(int a) { return (int)(0u - (unsigned)a); }\n"
+    "static inline int tac_ftoi(double a) { return (int)(long long)a; }\n";
+
+class c_backend {
+    public:
+        explicit c_backend(const tac_program& code_in) : code(code_in) {}
+
+        bool generate(string& result, string& error) {
+            if (!split_mixed_temps(code, error)) return false;
+            out = "// C translation of the three-address code, written by the two-pass compiler\n\n";
+            out += tac_c_prelude;
+
+            if (!code.globals.empty()) out += '\n';
+            unordered_set<string> taken;
+            for (const tac_slot& g : code.globals) {
+                global_names.push_back(identifier(names.str(g.name), taken, "g"));
+                declare(out, g, global_names.back());
+                out += ";\n";
+            }
+
+            vector<tac_function_range> ranges = function_ranges(code);
+            out += '\n';
+            for (const tac_function_range& r : ranges) {
+                function_with_body[code.functions[r.function].name] = &code.functions[r.function];
+                out += signature(code.functions[r.function], nullptr) + ";\n";
+            }
+            for (const tac_function_range& r : ranges) generate_function(r);
+            result.swap(out);
+            return true;
+        }
+
+    private:
+        tac_program code; // with mixed temps split
+        string out;
+        vector<string> global_names;
+        unordered_map<int, const tac_function*> function_with_body; // by interned name
+
+        // the function being written
+        const tac_function* fn = nullptr;
+        vector<string> slot_names;
+        unordered_map<int, data_type> temp_type;
+        vector<string> args; // passed and not yet called
+        vector<data_type> param_types; // of args
+
+        static bool reserved(const string& name) {
+            static const unordered_set<string> words = {
+                "auto", "break", "case", "char", "const", "continue", "default", "do", "double", "else",
+                "enum", "extern", "float", "for", "goto", "if", "inline", "int", "long", "register",
+                "restrict", "return", "short", "signed", "sizeof", "static", "struct", "switch",
+                "typedef", "union", "unsigned", "void", "volatile", "while", "main"};
+            if (words.count(name) || name.compare(0, 4, "tac_") == 0) return true;
+            // t0, t1, ... belong to the temps
+            if (name.size() > 1 && name[0] == 't' && name.find_first_not_of("0123456789", 1) == string::npos) return true;
+            return false;
+        }
+
+        // name, or name with a suffix when it is taken or means something else in C
+        static string identifier(const string& name, unordered_set<string>& taken, const string& suffix) {
+            string id = name;
+            for (int k = 1; reserved(id) || taken.count(id); k++) id = name + "_" + suffix + to_string(k);
+            taken.insert(id);
+            return id;
+        }
+
+        static const char* c_type(data_type t) { return value_type(t) == TYPE_FLOAT ? "double" : "int"; }
+
+        void declare(string& s, const tac_slot& slot, const string& name) const {
+            s += c_type(slot.type);
+            s += ' ';
+            s += name;
+            if (slot.array_size > 0) s += "[" + to_string(slot.array_size) + "]";
+        }
+
+        // main keeps the signature C requires
+        string signature(const tac_function& f, const vector<string>* param_names) const {
+            const string& name = names.str(f.name);
+            if (name == "main") return "int main(void)";
+            string s = f.return_type == TYPE_VOID ? "void" : c_type(f.return_type);
+            s += ' ';
+            s += name;
+            s += '(';
+            for (size_t k = 0; k < f.params.size(); k++) {
+                if (k) s += ", ";
+                s += c_type(f.params[k].first);
+                if (param_names) s += ' ' + (*param_names)[k];
+            }
+            if (f.params.empty()) s += "void";
+            return s + ')';
+        }
+
+        data_type type_of(const tac_operand& o) const {
+            switch (o.kind) {
+                case OPND_FLOAT: return TYPE_FLOAT;
+                case OPND_VAR: return value_type(fn->slots[o.value].type);
+                case OPND_GLOBAL: return value_type(code.globals[o.value].type);
+                case OPND_TEMP: {
+                    auto it = temp_type.find(o.value);
+                    return it == temp_type.end() ? TYPE_INT : it->second;
+                }
+                default: return TYPE_INT;
+            }
+        }
+
+        string operand(const tac_operand& o) const {
+            switch (o.kind) {
+                case OPND_TEMP: return "t" + to_string(o.value);
+                case OPND_VAR: return slot_names[o.value];
+                case OPND_GLOBAL: return global_names[o.value];
+                case OPND_INT: return to_string(o.value);
+                case OPND_FLOAT: {
+                    string s;
+                    code.append_operand(s, o, fn);
+                    if (s == "inf") return "(1.0 / 0.0)";
+                    if (s == "-inf") return "(-1.0 / 0.0)";
+                    if (s == "nan" || s == "-nan") return "(0.0 / 0.0)";
+                    return s;
+                }
+                default: return "";
+            }
+        }
+
+        // o's value as type t
+        string as(const tac_operand& o, data_type t) const {
+            string s = operand(o);
+            data_type have = type_of(o);
+            if (have == t) return s;
+            if (t == TYPE_FLOAT) return "(double)" + s;
+            return "tac_ftoi(" + s + ")";
+        }
+
+        // An assignment of expression e, of type t, to dst
+        string assign(const tac_operand& dst, const string& e, data_type t) const {
+            string s = operand(dst) + " = ";
+            if (type_of(dst) == TYPE_INT && t == TYPE_FLOAT) return s + "tac_ftoi(" + e + ");";
+            return s + e + ";";
+        }
+
+        void generate_function(const tac_function_range& r) {
+            fn = &code.functions[r.function];
+            temp_type = temp_types(code, r);
+            for (int i = r.begin; i < r.end; i++) {
+                for_each_use(code.quads[i], [&](tac_operand& o) {
+                    if (o.kind == OPND_TEMP) temp_type.emplace(o.value, TYPE_INT);
+                });
+            }
+            args.clear();
+            param_types.clear();
+
+            unordered_set<string> taken(global_names.begin(), global_names.end());
+            slot_names.clear();
+            for (const tac_slot& s : fn->slots) slot_names.push_back(identifier(names.str(s.name), taken, "v"));
+            vector<string> param_names;
+            size_t named = 0;
+            for (size_t k = 0; k < fn->params.size(); k++) {
+                if (fn->params[k].second) param_names.push_back(slot_names[named++]);
+                else param_names.push_back(identifier("unnamed", taken, "p"));
+            }
+
+            out += '\n';
+            out += signature(*fn, &param_names);
+            out += "\n{\n";
+            for (size_t s = named; s < fn->slots.size(); s++) {
+                out += "    ";
+                declare(out, fn->slots[s], slot_names[s]);
+                out += fn->slots[s].array_size > 0 ? " = {0};\n" : " = 0;\n";
+            }
+            // temps, a line of declarations per type
+            vector<int> temps[2];
+            for (auto& [t, type] : temp_type) temps[type == TYPE_FLOAT].push_back(t);
+            for (int k = 0; k < 2; k++) {
+                sort(temps[k].begin(), temps[k].end());
+                for (size_t i = 0; i < temps[k].size(); i++) {
+                    out += i % 10 == 0 ? (i ? ";\n    " : "    ") + string(k ? "double " : "int ") : ", ";
+                    out += "t" + to_string(temps[k][i]);
+                }
+                if (!temps[k].empty()) out += ";\n";
+            }
+            if (fn->slots.size() > named || !temp_type.empty()) out += '\n';
+
+            for (int i = r.begin; i < r.end; i++) generate_quad(code.quads[i]);
+            // falling off the end returns 0, as on the machine
+            bool returns = r.end > r.begin && code.quads[r.end - 1].op == TAC_RETURN;
+            if (!returns && (fn->return_type != TYPE_VOID || names.str(fn->name) == "main")) line("return 0;");
+            out += "}\n";
+        }
+
+        void line(const string& s) {
+            out += "    ";
+            out += s;
+            out += '\n';
+        }
+
+        void generate_quad(const tac_quad& q) {
+            static const char* int_call[] = {"", "tac_add", "tac_sub", "tac_mul", "tac_div", "tac_mod", "tac_shl"};
+            data_type type = def_type(q);
+            switch (q.op) {
+                case TAC_COPY:
+                    line(assign(q.dst, as(q.a, type_of(q.dst)), type_of(q.dst)));
+                    break;
+                case TAC_ITOF:
+                    line(assign(q.dst, as(q.a, TYPE_FLOAT), TYPE_FLOAT));
+                    break;
+                case TAC_FTOI:
+                    line(assign(q.dst, as(q.a, TYPE_INT), TYPE_INT));
+                    break;
+                case TAC_ADD: case TAC_SUB: case TAC_MUL: case TAC_DIV: case TAC_MOD: case TAC_SHL:
+                    if (type == TYPE_FLOAT && q.op <= TAC_DIV) {
+                        line(assign(q.dst, as(q.a, TYPE_FLOAT) + " " + opcode_symbol(q.op) + " " + as(q.b, TYPE_FLOAT), TYPE_FLOAT));
+                    } else {
+                        line(assign(q.dst, string(int_call[q.op]) + "(" + as(q.a, TYPE_INT) + ", " + as(q.b, TYPE_INT) + ")", TYPE_INT));
+                    }
+                    break;
+                case TAC_LT: case TAC_GT: case TAC_LE: case TAC_GE: case TAC_EQ: case TAC_NE: case TAC_AND: case TAC_OR:
+                    // C compares an int with a double as doubles, as the machine does
+                    line(assign(q.dst, operand(q.a) + " " + opcode_symbol(q.op) + " " + operand(q.b), TYPE_INT));
+                    break;
+                case TAC_NEG:
+                    if (type == TYPE_FLOAT) line(assign(q.dst, "-(" + as(q.a, TYPE_FLOAT) + ")", TYPE_FLOAT)); // not --2.5
+                    else line(assign(q.dst, "tac_neg(" + as(q.a, TYPE_INT) + ")", TYPE_INT));
+                    break;
+                case TAC_NOT:
+                    line(assign(q.dst, "!" + operand(q.a), TYPE_INT));
+                    break;
+                case TAC_LOAD: {
+                    data_type element = value_type(q.a.kind == OPND_GLOBAL ? code.globals[q.a.value].type : fn->slots[q.a.value].type);
+                    line(assign(q.dst, operand(q.a) + "[" + as(q.b, TYPE_INT) + "]", element));
+                    break;
+                }
+                case TAC_STORE: {
+                    data_type element = type_of(q.dst);
+                    line(operand(q.dst) + "[" + as(q.a, TYPE_INT) + "] = " + as(q.b, element) + ";");
+                    break;
+                }
+                case TAC_LABEL:
+                    out += "L" + to_string(q.dst.value) + ":;\n";
+                    break;
+                case TAC_GOTO:
+                    line("goto L" + to_string(q.dst.value) + ";");
+                    break;
+                case TAC_IF:
+                    line("if (" + operand(q.a) + ") goto L" + to_string(q.dst.value) + ";");
+                    break;
+                case TAC_IFFALSE:
+                    line("if (!" + operand(q.a) + ") goto L" + to_string(q.dst.value) + ";");
+                    break;
+                case TAC_PARAM:
+                    args.push_back(operand(q.a));
+                    param_types.push_back(type_of(q.a));
+                    break;
+                case TAC_CALL:
+                    call(q);
+                    break;
+                case TAC_RETURN:
+                    if (names.str(fn->name) == "main") {
+                        line(q.a.is_none() || fn->return_type == TYPE_VOID ? "return 0;" : "return " + as(q.a, TYPE_INT) + ";");
+                    } else if (fn->return_type == TYPE_VOID) {
+                        line("return;");
+                    } else if (q.a.is_none()) {
+                        line("return 0;");
+                    } else {
+                        line("return " + as(q.a, value_type(fn->return_type)) + ";");
+                    }
+                    break;
+                case TAC_FUNC:
+                case TAC_DECL:
+                    break;
+            }
+        }
+
+        void call(const tac_quad& q) {
+            size_t n = q.b.value;
+            string e = names.str(q.a.value) + "(";
+            auto callee = function_with_body.find(q.a.value);
+            for (size_t k = 0; k < n; k++) {
+                size_t at = args.size() - n + k;
+                string arg = args[at];
+                // a float passed for an int parameter converts the way the machine converts
+                if (callee != function_with_body.end() && k < callee->second->params.size() &&
+                    value_type(callee->second->params[k].first) == TYPE_INT && param_types[at] == TYPE_FLOAT) {
+                    arg = "tac_ftoi(" + arg + ")";
+                }
+                if (k) e += ", ";
+                e += arg;
+            }
+            e += ")";
+            args.resize(args.size() - n);
+            param_types.resize(param_types.size() - n);
+
+            data_type returns = def_type(q);
+            bool is_void = false;
+            if (callee != function_with_body.end()) {
+                is_void = callee->second->return_type == TYPE_VOID && names.str(q.a.value) != "main";
+                returns = value_type(callee->second->return_type);
+            }
+            if (q.dst.is_none()) line(e + ";");
+            else if (is_void) {
+                line(e + ";");
+                line(operand(q.dst) + " = 0;");
+            } else {
+                line(assign(q.dst, e, returns));
+            }
+        }
+};
+
+#endif // TAC_C_H
@@ -0,0 +1,224 @@
+#ifndef TAC_CACHE_H
+#define TAC_CACHE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <random>
+#include <vector>
+#include "tac.h"
+#include "tac_binary.h"
+#include "tac_opt.h"
+
+using namespace std;
+
+// On-disk cache of optimized function code, for rebuilding large inputs of which only a few
+// functions changed. An entry holds the tac_program one function generates on its own (see
+// ThreeAddrCodeGenerator) in the binary format of tac_binary.h, followed by the function's
+// optimizer stats. Its file name is a hash of everything that code depends on: the function's
+// tokens, the signatures of the globals and functions it names, the optimization level and the
+// format versions, so a changed function simply misses. Entries are written under a temporary
+// name and renamed into place, so compilers sharing a directory never read half an entry.
+// A hit refreshes the entry's time, and trim() deletes the least recently used entries first.
+
+static const uint32_t tac_cache_version = 3;
+
+// 128-bit hash of a byte stream: FNV-1a and an independent multiply-rotate hash side by side
+class tac_cache_key {
+    private:
+        uint64_t a = 14695981039346656037ull;
+        uint64_t b = 0x9e3779b97f4a7c15ull;
+
+    public:
+        void add(const void* data, size_t n) {
+            const unsigned char* p = static_cast<const unsigned char*>(data);
+            for (size_t i = 0; i < n; i++) {
+                a = (a ^ p[i]) * 1099511628211ull;
+                b = b ^ p[i];
+                b = ((b << 23) | (b >> 41)) * 0x9fb21c651e98df25ull;
+            }
+        }
+
+        void add(int64_t v) { add(&v, sizeof(v)); }
+
+        // Length first, so that consecutive strings cannot run into each other
+        void add(string_view s) {
+            add((int64_t)s.size());
+            add(s.data(), s.size());
+        }
+
+        string hex() const {
+            static const char digits[] = "0123456789abcdef";
+            string s;
+            for (uint64_t h : {a, b}) {
+                for (int shift = 60; shift >= 0; shift -= 4) s += digits[(h >> shift) & 15];
+            }
+            return s;
+        }
+};
+
+// Follows the binary program in an entry
+struct tac_cache_trailer {
+    char magic[4];
+    uint32_t version;
+    uint64_t instructions_before, instructions_after, values_reused, jumps_before, jumps_after;
+    uint32_t temp_count, loop_count; // tac_temp_stats and tac_loop_stats records that follow
+};
+
+struct tac_cache_stats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t stored = 0;
+};
+
+// What trim() found and did
+struct tac_cache_trim {
+    size_t entries = 0; // left in the cache
+    uintmax_t bytes = 0; // left in the cache
+    size_t removed = 0;
+};
+
+class tac_cache {
+    private:
+        filesystem::path dir;
+        tac_cache_stats stats;
+
+        static bool is_entry_name(const string& name) {
+            return name.size() == 32 && name.find_first_not_of("0123456789abcdef") == string::npos;
+        }
+
+    public:
+        explicit tac_cache(const string& directory) : dir(directory) {
+            error_code ec;
+            filesystem::create_directories(dir, ec);
+        }
+
+        // Reads the entry for key into part and part_stats. Must run on the compiling thread:
+        // loading interns the function's names. Returns false on a miss or an unreadable entry.
+        bool load(const string& key, tac_program& part, tac_opt_stats& part_stats) {
+            filesystem::path path = dir / key;
+            ifstream in(path, ios::binary);
+            string data;
+            if (in) data.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+            tac_image image;
+            tac_cache_trailer t;
+            size_t at = 0;
+            bool ok = !data.empty() && image.open(data.data(), data.size());
+            if (ok) {
+                at = image.header().file_size;
+                ok = data.size() - at >= sizeof(t);
+            }
+            if (ok) {
+                memcpy(&t, data.data() + at, sizeof(t));
+                at += sizeof(t);
+                ok = memcmp(t.magic, "TACC", 4) == 0 && t.version == tac_cache_version &&
+                     data.size() - at == t.temp_count * sizeof(tac_temp_stats) + t.loop_count * sizeof(tac_loop_stats);
+            }
+            if (!ok || !image.load(part)) {
+                stats.misses++;
+                return false;
+            }
+            part_stats = tac_opt_stats();
+            part_stats.instructions_before = t.instructions_before;
+            part_stats.instructions_after = t.instructions_after;
+            part_stats.values_reused = t.values_reused;
+            part_stats.jumps_before = t.jumps_before;
+            part_stats.jumps_after = t.jumps_after;
+            part_stats.temps.resize(t.temp_count);
+            if (t.temp_count) memcpy(part_stats.temps.data(), data.data() + at, t.temp_count * sizeof(tac_temp_stats));
+            at += t.temp_count * sizeof(tac_temp_stats);
+            part_stats.loops.resize(t.loop_count);
+            if (t.loop_count) memcpy(part_stats.loops.data(), data.data() + at, t.loop_count * sizeof(tac_loop_stats));
+
+            error_code ec;
+            filesystem::last_write_time(path, filesystem::file_time_type::clock::now(), ec); // recently used
+            stats.hits++;
+            return true;
+        }
+
+        // Writes the entry for key. Only the globals the function uses are kept, the caller
+        // supplies the program's own when the entry is loaded.
+        void store(const string& key, const tac_program& part, const tac_opt_stats& part_stats) {
+            int globals_used = 0;
+            for (const tac_quad& q : part.quads) {
+                for (const tac_operand* o : {&q.dst, &q.a, &q.b}) {
+                    if (o->kind == OPND_GLOBAL) globals_used = max(globals_used, o->value + 1);
+                }
+            }
+            string data;
+            if ((size_t)globals_used < part.globals.size()) {
+                tac_program trimmed = part;
+                trimmed.globals.resize(globals_used);
+                write_tac_binary(trimmed, data);
+            } else {
+                write_tac_binary(part, data);
+            }
+
+            tac_cache_trailer t = {};
+            memcpy(t.magic, "TACC", 4);
+            t.version = tac_cache_version;
+            t.instructions_before = part_stats.instructions_before;
+            t.instructions_after = part_stats.instructions_after;
+            t.values_reused = part_stats.values_reused;
+            t.jumps_before = part_stats.jumps_before;
+            t.jumps_after = part_stats.jumps_after;
+            t.temp_count = part_stats.temps.size();
+            t.loop_count = part_stats.loops.size();
+            data.append(reinterpret_cast<const char*>(&t), sizeof(t));
+            data.append(reinterpret_cast<const char*>(part_stats.temps.data()), t.temp_count * sizeof(tac_temp_stats));
+            data.append(reinterpret_cast<const char*>(part_stats.loops.data()), t.loop_count * sizeof(tac_loop_stats));
+
+            // a name no other writer, in this process or another, is likely to use
+            filesystem::path tmp = dir / (key + ".tmp" + to_string(random_device()()));
+            {
+                ofstream out(tmp, ios::binary | ios::trunc);
+                out.write(data.data(), data.size());
+                if (!out) return;
+            }
+            error_code ec;
+            filesystem::rename(tmp, dir / key, ec);
+            if (ec) filesystem::remove(tmp, ec);
+            else stats.stored++;
+        }
+
+        const tac_cache_stats& get_stats() const { return stats; }
+
+        // Deletes the least recently used entries of the cache in directory until the rest
+        // take at most max_bytes
+        static tac_cache_trim trim(const string& directory, uintmax_t max_bytes) {
+            struct entry {
+                filesystem::path path;
+                filesystem::file_time_type used;
+                uintmax_t bytes;
+            };
+            vector<entry> entries;
+            tac_cache_trim result;
+            error_code ec;
+            for (filesystem::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+                if (!is_entry_name(it->path().filename().string())) continue;
+                error_code size_ec, time_ec;
+                uintmax_t bytes = it->file_size(size_ec);
+                filesystem::file_time_type used = it->last_write_time(time_ec);
+                if (size_ec || time_ec) continue; // removed by another compiler meanwhile
+                entries.push_back({it->path(), used, bytes});
+                result.bytes += bytes;
+            }
+            sort(entries.begin(), entries.end(), [](const entry& x, const entry& y) { return x.used < y.used; });
+            size_t oldest = 0;
+            while (result.bytes > max_bytes && oldest < entries.size()) {
+                filesystem::remove(entries[oldest].path, ec);
+                result.bytes -= entries[oldest].bytes;
+                result.removed++;
+                oldest++;
+            }
+            result.entries = entries.size() - oldest;
+            return result;
+        }
+};
+
+#endif // TAC_CACHE_H
@@ -0,0 +1,267 @@
+#ifndef TAC_CFG_H
+#define TAC_CFG_H
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "tac.h"
+
+using namespace std;
+
+// A natural loop: the header dominates every block in it, and latches jump back to the header
+struct tac_loop {
+    int header;
+    vector<int> blocks; // ascending, header included
+    vector<int> latches;
+    int depth = 1; // 1 for an outermost loop
+
+    bool contains(int b) const { return binary_search(blocks.begin(), blocks.end(), b); }
+};
+
+class tac_dominators;
+
+// A straight-line run of quads [begin, end): control enters only at begin and leaves only after
+// the last quad
+struct tac_block {
+    int begin, end;
+    vector<int> succs, preds;
+};
+
+// Control-flow graph over the quads of one function body. Block 0 is the entry.
+// Indexes are into tac_program::quads, so the graph stays valid while passes rewrite quads in
+// place or only mark them removed; anything that inserts or deletes quads must rebuild it.
+class tac_cfg {
+    public:
+        vector<tac_block> blocks;
+        unordered_map<int, int> label_block; // label number -> block it starts
+
+        void build(const vector<tac_quad>& quads, int begin, int end) {
+            blocks.clear();
+            label_block.clear();
+            // A block starts at the function entry, at every label and after every jump or return
+            int start = begin;
+            for (int i = begin; i < end; i++) {
+                const tac_quad& q = quads[i];
+                if (q.op == TAC_LABEL && i > start) {
+                    blocks.push_back({start, i, {}, {}});
+                    start = i;
+                }
+                if (q.op == TAC_LABEL) label_block[q.dst.value] = blocks.size();
+                if (is_jump(q.op) || q.op == TAC_RETURN) {
+                    blocks.push_back({start, i + 1, {}, {}});
+                    start = i + 1;
+                }
+            }
+            if (start < end || blocks.empty()) blocks.push_back({start, end, {}, {}});
+
+            for (size_t b = 0; b < blocks.size(); b++) {
+                tac_block& blk = blocks[b];
+                bool falls_through = true;
+                if (blk.end > blk.begin) {
+                    const tac_quad& last = quads[blk.end - 1];
+                    if (is_jump(last.op)) add_edge(b, label_block.at(last.dst.value));
+                    falls_through = last.op != TAC_GOTO && last.op != TAC_RETURN;
+                }
+                if (falls_through && b + 1 < blocks.size()) add_edge(b, b + 1);
+            }
+        }
+
+        // Blocks that control can reach from the entry
+        vector<char> reachable() const {
+            vector<char> seen(blocks.size(), 0);
+            vector<int> work = {0};
+            seen[0] = 1;
+            while (!work.empty()) {
+                int b = work.back();
+                work.pop_back();
+                for (int s : blocks[b].succs) {
+                    if (!seen[s]) {
+                        seen[s] = 1;
+                        work.push_back(s);
+                    }
+                }
+            }
+            return seen;
+        }
+
+        // Block holding quad i
+        int block_of(int i) const {
+            auto after = upper_bound(blocks.begin(), blocks.end(), i, [](int i, const tac_block& b) { return i < b.begin; });
+            return after - blocks.begin() - 1;
+        }
+
+        // Reachable blocks, each after all its predecessors except along back edges
+        vector<int> reverse_postorder() const {
+            vector<int> order;
+            vector<char> seen(blocks.size(), 0);
+            vector<pair<int, size_t>> stack = {{0, 0}}; // block, next successor to visit
+            seen[0] = 1;
+            while (!stack.empty()) {
+                auto& [b, next] = stack.back();
+                if (next < blocks[b].succs.size()) {
+                    int s = blocks[b].succs[next++];
+                    if (!seen[s]) {
+                        seen[s] = 1;
+                        stack.push_back({s, 0});
+                    }
+                } else {
+                    order.push_back(b);
+                    stack.pop_back();
+                }
+            }
+            reverse(order.begin(), order.end());
+            return order;
+        }
+
+        // Immediate dominator of each block, by the iterative algorithm of Cooper, Harvey and
+        // Kennedy. The entry is its own; unreachable blocks get -1.
+        vector<int> immediate_dominators() const {
+            vector<int> order = reverse_postorder();
+            vector<int> rank(blocks.size(), -1), idom(blocks.size(), -1);
+            for (size_t k = 0; k < order.size(); k++) rank[order[k]] = k;
+            idom[0] = 0;
+            auto intersect = [&](int a, int b) {
+                while (a != b) {
+                    while (rank[a] > rank[b]) a = idom[a];
+                    while (rank[b] > rank[a]) b = idom[b];
+                }
+                return a;
+            };
+            bool changed = true;
+            while (changed) {
+                changed = false;
+                for (size_t k = 1; k < order.size(); k++) {
+                    int b = order[k], d = -1;
+                    for (int p : blocks[b].preds) {
+                        if (idom[p] < 0) continue;
+                        d = d < 0 ? p : intersect(p, d);
+                    }
+                    if (d != idom[b]) {
+                        idom[b] = d;
+                        changed = true;
+                    }
+                }
+            }
+            return idom;
+        }
+
+        // Natural loops from the back edges, those whose target dominates their source. Back edges
+        // to one header make one loop. Inner loops come before the loops around them.
+        vector<tac_loop> natural_loops(const tac_dominators& dom) const;
+
+    private:
+        void add_edge(int from, int to) {
+            for (int s : blocks[from].succs) {
+                if (s == to) return;
+            }
+            blocks[from].succs.push_back(to);
+            blocks[to].preds.push_back(from);
+        }
+};
+
+// The dominator tree of a tac_cfg, numbered so that dominance is a constant-time test
+class tac_dominators {
+    public:
+        vector<int> idom; // immediate dominator of each block, -1 if unreachable
+        vector<int> enter, leave; // preorder and postorder numbers in the tree
+
+        explicit tac_dominators(const tac_cfg& cfg) : idom(cfg.immediate_dominators()) {
+            size_t n = idom.size();
+            vector<vector<int>> children(n);
+            for (size_t b = 1; b < n; b++) {
+                if (idom[b] >= 0) children[idom[b]].push_back(b);
+            }
+            enter.assign(n, -1);
+            leave.assign(n, -1);
+            int clock = 0;
+            vector<pair<int, size_t>> stack = {{0, 0}};
+            enter[0] = clock++;
+            while (!stack.empty()) {
+                auto& [b, next] = stack.back();
+                if (next < children[b].size()) {
+                    int c = children[b][next++];
+                    enter[c] = clock++;
+                    stack.push_back({c, 0});
+                } else {
+                    leave[b] = clock++;
+                    stack.pop_back();
+                }
+            }
+        }
+
+        // Every path from the entry to b goes through a; false when either is unreachable
+        bool dominates(int a, int b) const {
+            return enter[a] >= 0 && enter[b] >= 0 && enter[a] <= enter[b] && leave[b] <= leave[a];
+        }
+};
+
+inline vector<tac_loop> tac_cfg::natural_loops(const tac_dominators& dom) const {
+    const vector<int>& idom = dom.idom;
+    unordered_map<int, int> loop_of_header;
+    vector<tac_loop> loops;
+    for (size_t b = 0; b < blocks.size(); b++) {
+        if (idom[b] < 0) continue;
+        for (int h : blocks[b].succs) {
+            if (!dom.dominates(h, b)) continue;
+            auto it = loop_of_header.find(h);
+            if (it == loop_of_header.end()) {
+                it = loop_of_header.emplace(h, loops.size()).first;
+                loops.push_back({h, {h}, {}});
+            }
+            loops[it->second].latches.push_back(b);
+        }
+    }
+    vector<int> in(blocks.size(), -1); // loop whose body was last found to hold the block
+    for (size_t k = 0; k < loops.size(); k++) {
+        // the body is what reaches a latch backward without passing the header
+        tac_loop& loop = loops[k];
+        in[loop.header] = k;
+        vector<int> work;
+        for (int l : loop.latches) {
+            if (in[l] != (int)k) {
+                in[l] = k;
+                loop.blocks.push_back(l);
+                work.push_back(l);
+            }
+        }
+        while (!work.empty()) {
+            int b = work.back();
+            work.pop_back();
+            for (int p : blocks[b].preds) {
+                if (in[p] != (int)k && idom[p] >= 0) {
+                    in[p] = k;
+                    loop.blocks.push_back(p);
+                    work.push_back(p);
+                }
+            }
+        }
+        sort(loop.blocks.begin(), loop.blocks.end());
+    }
+    stable_sort(loops.begin(), loops.end(), [](const tac_loop& a, const tac_loop& b) { return a.blocks.size() < b.blocks.size(); });
+    for (size_t i = 0; i < loops.size(); i++) {
+        for (size_t j = i + 1; j < loops.size(); j++) {
+            if (loops[j].contains(loops[i].header)) loops[i].depth++;
+        }
+    }
+    return loops;
+}
+
+// The body of each function as a quad range [begin, end), from after its TAC_FUNC quad up to
+// the next one. Global declarations between functions land in the body before them.
+struct tac_function_range {
+    int function; // index into tac_program::functions
+    int begin, end;
+};
+
+inline vector<tac_function_range> function_ranges(const tac_program& code) {
+    vector<tac_function_range> ranges;
+    for (int i = 0; i < (int)code.quads.size(); i++) {
+        if (code.quads[i].op != TAC_FUNC) continue;
+        if (!ranges.empty()) ranges.back().end = i;
+        ranges.push_back({code.quads[i].b.value, i + 1, (int)code.quads.size()});
+    }
+    return ranges;
+}
+
+#endif // TAC_CFG_H
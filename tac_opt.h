@@ -0,0 +1,1402 @@
+#ifndef TAC_OPT_H
+#define TAC_OPT_H
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <functional>
+#include <cstring>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+#include "tac.h"
+#include "tac_cfg.h"
+
+using namespace std;
+
+// Optimization passes over generated three-address code. Each pass works on one function body
+// at a time and marks the quads it deletes; the program is compacted once the pass is done.
+
+// Temps of one function before and after renumbering
+struct tac_temp_stats {
+    int function; // index into tac_program::functions
+    int temps_before; // distinct temps the function used
+    int peak_live; // most temps live at once, which is how many names it uses now
+};
+
+// One natural loop and what loop-invariant code motion took out of it
+struct tac_loop_stats {
+    int function; // index into tac_program::functions
+    int header; // label of the loop header
+    int depth; // 1 for an outermost loop
+    int blocks;
+    int hoisted = 0; // computations moved to the preheader
+    int reduced = 0; // multiplies and shifts replaced by a stepping temp
+    int tests_replaced = 0; // loop tests moved off a counter that could then go
+};
+
+// What the optimizer did, for the compiler's report
+struct tac_opt_stats {
+    size_t instructions_before = 0;
+    size_t instructions_after = 0;
+    size_t values_reused = 0; // computations local value numbering turned into copies
+    size_t jumps_before = 0, jumps_after = 0; // gotos and conditional branches
+    vector<tac_temp_stats> temps; // one entry per function
+    vector<tac_loop_stats> loops;
+
+    // Adds the stats of a unit optimized on its own, whose functions and labels were renumbered
+    // from function_base and label_base when it was appended to the program
+    void add(const tac_opt_stats& part, int function_base, int label_base) {
+        instructions_before += part.instructions_before;
+        instructions_after += part.instructions_after;
+        values_reused += part.values_reused;
+        jumps_before += part.jumps_before;
+        jumps_after += part.jumps_after;
+        for (tac_temp_stats t : part.temps) {
+            t.function += function_base;
+            temps.push_back(t);
+        }
+        for (tac_loop_stats l : part.loops) {
+            l.function += function_base;
+            l.header += label_base;
+            loops.push_back(l);
+        }
+    }
+};
+
+// Fixed-size bit set for the dataflow analyses
+class tac_bitset {
+    private:
+        vector<uint64_t> words;
+
+    public:
+        tac_bitset(size_t bits = 0, bool value = false) : words((bits + 63) / 64, value ? ~(uint64_t)0 : 0) {}
+
+        bool test(int i) const { return words[i >> 6] >> (i & 63) & 1; }
+        void set(int i) { words[i >> 6] |= (uint64_t)1 << (i & 63); }
+        void reset(int i) { words[i >> 6] &= ~((uint64_t)1 << (i & 63)); }
+        size_t word_count() const { return words.size(); }
+
+        template <typename F>
+        void for_each(F f) const {
+            for (size_t w = 0; w < words.size(); w++) {
+                for (uint64_t bits = words[w]; bits; bits &= bits - 1) f((int)(w * 64 + __builtin_ctzll(bits)));
+            }
+        }
+
+        tac_bitset& operator&=(const tac_bitset& o) {
+            for (size_t w = 0; w < words.size(); w++) words[w] &= o.words[w];
+            return *this;
+        }
+        tac_bitset& operator|=(const tac_bitset& o) {
+            for (size_t w = 0; w < words.size(); w++) words[w] |= o.words[w];
+            return *this;
+        }
+        // this = gen | (in & ~kill)
+        void assign_transfer(const tac_bitset& gen, const tac_bitset& in, const tac_bitset& kill) {
+            for (size_t w = 0; w < words.size(); w++) words[w] = gen.words[w] | (in.words[w] & ~kill.words[w]);
+        }
+        bool operator==(const tac_bitset& o) const { return words == o.words; }
+        bool operator!=(const tac_bitset& o) const { return words != o.words; }
+};
+
+// Dense numbering of the scalar storage one function touches: its slots, the program's globals,
+// then the temps it mentions
+class tac_operand_numbering {
+    private:
+        int slot_count = 0;
+        int global_count = 0;
+        int temp_base = 0;
+        int temp_count = 0;
+
+    public:
+        void build(const tac_program& code, const tac_function_range& r) {
+            slot_count = code.functions[r.function].slots.size();
+            global_count = code.globals.size();
+            int lo = INT32_MAX, hi = -1;
+            for (int i = r.begin; i < r.end; i++) {
+                const tac_quad& q = code.quads[i];
+                for (const tac_operand* o : {&q.dst, &q.a, &q.b}) {
+                    if (o->kind != OPND_TEMP) continue;
+                    if (o->value < lo) lo = o->value;
+                    if (o->value > hi) hi = o->value;
+                }
+            }
+            temp_base = hi < 0 ? 0 : lo;
+            temp_count = hi < 0 ? 0 : hi - lo + 1;
+        }
+
+        int size() const { return slot_count + global_count + temp_count; }
+
+        // -1 for operands that are not scalar storage: constants, labels, function names
+        int index(const tac_operand& o) const {
+            switch (o.kind) {
+                case OPND_VAR: return o.value;
+                case OPND_GLOBAL: return slot_count + o.value;
+                case OPND_TEMP: return slot_count + global_count + o.value - temp_base;
+                default: return -1;
+            }
+        }
+
+        bool is_global(int index) const { return index >= slot_count && index < slot_count + global_count; }
+        int first_temp() const { return slot_count + global_count; } // indexes from here on are temps
+};
+
+// Per-block live-out sets of a function's slots and temps. Globals are always live: any call or
+// the caller may read them.
+inline vector<tac_bitset> live_out_sets(vector<tac_quad>& quads, const vector<char>& removed,
+                                        const tac_cfg& cfg, const tac_operand_numbering& num) {
+    size_t nb = cfg.blocks.size();
+    vector<tac_bitset> use(nb, tac_bitset(num.size())), def(nb, tac_bitset(num.size()));
+    for (size_t b = 0; b < nb; b++) {
+        // walking backward, a read is upward exposed unless a later-visited (earlier) def covers it
+        for (int i = cfg.blocks[b].end - 1; i >= cfg.blocks[b].begin; i--) {
+            if (removed[i]) continue;
+            tac_quad& q = quads[i];
+            if (tac_operand* d = quad_def(q)) {
+                int x = num.index(*d);
+                if (x >= 0) {
+                    def[b].set(x);
+                    use[b].reset(x);
+                }
+            }
+            for_each_use(q, [&](tac_operand& o) {
+                int x = num.index(o);
+                if (x >= 0) use[b].set(x);
+            });
+        }
+    }
+
+    vector<tac_bitset> in = use, out(nb, tac_bitset(num.size()));
+    tac_bitset i(num.size());
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t b = nb; b-- > 0;) {
+            tac_bitset& o = out[b];
+            for (int s : cfg.blocks[b].succs) o |= in[s];
+            i.assign_transfer(use[b], o, def[b]);
+            if (i != in[b]) {
+                swap(i, in[b]);
+                changed = true;
+            }
+        }
+    }
+    return out;
+}
+
+// The int an arithmetic, comparison or logical quad computes when all its operands are int
+// constants, wrapping around like the target's 32-bit arithmetic. Returns false for anything
+// else and for what must be left to run time, like a division by zero.
+inline bool fold_int_quad(const tac_quad& q, int& value) {
+    bool unary = q.op == TAC_NEG || q.op == TAC_NOT;
+    if (q.a.kind != OPND_INT || (unary ? !q.b.is_none() : q.b.kind != OPND_INT)) return false;
+    int a = q.a.value, b = q.b.value;
+    bool bad_divide = b == 0 || (a == INT_MIN && b == -1);
+    switch (q.op) {
+        case TAC_ADD: value = (int)((unsigned)a + (unsigned)b); return true;
+        case TAC_SUB: value = (int)((unsigned)a - (unsigned)b); return true;
+        case TAC_MUL: value = (int)((unsigned)a * (unsigned)b); return true;
+        case TAC_DIV: value = bad_divide ? 0 : a / b; return !bad_divide;
+        case TAC_MOD: value = bad_divide ? 0 : a % b; return !bad_divide;
+        case TAC_SHL: value = (int)((unsigned)a << (b & 31)); return true;
+        case TAC_LT: value = a < b; return true;
+        case TAC_GT: value = a > b; return true;
+        case TAC_LE: value = a <= b; return true;
+        case TAC_GE: value = a >= b; return true;
+        case TAC_EQ: value = a == b; return true;
+        case TAC_NE: value = a != b; return true;
+        case TAC_AND: value = a != 0 && b != 0; return true;
+        case TAC_OR: value = a != 0 || b != 0; return true;
+        case TAC_NEG: value = (int)(0u - (unsigned)a); return true;
+        case TAC_NOT: value = a == 0; return true;
+        default: return false;
+    }
+}
+
+class tac_optimizer {
+    private:
+        tac_program& code;
+        vector<char> removed; // per quad of the program, set once a pass deletes it
+        unordered_map<int, size_t> loop_stats_of; // header label -> its tac_loop_stats entry
+
+        // Drops the quads marked removed
+        void compact() {
+            size_t n = 0;
+            for (size_t i = 0; i < code.quads.size(); i++) {
+                if (!removed[i]) code.quads[n++] = code.quads[i];
+            }
+            code.quads.resize(n);
+            removed.assign(n, 0);
+        }
+
+        // Deletes the blocks control can never reach, keeping their declarations
+        void remove_unreachable(const tac_cfg& cfg) {
+            vector<char> live = cfg.reachable();
+            for (size_t b = 0; b < cfg.blocks.size(); b++) {
+                if (live[b]) continue;
+                for (int i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+                    if (code.quads[i].op != TAC_DECL) removed[i] = 1;
+                }
+            }
+        }
+
+        size_t jump_count() const {
+            size_t n = 0;
+            for (const tac_quad& q : code.quads) n += is_jump(q.op);
+            return n;
+        }
+
+        // Next quad of the block after i that is still there, or -1
+        int next_in_block(const tac_block& blk, int i) const {
+            for (int j = i + 1; j < blk.end; j++) {
+                if (!removed[j]) return j;
+            }
+            return -1;
+        }
+
+        // t = expr; x = t  becomes  x = expr  when the copy is t's only use.
+        // This is the shape every assignment takes, since expressions land in a fresh temp.
+        void coalesce_copies(const tac_cfg& cfg, const tac_function_range& r) {
+            tac_operand_numbering num;
+            num.build(code, r);
+            vector<int> uses(num.size(), 0);
+            for (int i = r.begin; i < r.end; i++) {
+                if (removed[i]) continue;
+                for_each_use(code.quads[i], [&](tac_operand& o) {
+                    if (o.kind == OPND_TEMP) uses[num.index(o)]++;
+                });
+            }
+            for (const tac_block& blk : cfg.blocks) {
+                for (int i = blk.begin; i < blk.end; i++) {
+                    if (removed[i]) continue;
+                    tac_operand* d = quad_def(code.quads[i]);
+                    if (!d || d->kind != OPND_TEMP || uses[num.index(*d)] != 1) continue;
+                    int j = next_in_block(blk, i);
+                    if (j < 0) continue;
+                    tac_quad& copy = code.quads[j];
+                    if (copy.op != TAC_COPY || copy.a != *d || copy.type != code.quads[i].type) continue;
+                    *d = copy.dst;
+                    removed[j] = 1;
+                }
+            }
+        }
+
+        // Local value numbering. Within a block every value gets a number; a computation whose
+        // operator and operand numbers were seen before becomes a copy of an operand that still
+        // holds that value, and a copy into an operand that already holds the value is dropped.
+        // Array contents are numbered like scalars: a store gives the array a new number, which
+        // retires every load from the old contents. A call renumbers the globals and global arrays.
+        size_t number_values(const tac_cfg& cfg, const tac_function_range& r) {
+            tac_operand_numbering num;
+            num.build(code, r);
+            vector<int> vn_of(num.size(), -1); // storage -> number of what it holds, -1 if not yet read
+            vector<int> touched;
+            vector<vector<tac_operand>> holders; // number -> operands that held it, checked on use
+            unordered_map<int, int> int_vn;
+            unordered_map<uint64_t, int> float_vn; // by bit pattern
+            struct expr_key {
+                int op, type, a, b;
+                bool operator==(const expr_key& o) const { return op == o.op && type == o.type && a == o.a && b == o.b; }
+            };
+            struct expr_hash {
+                size_t operator()(const expr_key& k) const {
+                    return ((size_t)k.a * 0x9E3779B97F4A7C15ull) ^ ((size_t)k.b * 0xC2B2AE3D27D4EB4Full) ^ (k.op << 8 | k.type);
+                }
+            };
+            unordered_map<expr_key, int, expr_hash> exprs;
+            size_t reused = 0;
+
+            auto fresh = [&]() {
+                holders.emplace_back();
+                return (int)holders.size() - 1;
+            };
+            auto assign = [&](const tac_operand& o, int v) {
+                int x = num.index(o);
+                if (vn_of[x] < 0) touched.push_back(x);
+                vn_of[x] = v;
+                holders[v].push_back(o);
+            };
+            auto value_of = [&](const tac_operand& o) {
+                int x = num.index(o);
+                if (x >= 0) {
+                    if (vn_of[x] < 0) assign(o, fresh());
+                    return vn_of[x];
+                }
+                int* v;
+                if (o.kind == OPND_FLOAT) {
+                    uint64_t bits;
+                    memcpy(&bits, &code.floats[o.value], sizeof(bits));
+                    v = &float_vn.emplace(bits, -1).first->second;
+                } else v = &int_vn.emplace(o.value, -1).first->second;
+                if (*v < 0) {
+                    *v = fresh();
+                    holders[*v].push_back(o);
+                }
+                return *v;
+            };
+            // An operand that still holds v, or none
+            auto holder_of = [&](int v) {
+                for (const tac_operand& h : holders[v]) {
+                    int x = num.index(h);
+                    if (x < 0 || vn_of[x] == v) return h;
+                }
+                return tac_operand();
+            };
+
+            for (const tac_block& blk : cfg.blocks) {
+                for (int i = blk.begin; i < blk.end; i++) {
+                    if (removed[i]) continue;
+                    tac_quad& q = code.quads[i];
+                    if (q.op == TAC_COPY) {
+                        int v = value_of(q.a);
+                        int x = num.index(q.dst);
+                        if (vn_of[x] == v) {
+                            removed[i] = 1;
+                            reused++;
+                        }
+                        else assign(q.dst, v);
+                    }
+                    else if (is_pure_def(q.op)) {
+                        expr_key k = {q.op, q.type, value_of(q.a), q.b.is_none() ? -1 : value_of(q.b)};
+                        // a > b is b < a, and operand order does not matter for commutative operators
+                        if (k.op == TAC_GT || k.op == TAC_GE) {
+                            k.op = k.op == TAC_GT ? TAC_LT : TAC_LE;
+                            swap(k.a, k.b);
+                        }
+                        bool commutative = k.op == TAC_ADD || k.op == TAC_MUL || k.op == TAC_EQ ||
+                                           k.op == TAC_NE || k.op == TAC_AND || k.op == TAC_OR;
+                        if (commutative && k.a > k.b) swap(k.a, k.b);
+                        auto found = exprs.find(k);
+                        if (found != exprs.end()) {
+                            tac_operand h = holder_of(found->second);
+                            if (!h.is_none()) {
+                                q.op = TAC_COPY;
+                                q.a = h;
+                                q.b = tac_operand();
+                                reused++;
+                            }
+                            assign(q.dst, found->second);
+                        } else {
+                            int v = fresh();
+                            exprs.emplace(k, v);
+                            assign(q.dst, v);
+                        }
+                    }
+                    else if (q.op == TAC_STORE) {
+                        // the stored value is what a load of the same element gives until the next store
+                        int idx = value_of(q.a), val = value_of(q.b);
+                        int contents = fresh();
+                        assign(q.dst, contents);
+                        exprs[{TAC_LOAD, q.type, contents, idx}] = val;
+                    }
+                    else if (q.op == TAC_CALL) {
+                        for (int x : touched) {
+                            if (num.is_global(x)) vn_of[x] = -1;
+                        }
+                        if (num.index(q.dst) >= 0) assign(q.dst, fresh());
+                    }
+                }
+                for (int x : touched) vn_of[x] = -1;
+                touched.clear();
+                holders.clear();
+                int_vn.clear();
+                float_vn.clear();
+                exprs.clear();
+            }
+            return reused;
+        }
+
+        // Replaces reads of x with y wherever every path from x = y on gets there without
+        // redefining either, using a forward "available copies" dataflow over the function
+        void propagate_copies(const tac_cfg& cfg, const tac_function_range& r) {
+            tac_operand_numbering num;
+            num.build(code, r);
+
+            // The copies the dataflow tracks, as they read before any rewriting
+            struct copy_info { int dst, src; tac_operand value; };
+            vector<copy_info> copies;
+            vector<int> copy_at(r.end - r.begin, -1); // per quad of the function, its copy
+            vector<vector<int>> touching(num.size()); // storage -> copies naming it
+            vector<int> with_globals; // copies a call can invalidate
+            for (const tac_block& blk : cfg.blocks) {
+                for (int i = blk.begin; i < blk.end; i++) {
+                    const tac_quad& q = code.quads[i];
+                    if (removed[i] || q.op != TAC_COPY) continue;
+                    int d = num.index(q.dst);
+                    if (d < 0) continue;
+                    int s = num.index(q.a);
+                    int c = copies.size();
+                    copies.push_back({d, s, q.a});
+                    copy_at[i - r.begin] = c;
+                    touching[d].push_back(c);
+                    if (s >= 0 && s != d) touching[s].push_back(c);
+                    if (num.is_global(d) || (s >= 0 && num.is_global(s))) with_globals.push_back(c);
+                }
+            }
+            if (copies.empty()) return;
+
+            size_t nc = copies.size(), nb = cfg.blocks.size();
+            auto kill_storage = [&](tac_bitset& avail, tac_bitset* kill, int x) {
+                for (int c : touching[x]) {
+                    avail.reset(c);
+                    if (kill) kill->set(c);
+                }
+            };
+            // Runs quad i over avail; kill collects what the quad invalidates
+            auto transfer = [&](int i, tac_bitset& avail, tac_bitset* kill) {
+                tac_quad& q = code.quads[i];
+                if (q.op == TAC_CALL) {
+                    for (int c : with_globals) {
+                        avail.reset(c);
+                        if (kill) kill->set(c);
+                    }
+                }
+                if (tac_operand* d = quad_def(q)) {
+                    int x = num.index(*d);
+                    if (x >= 0) kill_storage(avail, kill, x);
+                }
+                int c = copy_at[i - r.begin];
+                if (c >= 0 && copies[c].dst != copies[c].src) avail.set(c);
+            };
+
+            // Large functions would need too much memory for per-block sets; they only get
+            // propagation inside each block
+            bool global = nb * tac_bitset(nc).word_count() <= (1u << 22);
+            vector<tac_bitset> in(nb, tac_bitset(nc));
+            if (global) {
+                vector<tac_bitset> gen(nb, tac_bitset(nc)), kill(nb, tac_bitset(nc));
+                vector<tac_bitset> out(nb, tac_bitset(nc, true));
+                for (size_t b = 0; b < nb; b++) {
+                    for (int i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+                        if (!removed[i]) transfer(i, gen[b], &kill[b]);
+                    }
+                }
+                tac_bitset o(nc);
+                bool changed = true;
+                while (changed) {
+                    changed = false;
+                    for (size_t b = 0; b < nb; b++) {
+                        tac_bitset& i = in[b];
+                        if (b != 0 && !cfg.blocks[b].preds.empty()) { // the entry starts with nothing
+                            i = out[cfg.blocks[b].preds[0]];
+                            for (int p : cfg.blocks[b].preds) i &= out[p];
+                        }
+                        o.assign_transfer(gen[b], i, kill[b]);
+                        if (o != out[b]) {
+                            swap(o, out[b]);
+                            changed = true;
+                        }
+                    }
+                }
+            }
+
+            for (size_t b = 0; b < nb; b++) {
+                tac_bitset avail = in[b];
+                for (int i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+                    if (removed[i]) continue;
+                    tac_quad& q = code.quads[i];
+                    for_each_use(q, [&](tac_operand& o) {
+                        // follow x = y = z back to the oldest value still intact
+                        int x = num.index(o);
+                        while (x >= 0) {
+                            int found = -1;
+                            for (int c : touching[x]) {
+                                if (copies[c].dst == x && avail.test(c)) found = c;
+                            }
+                            if (found < 0) break;
+                            o = copies[found].value;
+                            x = copies[found].src;
+                        }
+                    });
+                    transfer(i, avail, nullptr);
+                    if (q.op == TAC_COPY && q.a == q.dst) removed[i] = 1;
+                }
+            }
+        }
+
+        // Turns the quads fold_int_quad can compute into copies of their value, returning whether
+        // there were any
+        bool fold_constants(const tac_function_range& r) {
+            bool changed = false;
+            for (int i = r.begin; i < r.end; i++) {
+                tac_quad& q = code.quads[i];
+                int value;
+                if (removed[i] || !fold_int_quad(q, value)) continue;
+                q = {TAC_COPY, TYPE_INT, q.dst, int_operand(value)};
+                changed = true;
+            }
+            return changed;
+        }
+
+        // Deletes pure computations whose result is never read, until none are left
+        void eliminate_dead_code(const tac_cfg& cfg, const tac_function_range& r) {
+            tac_operand_numbering num;
+            num.build(code, r);
+            bool changed = true;
+            while (changed) {
+                changed = false;
+                vector<tac_bitset> live_out = live_out_sets(code.quads, removed, cfg, num);
+                for (size_t b = 0; b < cfg.blocks.size(); b++) {
+                    tac_bitset live = live_out[b];
+                    for (int i = cfg.blocks[b].end - 1; i >= cfg.blocks[b].begin; i--) {
+                        if (removed[i]) continue;
+                        tac_quad& q = code.quads[i];
+                        if (tac_operand* d = quad_def(q)) {
+                            int x = num.index(*d);
+                            if (x >= 0 && !num.is_global(x)) {
+                                if (!live.test(x) && is_pure_def(q.op)) {
+                                    removed[i] = 1;
+                                    changed = true;
+                                    continue;
+                                }
+                                live.reset(x);
+                            }
+                        }
+                        for_each_use(q, [&](tac_operand& o) {
+                            int x = num.index(o);
+                            if (x >= 0) live.set(x);
+                        });
+                    }
+                }
+            }
+        }
+
+        // Renames the function's temps to t0, t1, ... by linear scan over their live ranges in
+        // quad order, so temps that are never live at the same time share a name.
+        // Position 2i is where quad i reads and 2i+1 where it writes, so t1 = t0 + 1 can reuse t0.
+        tac_temp_stats compact_temps(const tac_cfg& cfg, const tac_function_range& r) {
+            tac_operand_numbering num;
+            num.build(code, r);
+            int base = num.first_temp(), n = num.size() - base;
+            vector<int> start(n, INT_MAX), end(n, -1);
+            auto touch = [&](int x, int pos) {
+                if (x < base) return;
+                x -= base;
+                if (pos < start[x]) start[x] = pos;
+                if (pos > end[x]) end[x] = pos;
+            };
+
+            vector<tac_bitset> live_out = live_out_sets(code.quads, removed, cfg, num);
+            for (size_t b = 0; b < cfg.blocks.size(); b++) {
+                const tac_block& blk = cfg.blocks[b];
+                tac_bitset live = live_out[b];
+                live.for_each([&](int x) { touch(x, 2 * blk.end - 1); });
+                for (int i = blk.end - 1; i >= blk.begin; i--) {
+                    if (removed[i]) continue;
+                    tac_quad& q = code.quads[i];
+                    if (tac_operand* d = quad_def(q)) {
+                        int x = num.index(*d);
+                        if (x >= 0) {
+                            touch(x, 2 * i + 1);
+                            live.reset(x);
+                        }
+                    }
+                    for_each_use(q, [&](tac_operand& o) {
+                        int x = num.index(o);
+                        if (x >= 0) {
+                            touch(x, 2 * i);
+                            live.set(x);
+                        }
+                    });
+                }
+                live.for_each([&](int x) { touch(x, 2 * blk.begin); });
+            }
+
+            vector<int> order;
+            for (int t = 0; t < n; t++) {
+                if (end[t] >= 0) order.push_back(t);
+            }
+            sort(order.begin(), order.end(), [&](int a, int b) { return start[a] < start[b]; });
+
+            vector<int> name(n, -1);
+            priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> active; // end, name
+            priority_queue<int, vector<int>, greater<int>> free_names; // lowest first
+            int names_used = 0;
+            for (int t : order) {
+                while (!active.empty() && active.top().first < start[t]) {
+                    free_names.push(active.top().second);
+                    active.pop();
+                }
+                if (free_names.empty()) name[t] = names_used++;
+                else {
+                    name[t] = free_names.top();
+                    free_names.pop();
+                }
+                active.push({end[t], name[t]});
+            }
+
+            for (int i = r.begin; i < r.end; i++) {
+                tac_quad& q = code.quads[i];
+                for (tac_operand* o : {&q.dst, &q.a, &q.b}) {
+                    if (o->kind == OPND_TEMP) o->value = name[num.index(*o) - base];
+                }
+            }
+            return {r.function, (int)order.size(), names_used};
+        }
+
+        // A basic block as the layout pass sees it: its label and terminator are kept apart from
+        // the body so that jumps can be retargeted, inverted or dropped when the block is placed
+        struct flow_block {
+            enum kind_t { FALL, JUMP, BRANCH, RET, EXIT } kind;
+            int label = -1; // label number, -1 if the block had none
+            vector<tac_quad> body;
+            tac_quad term; // the return of a RET block
+            tac_operand cond; // BRANCH goes to on_true when cond is nonzero, else to on_false
+            int on_true = -1, on_false = -1; // FALL and JUMP go to on_true
+        };
+
+        // Rewrites the jumps of one function and lays its blocks out again, returning the new body.
+        // Jumps to empty blocks are threaded to where those lead, a goto back to a short loop test
+        // gets a copy of the test (so a loop branches once per iteration, at the bottom), and
+        // blocks are placed so that as many edges as possible fall through. A conditional branch
+        // then needs one ifFalse, or one if when its false side follows. Labels nothing jumps to
+        // are dropped, and blocks that are no longer reachable go with them.
+        vector<tac_quad> simplify_control_flow(const tac_function_range& r, int& next_label) {
+            tac_cfg cfg;
+            cfg.build(code.quads, r.begin, r.end);
+            int nb = cfg.blocks.size();
+            vector<flow_block> blocks(nb + 1);
+            vector<tac_quad> trailing; // declarations of globals and of unreachable locals
+            blocks[nb].kind = flow_block::EXIT; // falling off the end of the function
+
+            for (int b = 0; b < nb; b++) {
+                flow_block& fb = blocks[b];
+                int i = cfg.blocks[b].begin, end = cfg.blocks[b].end;
+                if (i < end && code.quads[i].op == TAC_LABEL) fb.label = code.quads[i++].dst.value;
+                const tac_quad* last = end > i ? &code.quads[end - 1] : nullptr;
+                if (last && (is_jump(last->op) || last->op == TAC_RETURN)) end--;
+                else last = nullptr;
+                for (; i < end; i++) {
+                    const tac_quad& q = code.quads[i];
+                    if (q.op == TAC_DECL && q.dst.kind == OPND_GLOBAL) trailing.push_back(q);
+                    else fb.body.push_back(q);
+                }
+                fb.kind = flow_block::FALL;
+                fb.on_true = b + 1;
+                if (!last) continue;
+                if (last->op == TAC_RETURN) {
+                    fb.kind = flow_block::RET;
+                    fb.term = *last;
+                    continue;
+                }
+                int target = cfg.label_block.at(last->dst.value);
+                if (last->op == TAC_GOTO) {
+                    fb.kind = flow_block::JUMP;
+                    fb.on_true = target;
+                    continue;
+                }
+                fb.kind = flow_block::BRANCH;
+                fb.cond = last->a;
+                fb.on_true = last->op == TAC_IF ? target : b + 1;
+                fb.on_false = last->op == TAC_IF ? b + 1 : target;
+            }
+
+            auto is_empty_pass = [&](int b) {
+                return blocks[b].body.empty() && (blocks[b].kind == flow_block::FALL || blocks[b].kind == flow_block::JUMP);
+            };
+            // Where control really goes after entering b: past empty blocks, stopping on a cycle
+            auto thread = [&](int b) {
+                for (int steps = 0; steps <= nb && is_empty_pass(b); steps++) b = blocks[b].on_true;
+                return b;
+            };
+            for (flow_block& fb : blocks) {
+                if (fb.kind == flow_block::RET || fb.kind == flow_block::EXIT) continue;
+                fb.on_true = thread(fb.on_true);
+                if (fb.kind != flow_block::BRANCH) continue;
+                fb.on_false = thread(fb.on_false);
+                bool constant = fb.cond.kind == OPND_INT || fb.cond.kind == OPND_FLOAT;
+                if (constant) {
+                    bool taken = fb.cond.kind == OPND_INT ? fb.cond.value != 0 : code.floats[fb.cond.value] != 0;
+                    if (!taken) fb.on_true = fb.on_false;
+                }
+                if (constant || fb.on_true == fb.on_false) fb.kind = flow_block::JUMP;
+            }
+
+            // Loop inversion: copy the test into the back edge, from the blocks as they were before
+            vector<flow_block::kind_t> kind_before(nb + 1);
+            for (int b = 0; b <= nb; b++) kind_before[b] = blocks[b].kind;
+            for (int b = 0; b < nb; b++) {
+                flow_block& fb = blocks[b];
+                if (fb.kind != flow_block::JUMP || fb.on_true >= b) continue;
+                const flow_block& t = blocks[fb.on_true];
+                if (kind_before[fb.on_true] != flow_block::BRANCH) continue;
+                if (t.body.size() > 4) continue;
+                bool pure = true;
+                for (const tac_quad& q : t.body) pure = pure && is_pure_def(q.op);
+                if (!pure) continue;
+                fb.body.insert(fb.body.end(), t.body.begin(), t.body.end());
+                fb.kind = t.kind;
+                fb.cond = t.cond;
+                fb.on_true = t.on_true;
+                fb.on_false = t.on_false;
+            }
+
+            auto for_each_succ = [&](int b, auto f) {
+                const flow_block& fb = blocks[b];
+                if (fb.kind == flow_block::RET || fb.kind == flow_block::EXIT) return;
+                f(fb.on_true);
+                if (fb.kind == flow_block::BRANCH) f(fb.on_false);
+            };
+            vector<char> reachable(nb + 1, 0);
+            vector<int> work = {0};
+            reachable[0] = 1;
+            while (!work.empty()) {
+                int b = work.back();
+                work.pop_back();
+                for_each_succ(b, [&](int s) {
+                    if (!reachable[s]) {
+                        reachable[s] = 1;
+                        work.push_back(s);
+                    }
+                });
+            }
+            vector<int> unplaced_preds(nb + 1, 0);
+            for (int b = 0; b <= nb; b++) {
+                if (reachable[b]) for_each_succ(b, [&](int s) { unplaced_preds[s]++; });
+            }
+
+            // Greedy chains: after a block comes its preferred successor if that is still free, a
+            // branch's true side first. A block reached by a plain fall or jump is only pulled up
+            // once all its other predecessors are placed, so the join after an if-else stays after
+            // the else. The exit always goes last.
+            vector<int> order;
+            vector<char> placed(nb + 1, 0);
+            int scan = 0;
+            for (int cur = 0; cur >= 0;) {
+                order.push_back(cur);
+                placed[cur] = 1;
+                for_each_succ(cur, [&](int s) { unplaced_preds[s]--; });
+                const flow_block& fb = blocks[cur];
+                int next = -1;
+                auto free = [&](int s) { return s >= 0 && s < nb && !placed[s]; };
+                if (fb.kind == flow_block::BRANCH) {
+                    if (free(fb.on_true)) next = fb.on_true;
+                    else if (free(fb.on_false)) next = fb.on_false;
+                } else if (fb.kind == flow_block::FALL || fb.kind == flow_block::JUMP) {
+                    if (free(fb.on_true) && unplaced_preds[fb.on_true] == 0) next = fb.on_true;
+                }
+                while (next < 0 && scan < nb) {
+                    if (reachable[scan] && !placed[scan]) next = scan;
+                    else scan++;
+                }
+                cur = next;
+            }
+            if (reachable[nb]) order.push_back(nb);
+
+            // Terminators first, so that only labels something jumps to get emitted
+            vector<int> position(nb + 1, -1);
+            for (int k = 0; k < (int)order.size(); k++) position[order[k]] = k;
+            vector<char> referenced(nb + 1, 0);
+            vector<vector<tac_quad>> terms(order.size());
+            auto label_of = [&](int b) {
+                referenced[b] = 1;
+                if (blocks[b].label < 0) blocks[b].label = next_label++;
+                return label_operand(blocks[b].label);
+            };
+            for (int k = 0; k < (int)order.size(); k++) {
+                const flow_block& fb = blocks[order[k]];
+                int next = k + 1 < (int)order.size() ? order[k + 1] : -1;
+                if (fb.kind == flow_block::RET) terms[k].push_back(fb.term);
+                else if (fb.kind == flow_block::BRANCH) {
+                    if (fb.on_true == next) terms[k].push_back({TAC_IFFALSE, TYPE_NONE, label_of(fb.on_false), fb.cond});
+                    else {
+                        terms[k].push_back({TAC_IF, TYPE_NONE, label_of(fb.on_true), fb.cond});
+                        if (fb.on_false != next) terms[k].push_back({TAC_GOTO, TYPE_NONE, label_of(fb.on_false)});
+                    }
+                } else if (fb.kind != flow_block::EXIT && fb.on_true != next) {
+                    terms[k].push_back({TAC_GOTO, TYPE_NONE, label_of(fb.on_true)});
+                }
+            }
+
+            vector<tac_quad> out;
+            for (int k = 0; k < (int)order.size(); k++) {
+                const flow_block& fb = blocks[order[k]];
+                if (referenced[order[k]]) out.push_back({TAC_LABEL, TYPE_NONE, label_operand(fb.label)});
+                out.insert(out.end(), fb.body.begin(), fb.body.end());
+                out.insert(out.end(), terms[k].begin(), terms[k].end());
+            }
+            for (int b = 0; b < nb; b++) {
+                if (reachable[b]) continue;
+                for (const tac_quad& q : blocks[b].body) {
+                    if (q.op == TAC_DECL) out.push_back(q);
+                }
+            }
+            out.insert(out.end(), trailing.begin(), trailing.end());
+            return out;
+        }
+
+        // Puts body in place of the function's quads; the function must be the last one in code
+        void replace_tail(tac_function_range& r, const vector<tac_quad>& body) {
+            code.quads.resize(r.begin);
+            code.quads.insert(code.quads.end(), body.begin(), body.end());
+            removed.resize(r.begin);
+            removed.resize(code.quads.size(), 0);
+            r.end = code.quads.size();
+        }
+
+        // Per-block live-in sets of the function's slots and temps
+        vector<tac_bitset> live_in_sets(const tac_cfg& cfg, const tac_operand_numbering& num) {
+            vector<tac_bitset> live = live_out_sets(code.quads, removed, cfg, num);
+            for (size_t b = 0; b < cfg.blocks.size(); b++) {
+                for (int i = cfg.blocks[b].end - 1; i >= cfg.blocks[b].begin; i--) {
+                    if (removed[i]) continue;
+                    tac_quad& q = code.quads[i];
+                    if (tac_operand* d = quad_def(q)) {
+                        if (num.index(*d) >= 0) live[b].reset(num.index(*d));
+                    }
+                    for_each_use(q, [&](tac_operand& o) { if (num.index(o) >= 0) live[b].set(num.index(o)); });
+                }
+            }
+            return live;
+        }
+
+        // Label block b starts with, or -1
+        int label_at(const tac_cfg& cfg, int b) const {
+            const tac_block& blk = cfg.blocks[b];
+            return blk.end > blk.begin && code.quads[blk.begin].op == TAC_LABEL ? code.quads[blk.begin].dst.value : -1;
+        }
+
+        // The entry for a loop of the function being optimized, created when first seen
+        tac_loop_stats& stats_for(vector<tac_loop_stats>& loop_stats, const tac_function_range& r, const tac_loop& loop, int header_label) {
+            auto it = loop_stats_of.find(header_label);
+            if (it == loop_stats_of.end() || it->second >= loop_stats.size() || loop_stats[it->second].function != r.function) {
+                it = loop_stats_of.insert_or_assign(header_label, loop_stats.size()).first;
+                loop_stats.push_back({r.function, header_label, loop.depth, (int)loop.blocks.size()});
+            }
+            return loop_stats[it->second];
+        }
+
+        // What goes in front of the loop header so that code runs once on the way into the loop:
+        // a label for the jumps from outside the loop, which are retargeted to it, and code. A
+        // block of the loop that falls into the header now has to jump over it.
+        vector<tac_quad> make_preheader(const tac_cfg& cfg, const tac_loop& loop, int header_label, int& next_label,
+                                        const vector<tac_quad>& code_to_run) {
+            tac_operand header = label_operand(header_label);
+            tac_operand entry = label_operand(next_label++);
+            bool jumped_to = false, fall_from_loop = false;
+            for (int p : cfg.blocks[loop.header].preds) {
+                tac_quad& last = code.quads[cfg.blocks[p].end - 1];
+                bool jumps = cfg.blocks[p].end > cfg.blocks[p].begin && is_jump(last.op) && last.dst == header;
+                if (loop.contains(p)) {
+                    if (p + 1 == loop.header && !(jumps && last.op == TAC_GOTO)) fall_from_loop = true;
+                } else if (jumps) {
+                    last.dst = entry;
+                    jumped_to = true;
+                }
+            }
+            vector<tac_quad> pre;
+            if (fall_from_loop) pre.push_back({TAC_GOTO, TYPE_NONE, header});
+            if (jumped_to) pre.push_back({TAC_LABEL, TYPE_NONE, entry});
+            pre.insert(pre.end(), code_to_run.begin(), code_to_run.end());
+            return pre;
+        }
+
+        // Loop-invariant code motion. A pure computation into a temp moves to its loop's preheader
+        // when its operands do not change in the loop, it is the temp's only definition there and
+        // the temp is not live into the header, nor out of the loop unless the computation runs on
+        // every iteration. Loads and divisions that could fault must run on every iteration anyway:
+        // their block has to dominate the loop's exits. A load is invariant when the loop does not
+        // store to the array and, for a global array, makes no call.
+        // Each round moves code out of one level of nesting and rewrites the function, which must
+        // be the last one in code; rounds repeat until nothing moves.
+        void hoist_invariants(tac_function_range& r, int& next_label, vector<tac_loop_stats>& loop_stats) {
+            for (;;) {
+                tac_cfg cfg;
+                cfg.build(code.quads, r.begin, r.end);
+                tac_dominators dom(cfg);
+                vector<tac_loop> loops = cfg.natural_loops(dom);
+                if (loops.empty()) return;
+
+                int nb = cfg.blocks.size();
+                vector<int> rank(nb, -1);
+                vector<int> rpo = cfg.reverse_postorder();
+                for (size_t k = 0; k < rpo.size(); k++) rank[rpo[k]] = k;
+                tac_operand_numbering num;
+                num.build(code, r);
+                vector<tac_bitset> live_in = live_in_sets(cfg, num);
+
+                vector<char> hoisted(r.end - r.begin, 0);
+                unordered_map<int, vector<tac_quad>> preheader; // header's first quad -> quads moved before it
+                for (const tac_loop& loop : loops) {
+                    int header_label = label_at(cfg, loop.header);
+                    if (header_label < 0) continue;
+                    tac_loop_stats& stats = stats_for(loop_stats, r, loop, header_label);
+
+                    vector<int> defs(num.size(), 0);
+                    bool calls = false;
+                    vector<int> exiting, exit_targets;
+                    for (int b : loop.blocks) {
+                        for (int i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+                            tac_quad& q = code.quads[i];
+                            if (tac_operand* d = quad_def(q)) {
+                                if (num.index(*d) >= 0) defs[num.index(*d)]++;
+                            }
+                            if (q.op == TAC_STORE) defs[num.index(q.dst)]++;
+                            if (q.op == TAC_CALL) calls = true;
+                        }
+                        bool exits = cfg.blocks[b].end > cfg.blocks[b].begin && code.quads[cfg.blocks[b].end - 1].op == TAC_RETURN;
+                        for (int s : cfg.blocks[b].succs) {
+                            if (loop.contains(s)) continue;
+                            exits = true;
+                            exit_targets.push_back(s);
+                        }
+                        if (exits) exiting.push_back(b);
+                    }
+
+                    vector<char> invariant(num.size(), 0);
+                    auto fixed = [&](const tac_operand& o) {
+                        int x = num.index(o);
+                        if (x < 0) return true;
+                        if (calls && num.is_global(x)) return false;
+                        return defs[x] == 0 || invariant[x];
+                    };
+                    auto runs_every_iteration = [&](int b) {
+                        for (int e : exiting) {
+                            if (!dom.dominates(b, e)) return false;
+                        }
+                        return !exiting.empty();
+                    };
+                    vector<int> blocks = loop.blocks;
+                    sort(blocks.begin(), blocks.end(), [&](int a, int b) { return rank[a] < rank[b]; });
+                    vector<int> moved;
+                    for (bool changed = true; changed;) {
+                        changed = false;
+                        for (int b : blocks) {
+                            for (int i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+                                tac_quad& q = code.quads[i];
+                                if (hoisted[i - r.begin] || !is_pure_def(q.op) || q.dst.kind != OPND_TEMP) continue;
+                                int x = num.index(q.dst);
+                                if (defs[x] != 1 || invariant[x] || live_in[loop.header].test(x)) continue;
+                                if (!fixed(q.a) || !fixed(q.b)) continue;
+                                bool every = runs_every_iteration(b);
+                                bool faults = q.op == TAC_LOAD ||
+                                              ((q.op == TAC_DIV || q.op == TAC_MOD) && q.type == TYPE_INT &&
+                                               !(q.b.kind == OPND_INT && q.b.value != 0 && q.b.value != -1));
+                                if (faults && !every) continue;
+                                bool live_after = false;
+                                for (int s : exit_targets) live_after = live_after || live_in[s].test(x);
+                                if (live_after && !every) continue;
+                                invariant[x] = 1;
+                                hoisted[i - r.begin] = 1;
+                                moved.push_back(i);
+                                changed = true;
+                            }
+                        }
+                    }
+                    if (moved.empty()) continue;
+                    // a definition dominates the uses it feeds, so this is an order that works
+                    sort(moved.begin(), moved.end(), [&](int a, int b) {
+                        int ra = rank[cfg.block_of(a)], rb = rank[cfg.block_of(b)];
+                        return ra != rb ? ra < rb : a < b;
+                    });
+                    stats.hoisted += moved.size();
+
+                    vector<tac_quad> pre;
+                    for (int i : moved) pre.push_back(code.quads[i]);
+                    preheader[cfg.blocks[loop.header].begin] = make_preheader(cfg, loop, header_label, next_label, pre);
+                }
+                if (preheader.empty()) return;
+                bool nested = false;
+                for (const tac_loop& loop : loops) nested = nested || (loop.depth > 1 && preheader.count(cfg.blocks[loop.header].begin));
+
+                vector<tac_quad> body;
+                body.reserve(r.end - r.begin);
+                for (int i = r.begin; i < r.end; i++) {
+                    auto it = preheader.find(i);
+                    if (it != preheader.end()) body.insert(body.end(), it->second.begin(), it->second.end());
+                    if (!hoisted[i - r.begin]) body.push_back(code.quads[i]);
+                }
+                replace_tail(r, body);
+                if (!nested) return; // what moved is out of every loop already
+            }
+        }
+
+        // Induction variables. A basic induction variable is a local that the loop changes only by
+        // one i = i + c. A quad that computes a*i + b from it, through +, -, unary minus, copies,
+        // and * or << by constants, with loop-invariant terms, is a derived one. The multiplies and
+        // shifts among those are strength-reduced: a new temp starts at their value in the
+        // preheader, steps by a*c right after i does, and the quad becomes a copy of it.
+        // Linear-function test replacement then turns an ordering test of i against an invariant
+        // n into one of such a temp with a > 0 against a*n + b. This only happens when i is
+        // dead after the loop and the loop reads i nowhere else, so that its step can go too. Like a
+        // C compiler, this assumes the int arithmetic does not overflow.
+        // Inner loops are done before the loops around them. The function must be the last one in
+        // code.
+        void reduce_induction_variables(tac_function_range& r, int& next_label, vector<tac_loop_stats>& loop_stats) {
+            unordered_map<int, char> done; // header labels of the loops already processed
+            bool changed = false;
+            for (bool progress = true; progress;) {
+                progress = false;
+                tac_cfg cfg;
+                cfg.build(code.quads, r.begin, r.end);
+                vector<tac_loop> loops = cfg.natural_loops(tac_dominators(cfg));
+                bool pending = false;
+                for (const tac_loop& loop : loops) {
+                    int header_label = label_at(cfg, loop.header);
+                    pending = pending || (header_label >= 0 && !done.count(header_label));
+                }
+                if (!pending) break;
+                tac_operand_numbering num;
+                num.build(code, r);
+                vector<tac_bitset> live_in = live_in_sets(cfg, num);
+                int next_temp = 0;
+                vector<char> float_temp; // temps some quad gives a float value
+                for (int i = r.begin; i < r.end; i++) {
+                    const tac_quad& q = code.quads[i];
+                    for (const tac_operand* o : {&q.dst, &q.a, &q.b}) {
+                        if (o->kind == OPND_TEMP) next_temp = max(next_temp, o->value + 1);
+                    }
+                }
+                float_temp.assign(next_temp, 0);
+                for (int i = r.begin; i < r.end; i++) {
+                    const tac_quad& q = code.quads[i];
+                    if (quad_def(const_cast<tac_quad&>(q)) && q.dst.kind == OPND_TEMP && q.type == TYPE_FLOAT) float_temp[q.dst.value] = 1;
+                }
+                auto is_int = [&](const tac_operand& o) {
+                    switch (o.kind) {
+                        case OPND_INT: return true;
+                        case OPND_VAR: return code.functions[r.function].slots[o.value].type == TYPE_INT;
+                        case OPND_GLOBAL: return code.globals[o.value].type == TYPE_INT;
+                        case OPND_TEMP: return !float_temp[o.value];
+                        default: return false;
+                    }
+                };
+
+                unordered_map<int, vector<tac_quad>> preheader, after; // quads to insert before / after a quad
+                vector<char> deleted(r.end - r.begin, 0);
+                vector<pair<int, tac_quad>> rewrites;
+                for (const tac_loop& loop : loops) {
+                    int header_label = label_at(cfg, loop.header);
+                    if (header_label < 0 || done.count(header_label)) continue;
+                    bool inner_pending = false;
+                    for (const tac_loop& other : loops) {
+                        int other_label = label_at(cfg, other.header);
+                        if (&other != &loop && loop.contains(other.header) && !done.count(other_label)) inner_pending = true;
+                    }
+                    if (inner_pending) continue;
+                    done[header_label] = 1;
+                    progress = true;
+                    tac_loop_stats& stats = stats_for(loop_stats, r, loop, header_label);
+
+                    vector<int> defs(num.size(), 0);
+                    bool calls = false;
+                    vector<int> body, exit_targets;
+                    for (int b : loop.blocks) {
+                        for (int i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+                            tac_quad& q = code.quads[i];
+                            body.push_back(i);
+                            if (tac_operand* d = quad_def(q)) {
+                                if (num.index(*d) >= 0) defs[num.index(*d)]++;
+                            }
+                            if (q.op == TAC_STORE) defs[num.index(q.dst)]++;
+                            if (q.op == TAC_CALL) calls = true;
+                        }
+                        for (int s : cfg.blocks[b].succs) {
+                            if (!loop.contains(s)) exit_targets.push_back(s);
+                        }
+                    }
+                    auto invariant = [&](const tac_operand& o) {
+                        int x = num.index(o);
+                        if (x < 0) return o.kind == OPND_INT || o.kind == OPND_FLOAT;
+                        return defs[x] == 0 && !(calls && num.is_global(x));
+                    };
+
+                    struct basic_iv { int update; unsigned step; };
+                    unordered_map<int, basic_iv> basic; // storage -> its only definition in the loop
+                    for (int i : body) {
+                        const tac_quad& q = code.quads[i];
+                        if ((q.op != TAC_ADD && q.op != TAC_SUB) || q.type != TYPE_INT) continue;
+                        if (q.dst.kind != OPND_VAR && q.dst.kind != OPND_TEMP) continue;
+                        int x = num.index(q.dst);
+                        if (defs[x] != 1) continue;
+                        if (q.a == q.dst && q.b.kind == OPND_INT) {
+                            basic[x] = {i, q.op == TAC_ADD ? (unsigned)q.b.value : 0u - (unsigned)q.b.value};
+                        } else if (q.op == TAC_ADD && q.b == q.dst && q.a.kind == OPND_INT) {
+                            basic[x] = {i, (unsigned)q.a.value};
+                        }
+                    }
+                    // i = t after t = i + c in the same block, which is what value numbering leaves
+                    // of i++ when i + 1 was already computed
+                    for (int b : loop.blocks) {
+                        for (int i = cfg.blocks[b].begin + 1; i < cfg.blocks[b].end; i++) {
+                            const tac_quad& q = code.quads[i];
+                            if (q.op != TAC_COPY || q.type != TYPE_INT || q.a.kind != OPND_TEMP) continue;
+                            if (q.dst.kind != OPND_VAR && q.dst.kind != OPND_TEMP) continue;
+                            int x = num.index(q.dst);
+                            if (defs[x] != 1 || defs[num.index(q.a)] != 1 || basic.count(x)) continue;
+                            for (int j = i - 1; j >= cfg.blocks[b].begin; j--) {
+                                const tac_quad& add = code.quads[j];
+                                if (add.op == TAC_ADD && add.dst == q.a && add.a == q.dst && add.b.kind == OPND_INT) {
+                                    basic[x] = {i, (unsigned)add.b.value};
+                                }
+                                if (quad_def(const_cast<tac_quad&>(add)) && (add.dst == q.a || add.dst == q.dst)) break;
+                            }
+                        }
+                    }
+                    if (basic.empty()) continue;
+
+                    // Derived quads, block by block: current says which derived quad's value each
+                    // storage holds at this point, until it is redefined or its basic variable steps
+                    struct derived_iv {
+                        int basic; // storage
+                        unsigned scale; // a, in wrapping int arithmetic
+                        int iv_operand; // 0 when a is the induction operand, 1 when b is
+                        int source; // derived quad that computed the induction operand, -1 if basic
+                    };
+                    unordered_map<int, derived_iv> derived; // quad -> its form
+                    vector<int> derived_order;
+                    for (int b : loop.blocks) {
+                        unordered_map<int, int> current;
+                        for (int i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+                            const tac_quad& q = code.quads[i];
+                            tac_operand* d = quad_def(const_cast<tac_quad&>(q));
+                            int dx = d ? num.index(*d) : -1;
+                            auto step = basic.find(dx);
+                            if (step != basic.end() && step->second.update == i) {
+                                for (auto it = current.begin(); it != current.end();) {
+                                    if (derived[it->second].basic == dx) it = current.erase(it);
+                                    else ++it;
+                                }
+                                continue;
+                            }
+                            derived_iv form = {-1, 0, 0, -1};
+                            auto iv_of = [&](const tac_operand& o, int which) {
+                                int x = num.index(o);
+                                if (x < 0) return false;
+                                if (basic.count(x)) form = {x, 1, which, -1};
+                                else if (current.count(x)) form = {derived[current[x]].basic, derived[current[x]].scale, which, current[x]};
+                                else return false;
+                                return true;
+                            };
+                            if (dx >= 0 && !num.is_global(dx) && !basic.count(dx) && q.type == TYPE_INT) {
+                                switch (q.op) {
+                                    case TAC_COPY:
+                                        iv_of(q.a, 0);
+                                        break;
+                                    case TAC_NEG:
+                                        if (iv_of(q.a, 0)) form.scale = 0u - form.scale;
+                                        break;
+                                    case TAC_ADD:
+                                        if (!(iv_of(q.a, 0) && invariant(q.b))) {
+                                            form.basic = -1;
+                                            if (!(iv_of(q.b, 1) && invariant(q.a))) form.basic = -1;
+                                        }
+                                        break;
+                                    case TAC_SUB:
+                                        if (iv_of(q.a, 0) && invariant(q.b)) break;
+                                        form.basic = -1;
+                                        if (iv_of(q.b, 1) && invariant(q.a)) form.scale = 0u - form.scale;
+                                        else form.basic = -1;
+                                        break;
+                                    case TAC_MUL:
+                                        if (iv_of(q.a, 0) && q.b.kind == OPND_INT) form.scale *= (unsigned)q.b.value;
+                                        else {
+                                            form.basic = -1;
+                                            if (iv_of(q.b, 1) && q.a.kind == OPND_INT) form.scale *= (unsigned)q.a.value;
+                                            else form.basic = -1;
+                                        }
+                                        break;
+                                    case TAC_SHL:
+                                        if (iv_of(q.a, 0) && q.b.kind == OPND_INT && q.b.value >= 0 && q.b.value < 32) form.scale <<= q.b.value;
+                                        else form.basic = -1;
+                                        break;
+                                    default:
+                                        break;
+                                }
+                            }
+                            if (dx >= 0) current.erase(dx);
+                            if (form.basic >= 0 && form.scale != 0) {
+                                derived[i] = form;
+                                derived_order.push_back(i);
+                                current[dx] = i;
+                            }
+                        }
+                    }
+
+                    // Code in the preheader for the value quad i has on entry, with the basic
+                    // variable's value replaced by start
+                    vector<tac_quad> pre;
+                    function<tac_operand(int, tac_operand)> replicate = [&](int i, tac_operand start) {
+                        const derived_iv& form = derived.at(i);
+                        tac_quad q = code.quads[i];
+                        (form.iv_operand == 0 ? q.a : q.b) = form.source < 0 ? start : replicate(form.source, start);
+                        int value;
+                        if (fold_int_quad(q, value)) return int_operand(value);
+                        if (q.op == TAC_COPY && q.a.kind == OPND_INT) return q.a;
+                        q.dst = temp_operand(next_temp++);
+                        pre.push_back(q);
+                        return q.dst;
+                    };
+                    unordered_map<int, tac_operand> reduced; // quad -> temp that now carries its value
+                    for (int i : derived_order) {
+                        const tac_quad& q = code.quads[i];
+                        if (q.op != TAC_MUL && q.op != TAC_SHL) continue;
+                        const derived_iv& form = derived[i];
+                        const basic_iv& iv = basic[form.basic];
+                        tac_operand temp = replicate(i, code.quads[iv.update].dst);
+                        after[iv.update].push_back({TAC_ADD, TYPE_INT, temp, temp, int_operand((int)(form.scale * iv.step))});
+                        rewrites.push_back({i, {TAC_COPY, TYPE_INT, q.dst, temp}});
+                        reduced[i] = temp;
+                        stats.reduced++;
+                    }
+
+                    // A derived quad is absorbed when its value ends up only in reduced quads
+                    unordered_map<int, vector<int>> readers; // storage -> quads of the loop reading it
+                    for (int i : body) {
+                        for_each_use(code.quads[i], [&](tac_operand& o) {
+                            if (num.index(o) >= 0) readers[num.index(o)].push_back(i);
+                        });
+                    }
+                    auto dead_after = [&](int x) {
+                        for (int s : exit_targets) {
+                            if (live_in[s].test(x)) return false;
+                        }
+                        return true;
+                    };
+                    unordered_map<int, char> absorbed_memo;
+                    function<bool(int)> absorbed = [&](int i) {
+                        if (reduced.count(i)) return true;
+                        if (!derived.count(i)) return false;
+                        auto memo = absorbed_memo.find(i);
+                        if (memo != absorbed_memo.end()) return memo->second == 1;
+                        absorbed_memo[i] = 0;
+                        const tac_operand& dst = code.quads[i].dst;
+                        int x = num.index(dst);
+                        bool ok = dst.kind == OPND_TEMP && !live_in[loop.header].test(x) && dead_after(x);
+                        for (int reader : readers[x]) ok = ok && absorbed(reader);
+                        absorbed_memo[i] = ok;
+                        return ok;
+                    };
+
+                    for (auto& [x, iv] : basic) {
+                        int best = -1;
+                        for (int i : derived_order) {
+                            if (reduced.count(i) && derived[i].basic == x && (int)derived[i].scale > 0) {
+                                best = i;
+                                break;
+                            }
+                        }
+                        if (best < 0 || !dead_after(x)) continue;
+                        vector<int> tests;
+                        bool replaceable = true;
+                        for (int i : readers[x]) {
+                            const tac_quad& q = code.quads[i];
+                            bool ordering = q.op == TAC_LT || q.op == TAC_GT || q.op == TAC_LE || q.op == TAC_GE;
+                            bool test = ordering && ((num.index(q.a) == x && invariant(q.b) && is_int(q.b)) ||
+                                                     (num.index(q.b) == x && invariant(q.a) && is_int(q.a)));
+                            if (test) tests.push_back(i);
+                            else if (i != iv.update && !absorbed(i)) replaceable = false;
+                        }
+                        if (!replaceable || tests.empty()) continue;
+                        for (int i : tests) {
+                            tac_quad q = code.quads[i];
+                            tac_operand& counter = num.index(q.a) == x ? q.a : q.b;
+                            tac_operand& bound = num.index(q.a) == x ? q.b : q.a;
+                            bound = replicate(best, bound);
+                            counter = reduced[best];
+                            rewrites.push_back({i, q});
+                        }
+                        deleted[iv.update - r.begin] = 1;
+                        stats.tests_replaced += tests.size();
+                    }
+
+                    if (!pre.empty()) {
+                        preheader[cfg.blocks[loop.header].begin] = make_preheader(cfg, loop, header_label, next_label, pre);
+                    }
+                }
+                if (preheader.empty() && rewrites.empty()) continue;
+
+                changed = true;
+                for (auto& [i, q] : rewrites) code.quads[i] = q;
+                vector<tac_quad> body;
+                body.reserve(r.end - r.begin);
+                for (int i = r.begin; i < r.end; i++) {
+                    auto it = preheader.find(i);
+                    if (it != preheader.end()) body.insert(body.end(), it->second.begin(), it->second.end());
+                    if (!deleted[i - r.begin]) body.push_back(code.quads[i]);
+                    it = after.find(i);
+                    if (it != after.end()) body.insert(body.end(), it->second.begin(), it->second.end());
+                }
+                replace_tail(r, body);
+            }
+            if (!changed) return;
+
+            // the reduced quads are copies now and the code that fed them is dead. The preheader
+            // code was built from the counters, so it computes from their start values once those
+            // are propagated.
+            tac_cfg cfg;
+            cfg.build(code.quads, r.begin, r.end);
+            propagate_copies(cfg, r);
+            while (fold_constants(r)) propagate_copies(cfg, r);
+            eliminate_dead_code(cfg, r);
+            vector<tac_quad> body;
+            for (int i = r.begin; i < r.end; i++) {
+                if (!removed[i]) body.push_back(code.quads[i]);
+            }
+            replace_tail(r, body);
+        }
+
+    public:
+        tac_optimizer(tac_program& code) : code(code), removed(code.quads.size(), 0) {}
+
+        // Level 0 leaves the code alone; level 1 removes unreachable code, reuses values computed
+        // earlier in a block, propagates copies, deletes dead computations, simplifies jumps and
+        // lays out blocks for fall-through, hoists loop invariants, strength-reduces induction
+        // variables and renumbers temps from t0 in each function
+        void run(int level, tac_opt_stats& stats) {
+            stats.instructions_before = code.instruction_count();
+            stats.jumps_before = jump_count();
+            if (level >= 1) {
+                for (const tac_function_range& r : function_ranges(code)) {
+                    tac_cfg cfg;
+                    cfg.build(code.quads, r.begin, r.end);
+                    remove_unreachable(cfg);
+                    coalesce_copies(cfg, r);
+                    stats.values_reused += number_values(cfg, r);
+                    propagate_copies(cfg, r);
+                    eliminate_dead_code(cfg, r);
+                }
+                compact();
+
+                // The remaining passes rewrite one function at a time; each is moved to the end of
+                // the program while it is being worked on, so that it can grow or shrink
+                int next_label = 0;
+                for (const tac_quad& q : code.quads) {
+                    if (q.op == TAC_LABEL) next_label = max(next_label, q.dst.value + 1);
+                }
+                vector<tac_function_range> ranges = function_ranges(code);
+                size_t prefix = ranges.empty() ? code.quads.size() : ranges[0].begin - 1; // globals before any function
+                vector<tac_quad> source;
+                source.swap(code.quads);
+                code.quads.assign(source.begin(), source.begin() + prefix);
+                for (const tac_function_range& s : ranges) {
+                    code.quads.push_back(source[s.begin - 1]);
+                    tac_function_range r = {s.function, (int)code.quads.size(), (int)code.quads.size()};
+                    code.quads.insert(code.quads.end(), source.begin() + s.begin, source.begin() + s.end);
+                    r.end = code.quads.size();
+                    removed.resize(r.begin);
+                    removed.resize(r.end, 0);
+                    replace_tail(r, simplify_control_flow(r, next_label));
+                    hoist_invariants(r, next_label, stats.loops);
+                    reduce_induction_variables(r, next_label, stats.loops);
+                    // Propagating the counters' start values can settle a loop test copied in
+                    // front of the loop; the jump on it then goes, or becomes a goto
+                    auto constant_jump = [](const tac_quad& q) {
+                        return (q.op == TAC_IF || q.op == TAC_IFFALSE) && (q.a.kind == OPND_INT || q.a.kind == OPND_FLOAT);
+                    };
+                    if (any_of(code.quads.begin() + r.begin, code.quads.begin() + r.end, constant_jump)) {
+                        replace_tail(r, simplify_control_flow(r, next_label));
+                    }
+
+                    tac_cfg cfg;
+                    cfg.build(code.quads, r.begin, r.end);
+                    stats.temps.push_back(compact_temps(cfg, r));
+                }
+            }
+            stats.instructions_after = code.instruction_count();
+            stats.jumps_after = jump_count();
+        }
+};
+
+#endif // TAC_OPT_H
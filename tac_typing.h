@@ -0,0 +1,120 @@
+#ifndef TAC_TYPING_H
+#define TAC_TYPING_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "tac.h"
+#include "tac_cfg.h"
+
+using namespace std;
+
+// Types of the values a program keeps, for consumers that store ints and floats differently:
+// the virtual machine and the native backends. The quads only record the type each one
+// produces; operands carry no type, and the source language mixes ints and floats freely.
+
+// How a value of type t is stored: floats as doubles, everything else as an int
+inline data_type value_type(data_type t) { return t == TYPE_FLOAT ? TYPE_FLOAT : TYPE_INT; }
+
+// Type of the value q leaves in its destination temp
+inline data_type def_type(const tac_quad& q) { return value_type(q.type); }
+
+inline bool defines_temp(const tac_quad& q) {
+    return (is_pure_def(q.op) || q.op == TAC_CALL) && q.dst.kind == OPND_TEMP;
+}
+
+// Renumbering can give one temp name to an int temp in one part of a function and to a float
+// temp in another. This gives the float uses of such names a name of their own, so that every
+// temp of the program holds one type throughout. Reads are typed by the writes that reach them
+// along the control flow. Fails only when a read could see both an int and a float.
+inline bool split_mixed_temps(tac_program& code, string& error) {
+    for (const tac_function_range& r : function_ranges(code)) {
+        unordered_map<int, data_type> first_type;
+        unordered_map<int, int> mixed; // temp -> index among the mixed ones
+        int next_temp = 0;
+        for (int i = r.begin; i < r.end; i++) {
+            const tac_quad& q = code.quads[i];
+            for (const tac_operand* o : {&q.dst, &q.a, &q.b}) {
+                if (o->kind == OPND_TEMP && o->value >= next_temp) next_temp = o->value + 1;
+            }
+            if (!defines_temp(q)) continue;
+            auto [it, added] = first_type.emplace(q.dst.value, def_type(q));
+            if (!added && it->second != def_type(q) && !mixed.count(q.dst.value)) {
+                int k = mixed.size();
+                mixed.emplace(q.dst.value, k);
+            }
+        }
+        if (mixed.empty()) continue;
+
+        // forward dataflow of the type reaching each block entry: TYPE_NONE until a write is
+        // seen, TYPE_ERROR once writes of both types are
+        tac_cfg cfg;
+        cfg.build(code.quads, r.begin, r.end);
+        size_t k = mixed.size();
+        vector<vector<data_type>> entry(cfg.blocks.size(), vector<data_type>(k, TYPE_NONE));
+        vector<data_type> now;
+        auto step = [&](const tac_quad& q) {
+            if (!defines_temp(q)) return;
+            auto it = mixed.find(q.dst.value);
+            if (it != mixed.end()) now[it->second] = def_type(q);
+        };
+        vector<int> order = cfg.reverse_postorder();
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (int b : order) {
+                now = entry[b];
+                for (int i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) step(code.quads[i]);
+                for (int s : cfg.blocks[b].succs) {
+                    for (size_t x = 0; x < k; x++) {
+                        data_type& in = entry[s][x];
+                        data_type joined = in == TYPE_NONE ? now[x]
+                                         : now[x] == TYPE_NONE || now[x] == in ? in : TYPE_ERROR;
+                        if (joined != in) {
+                            in = joined;
+                            changed = true;
+                        }
+                    }
+                }
+            }
+        }
+
+        // float reads and writes of a mixed name move to a fresh temp
+        vector<int> float_name(k);
+        for (int& n : float_name) n = next_temp++;
+        for (size_t b = 0; b < cfg.blocks.size(); b++) {
+            now = entry[b];
+            for (int i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+                tac_quad& q = code.quads[i];
+                int bad = -1;
+                for_each_use(q, [&](tac_operand& o) {
+                    auto it = mixed.find(o.value);
+                    if (o.kind != OPND_TEMP || it == mixed.end()) return;
+                    data_type t = now[it->second];
+                    if (t == TYPE_ERROR) bad = o.value;
+                    if (t == TYPE_FLOAT) o.value = float_name[it->second];
+                });
+                if (bad >= 0) {
+                    error = "t" + to_string(bad) + " may hold an int or a float";
+                    return false;
+                }
+                step(q);
+                auto it = defines_temp(q) ? mixed.find(q.dst.value) : mixed.end();
+                if (it != mixed.end() && def_type(q) == TYPE_FLOAT) q.dst.value = float_name[it->second];
+            }
+        }
+    }
+    return true;
+}
+
+// The type each temp of one function holds, once split_mixed_temps has run. Temps that are read
+// but never written count as ints.
+inline unordered_map<int, data_type> temp_types(const tac_program& code, const tac_function_range& r) {
+    unordered_map<int, data_type> types;
+    for (int i = r.begin; i < r.end; i++) {
+        if (defines_temp(code.quads[i])) types[code.quads[i].dst.value] = def_type(code.quads[i]);
+    }
+    return types;
+}
+
+#endif // TAC_TYPING_H
@@ -0,0 +1,640 @@
+#ifndef TAC_VM_H
+#define TAC_VM_H
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "tac.h"
+#include "tac_typing.h"
+
+using namespace std;
+
+// Virtual machine that runs a tac_program. Loading pre-decodes the quads into a flat array of
+// vm_insn: labels become instruction indexes, operands become cells of the running function's
+// frame, and every operator is split by operand type so the dispatch loop never looks at a type.
+// Globals live outside the frames and are copied in and out by their own instructions.
+// run() executes the array with direct threading: each instruction holds the address of the
+// code that runs it, and every handler ends in a computed goto to the next one.
+
+union vm_cell {
+    int i;
+    double f;
+};
+
+struct vm_insn {
+    const void* op; // handler address, filled in once decoding is done
+    int d, a, b; // frame cells; jumps keep their target in d, calls the callee in a
+    int n; // array length for loads and stores, argument count for calls
+};
+
+struct vm_function {
+    int name; // interned
+    int entry; // index of the first instruction
+    int frame_size; // cells
+    data_type return_type; // TYPE_INT or TYPE_FLOAT
+    vector<int> param_cells; // cell each argument is copied to, -1 for an unnamed parameter
+    vector<data_type> param_types;
+    vector<vm_cell> frame; // a fresh frame: constants in place, everything else zero
+};
+
+class tac_vm {
+    public:
+        vector<vm_insn> code;
+        vector<vm_function> functions;
+        vector<vm_cell> globals;
+        vector<int> global_cell; // first cell of each tac_program global
+        uint64_t executed = 0; // instructions run by the last call to run()
+
+        // Decodes a copy of code_in and sets up a stack of stack_cells cells. Fails on programs the
+        // machine cannot run, like calls to functions without a body or a main that is missing.
+        bool load(const tac_program& code_in, string& error, size_t stack_cells = 1 << 20) {
+            code.clear();
+            functions.clear();
+            opcodes.clear();
+            label_insn.clear();
+            fixups.clear();
+            pending_params.clear();
+            max_params = 0;
+            program = code_in;
+            if (!split_mixed_temps(program, error)) return false;
+
+            global_cell.clear();
+            int cells = 0;
+            for (const tac_slot& g : program.globals) {
+                global_cell.push_back(cells);
+                cells += g.array_size > 0 ? g.array_size : 1;
+            }
+            globals.assign(cells, vm_cell{});
+
+            vector<tac_function_range> ranges = function_ranges(program);
+            unordered_map<int, int> function_of_name;
+            for (const tac_function_range& r : ranges) {
+                const tac_function& fn = program.functions[r.function];
+                function_of_name[fn.name] = functions.size();
+                vm_function vf;
+                vf.name = fn.name;
+                vf.entry = 0;
+                vf.frame_size = 0;
+                vf.return_type = value_type(fn.return_type);
+                for (auto& p : fn.params) vf.param_types.push_back(value_type(p.first));
+                functions.push_back(vf);
+            }
+            auto main_it = function_of_name.find(names.intern("main"));
+            if (main_it == function_of_name.end()) {
+                error = "no main function";
+                return false;
+            }
+
+            // instruction 0 calls main from a one-cell frame, instruction 1 stops the machine
+            emit(VM_CALL, 0, main_it->second, 0, 0);
+            emit(VM_HALT, 0, 0, 0, 0);
+
+            for (size_t k = 0; k < ranges.size(); k++) {
+                if (!decode_function(ranges[k], functions[k], function_of_name, error)) return false;
+            }
+            for (auto& [insn, label] : fixups) {
+                auto it = label_insn.find(label);
+                if (it == label_insn.end()) {
+                    error = "jump to undefined label L" + to_string(label);
+                    return false;
+                }
+                code[insn].d = it->second;
+            }
+
+            const void* const* table = nullptr;
+            execute(&table);
+            for (size_t i = 0; i < code.size(); i++) code[i].op = table[opcodes[i]];
+            // frames are filled from their templates on entry, so the stack needs no clearing
+            stack.reset(new vm_cell[stack_cells]);
+            stack_size = stack_cells;
+            args.assign(max_params + 1, vm_cell{});
+            return true;
+        }
+
+        // Calls main and returns what it returned, converted to int if main is a float function
+        bool run(int& result, string& error) {
+            links.clear();
+            links.reserve(1024);
+            executed = 0;
+            fault = nullptr;
+            execute(nullptr);
+            if (fault) {
+                error = fault;
+                return false;
+            }
+            const vm_function& main_fn = functions[code[0].a];
+            result = main_fn.return_type == TYPE_FLOAT ? (int)stack[0].f : stack[0].i;
+            return true;
+        }
+
+        // Text of global g after a run: the value, or every element of an array
+        string global_text(int g) const {
+            const tac_slot& slot = program.globals[g];
+            int count = slot.array_size > 0 ? slot.array_size : 1;
+            string out;
+            for (int k = 0; k < count; k++) {
+                if (k) out += ' ';
+                const vm_cell& c = globals[global_cell[g] + k];
+                out += slot.type == TYPE_FLOAT ? to_string(c.f) : to_string(c.i);
+            }
+            return out;
+        }
+
+    private:
+        enum vm_opcode : unsigned char {
+            VM_MOV,
+            VM_ADDI, VM_SUBI, VM_MULI, VM_DIVI, VM_MODI, VM_SHLI, VM_NEGI,
+            VM_ADDF, VM_SUBF, VM_MULF, VM_DIVF, VM_NEGF,
+            VM_LTI, VM_GTI, VM_LEI, VM_GEI, VM_EQI, VM_NEI,
+            VM_LTF, VM_GTF, VM_LEF, VM_GEF, VM_EQF, VM_NEF,
+            VM_AND, VM_OR, VM_NOT,
+            VM_ITOF, VM_FTOI,
+            VM_LOAD, VM_STORE, // local arrays: a and d are the first cell in the frame
+            VM_LOADG, VM_STOREG, // global arrays: a and d are the first global cell
+            VM_GGET, VM_GSET, // d = global a, global d = a
+            VM_JMP, VM_JT, VM_JF,
+            VM_PARAM, VM_PARAMITOF, VM_PARAMFTOI,
+            VM_CALL, VM_RET, VM_HALT,
+            VM_OPCODE_COUNT
+        };
+
+        struct vm_link {
+            const vm_insn* ret;
+            vm_cell* fp;
+            int function, dst;
+        };
+
+        // decoding state
+        tac_program program; // the loaded program, each temp holding one type
+        vector<unsigned char> opcodes; // parallel to code until the handlers are filled in
+        unordered_map<int, int> label_insn;
+        vector<pair<int, int>> fixups; // jump instruction, label
+        vector<pair<int, data_type>> pending_params; // PARAM instructions not yet matched to a call
+        size_t max_params = 0;
+
+        // the running machine
+        unique_ptr<vm_cell[]> stack;
+        size_t stack_size = 0;
+        vector<vm_cell> args;
+        vector<vm_link> links;
+        const char* fault = nullptr;
+
+        void emit(vm_opcode op, int d, int a, int b, int n) {
+            code.push_back({nullptr, d, a, b, n});
+            opcodes.push_back(op);
+        }
+
+        // Frame layout of the function being decoded
+        struct frame_builder {
+            const tac_function* fn;
+            vector<int> slot_cell;
+            unordered_map<int, int> temp_cell;
+            unordered_map<int, int> int_cell; // constant -> cell
+            unordered_map<int64_t, int> float_cell; // bits of the constant -> cell
+            vector<vm_cell> frame;
+            int scratch[4];
+
+            int fresh(vm_cell init = vm_cell{}) {
+                frame.push_back(init);
+                return frame.size() - 1;
+            }
+            int temp(int t) {
+                auto it = temp_cell.find(t);
+                if (it != temp_cell.end()) return it->second;
+                int c = fresh();
+                temp_cell.emplace(t, c);
+                return c;
+            }
+            int constant(vm_cell v, data_type type) {
+                if (type != TYPE_FLOAT) {
+                    auto [it, added] = int_cell.emplace(v.i, 0);
+                    if (added) it->second = fresh(v);
+                    return it->second;
+                }
+                int64_t bits;
+                memcpy(&bits, &v.f, sizeof(bits));
+                auto [it, added] = float_cell.emplace(bits, 0);
+                if (added) it->second = fresh(v);
+                return it->second;
+            }
+        };
+
+        frame_builder fb;
+        unordered_map<int, data_type> temp_type; // of the function being decoded
+
+        data_type operand_type(const tac_operand& o) const {
+            switch (o.kind) {
+                case OPND_FLOAT: return TYPE_FLOAT;
+                case OPND_VAR: return value_type(fb.fn->slots[o.value].type);
+                case OPND_GLOBAL: return value_type(program.globals[o.value].type);
+                case OPND_TEMP: {
+                    auto t = temp_type.find(o.value);
+                    return t == temp_type.end() ? TYPE_INT : t->second;
+                }
+                default: return TYPE_INT;
+            }
+        }
+
+        int zero(data_type type) {
+            vm_cell v;
+            if (type == TYPE_FLOAT) v.f = 0;
+            else v.i = 0;
+            return fb.constant(v, type);
+        }
+
+        // Cell holding o's value as a want, emitting conversions into scratch cell k if needed.
+        // want TYPE_NONE takes the operand as it is.
+        int read(const tac_operand& o, data_type want, int k) {
+            data_type have = operand_type(o);
+            if (want == TYPE_NONE) want = have;
+            if (o.kind == OPND_INT || o.kind == OPND_FLOAT) {
+                double value = o.kind == OPND_INT ? o.value : program.floats[o.value];
+                vm_cell v;
+                if (want == TYPE_FLOAT) v.f = value;
+                else v.i = o.kind == OPND_INT ? o.value : (int)(long long)value;
+                return fb.constant(v, want);
+            }
+            int cell;
+            if (o.kind == OPND_GLOBAL) {
+                cell = fb.scratch[k];
+                emit(VM_GGET, cell, global_cell[o.value], 0, 0);
+            } else if (o.kind == OPND_VAR) {
+                cell = fb.slot_cell[o.value];
+            } else {
+                cell = fb.temp(o.value);
+            }
+            if (have == want) return cell;
+            emit(want == TYPE_FLOAT ? VM_ITOF : VM_FTOI, fb.scratch[k], cell, 0, 0);
+            return fb.scratch[k];
+        }
+
+        // Cell holding o's truth value as an int
+        int read_truth(const tac_operand& o, int k) {
+            if (operand_type(o) == TYPE_INT) return read(o, TYPE_INT, k);
+            int cell = read(o, TYPE_FLOAT, k);
+            emit(VM_NEF, fb.scratch[k], cell, zero(TYPE_FLOAT), 0);
+            return fb.scratch[k];
+        }
+
+        // A def of o whose instruction produces a value of type produced
+        struct vm_target {
+            tac_operand o;
+            data_type produced, stored;
+            int cell; // where the instruction writes
+        };
+
+        vm_target target(const tac_operand& o, data_type produced, data_type temp_stores) {
+            vm_target t{o, produced, produced, fb.scratch[3]};
+            if (o.kind == OPND_TEMP) {
+                t.stored = temp_stores;
+                if (produced == temp_stores) t.cell = fb.temp(o.value);
+            } else if (o.kind == OPND_VAR) {
+                t.stored = value_type(fb.fn->slots[o.value].type);
+                if (produced == t.stored) t.cell = fb.slot_cell[o.value];
+            } else if (o.kind == OPND_GLOBAL) {
+                t.stored = value_type(program.globals[o.value].type);
+            }
+            return t;
+        }
+
+        // Moves a value written to scratch into its home, converting it on the way
+        void commit(const vm_target& t) {
+            if (t.o.kind == OPND_NONE) return;
+            if (t.o.kind == OPND_GLOBAL) {
+                if (t.produced != t.stored) emit(t.stored == TYPE_FLOAT ? VM_ITOF : VM_FTOI, t.cell, t.cell, 0, 0);
+                emit(VM_GSET, global_cell[t.o.value], t.cell, 0, 0);
+                return;
+            }
+            if (t.produced == t.stored) return;
+            int home = t.o.kind == OPND_TEMP ? fb.temp(t.o.value) : fb.slot_cell[t.o.value];
+            emit(t.stored == TYPE_FLOAT ? VM_ITOF : VM_FTOI, home, t.cell, 0, 0);
+        }
+
+        bool decode_function(const tac_function_range& r, vm_function& vf,
+                             const unordered_map<int, int>& function_of_name, string& error) {
+            const vector<tac_quad>& quads = program.quads;
+            const tac_function& fn = program.functions[r.function];
+            fb = frame_builder();
+            fb.fn = &fn;
+            for (const tac_slot& s : fn.slots) {
+                fb.slot_cell.push_back(fb.frame.size());
+                fb.frame.resize(fb.frame.size() + (s.array_size > 0 ? s.array_size : 1));
+            }
+            for (int& s : fb.scratch) s = fb.fresh();
+            int named = 0;
+            for (auto& p : fn.params) vf.param_cells.push_back(p.second ? fb.slot_cell[named++] : -1);
+            vf.entry = code.size();
+
+            temp_type = temp_types(program, r);
+            for (int i = r.begin; i < r.end; i++) {
+                if (!decode_quad(quads[i], vf, function_of_name, error)) {
+                    error = "function " + names.str(fn.name) + ": " + error;
+                    return false;
+                }
+            }
+            // falling off the end returns zero
+            emit(VM_RET, 0, zero(vf.return_type), 0, 0);
+            if (!pending_params.empty()) {
+                error = "function " + names.str(fn.name) + ": parameters passed to no call";
+                return false;
+            }
+            vf.frame = fb.frame;
+            vf.frame_size = fb.frame.size();
+            return true;
+        }
+
+        bool decode_quad(const tac_quad& q, const vm_function& vf,
+                         const unordered_map<int, int>& function_of_name, string& error) {
+            static const vm_opcode int_ops[] = {VM_MOV, VM_ADDI, VM_SUBI, VM_MULI, VM_DIVI, VM_MODI, VM_SHLI,
+                                                VM_LTI, VM_GTI, VM_LEI, VM_GEI, VM_EQI, VM_NEI};
+            static const vm_opcode float_ops[] = {VM_MOV, VM_ADDF, VM_SUBF, VM_MULF, VM_DIVF, VM_MODI, VM_SHLI,
+                                                  VM_LTF, VM_GTF, VM_LEF, VM_GEF, VM_EQF, VM_NEF};
+            data_type type = value_type(q.type);
+            switch (q.op) {
+                case TAC_COPY:
+                case TAC_ITOF:
+                case TAC_FTOI: {
+                    // a copy converts to its own type first, then to the destination's
+                    data_type from = q.op == TAC_COPY ? TYPE_NONE : q.op == TAC_ITOF ? TYPE_FLOAT : TYPE_INT;
+                    if (q.op == TAC_COPY && q.dst.kind == OPND_TEMP) from = type;
+                    int a = read(q.a, from, 0);
+                    vm_target t = target(q.dst, from == TYPE_NONE ? operand_type(q.a) : from, type);
+                    if (a == fb.scratch[0] && code.back().d == a) code.back().d = t.cell; // convert in place
+                    else if (t.cell != a) emit(VM_MOV, t.cell, a, 0, 0);
+                    commit(t);
+                    break;
+                }
+                case TAC_ADD: case TAC_SUB: case TAC_MUL: case TAC_DIV: case TAC_MOD: case TAC_SHL: {
+                    if (q.op == TAC_MOD || q.op == TAC_SHL) type = TYPE_INT;
+                    int a = read(q.a, type, 0), b = read(q.b, type, 1);
+                    vm_target t = target(q.dst, type, type);
+                    emit(type == TYPE_FLOAT ? float_ops[q.op] : int_ops[q.op], t.cell, a, b, 0);
+                    commit(t);
+                    break;
+                }
+                case TAC_LT: case TAC_GT: case TAC_LE: case TAC_GE: case TAC_EQ: case TAC_NE: {
+                    data_type cmp = operand_type(q.a) == TYPE_FLOAT || operand_type(q.b) == TYPE_FLOAT ? TYPE_FLOAT : TYPE_INT;
+                    int a = read(q.a, cmp, 0), b = read(q.b, cmp, 1);
+                    vm_target t = target(q.dst, TYPE_INT, type);
+                    emit(cmp == TYPE_FLOAT ? float_ops[q.op - TAC_LT + 7] : int_ops[q.op - TAC_LT + 7], t.cell, a, b, 0);
+                    commit(t);
+                    break;
+                }
+                case TAC_AND:
+                case TAC_OR: {
+                    int a = read_truth(q.a, 0), b = read_truth(q.b, 1);
+                    vm_target t = target(q.dst, TYPE_INT, type);
+                    emit(q.op == TAC_AND ? VM_AND : VM_OR, t.cell, a, b, 0);
+                    commit(t);
+                    break;
+                }
+                case TAC_NEG: {
+                    int a = read(q.a, type, 0);
+                    vm_target t = target(q.dst, type, type);
+                    emit(type == TYPE_FLOAT ? VM_NEGF : VM_NEGI, t.cell, a, 0, 0);
+                    commit(t);
+                    break;
+                }
+                case TAC_NOT: {
+                    int a = read_truth(q.a, 0);
+                    vm_target t = target(q.dst, TYPE_INT, type);
+                    emit(VM_NOT, t.cell, a, 0, 0);
+                    commit(t);
+                    break;
+                }
+                case TAC_LOAD: {
+                    const tac_slot* arr = array_of(q.a);
+                    if (!arr) { error = "load from something that is not an array"; return false; }
+                    int index = read(q.b, TYPE_INT, 1);
+                    vm_target t = target(q.dst, value_type(arr->type), type);
+                    if (q.a.kind == OPND_GLOBAL) emit(VM_LOADG, t.cell, global_cell[q.a.value], index, arr->array_size);
+                    else emit(VM_LOAD, t.cell, fb.slot_cell[q.a.value], index, arr->array_size);
+                    commit(t);
+                    break;
+                }
+                case TAC_STORE: {
+                    const tac_slot* arr = array_of(q.dst);
+                    if (!arr) { error = "store to something that is not an array"; return false; }
+                    int index = read(q.a, TYPE_INT, 0), value = read(q.b, value_type(arr->type), 1);
+                    if (q.dst.kind == OPND_GLOBAL) emit(VM_STOREG, global_cell[q.dst.value], index, value, arr->array_size);
+                    else emit(VM_STORE, fb.slot_cell[q.dst.value], index, value, arr->array_size);
+                    break;
+                }
+                case TAC_LABEL:
+                    label_insn[q.dst.value] = code.size();
+                    break;
+                case TAC_GOTO:
+                    fixups.push_back({(int)code.size(), q.dst.value});
+                    emit(VM_JMP, 0, 0, 0, 0);
+                    break;
+                case TAC_IF:
+                case TAC_IFFALSE: {
+                    int a = read_truth(q.a, 0);
+                    fixups.push_back({(int)code.size(), q.dst.value});
+                    emit(q.op == TAC_IF ? VM_JT : VM_JF, 0, a, 0, 0);
+                    break;
+                }
+                case TAC_PARAM: {
+                    int a = read(q.a, TYPE_NONE, 0);
+                    pending_params.push_back({(int)code.size(), operand_type(q.a)});
+                    max_params = max(max_params, pending_params.size());
+                    emit(VM_PARAM, 0, a, 0, 0);
+                    break;
+                }
+                case TAC_CALL: {
+                    auto it = function_of_name.find(q.a.value);
+                    if (it == function_of_name.end()) {
+                        error = "call to " + names.str(q.a.value) + ", which has no body";
+                        return false;
+                    }
+                    const vm_function& callee = functions[it->second];
+                    size_t n = q.b.value;
+                    if (n != callee.param_types.size() || n > pending_params.size()) {
+                        error = "call to " + names.str(q.a.value) + " with the wrong number of arguments";
+                        return false;
+                    }
+                    // arguments are converted as they are passed
+                    for (size_t k = 0; k < n; k++) {
+                        auto [insn, have] = pending_params[pending_params.size() - n + k];
+                        data_type want = callee.param_types[k];
+                        if (have != want) opcodes[insn] = want == TYPE_FLOAT ? VM_PARAMITOF : VM_PARAMFTOI;
+                    }
+                    pending_params.resize(pending_params.size() - n);
+                    vm_target t = target(q.dst, callee.return_type, type);
+                    emit(VM_CALL, t.cell, it->second, n, 0);
+                    commit(t);
+                    break;
+                }
+                case TAC_RETURN:
+                    emit(VM_RET, 0, q.a.is_none() ? zero(vf.return_type) : read(q.a, vf.return_type, 0), 0, 0);
+                    break;
+                case TAC_FUNC:
+                case TAC_DECL:
+                    break;
+            }
+            return true;
+        }
+
+        const tac_slot* array_of(const tac_operand& o) const {
+            const tac_slot* s = o.kind == OPND_VAR ? &fb.fn->slots[o.value]
+                              : o.kind == OPND_GLOBAL ? &program.globals[o.value] : nullptr;
+            return s && s->array_size > 0 ? s : nullptr;
+        }
+
+        // The dispatch loop. With a table pointer it only hands out the handler addresses.
+        void execute(const void* const** table) {
+            static const void* const handlers[VM_OPCODE_COUNT] = {
+                &&op_mov,
+                &&op_addi, &&op_subi, &&op_muli, &&op_divi, &&op_modi, &&op_shli, &&op_negi,
+                &&op_addf, &&op_subf, &&op_mulf, &&op_divf, &&op_negf,
+                &&op_lti, &&op_gti, &&op_lei, &&op_gei, &&op_eqi, &&op_nei,
+                &&op_ltf, &&op_gtf, &&op_lef, &&op_gef, &&op_eqf, &&op_nef,
+                &&op_and, &&op_or, &&op_not,
+                &&op_itof, &&op_ftoi,
+                &&op_load, &&op_store,
+                &&op_loadg, &&op_storeg,
+                &&op_gget, &&op_gset,
+                &&op_jmp, &&op_jt, &&op_jf,
+                &&op_param, &&op_paramitof, &&op_paramftoi,
+                &&op_call, &&op_ret, &&op_halt
+            };
+            if (table) {
+                *table = handlers;
+                return;
+            }
+
+            const vm_insn* const base = code.data();
+            const vm_insn* pc = base;
+            vm_cell* fp = stack.get();
+            vm_cell* const stack_end = stack.get() + stack_size;
+            vm_cell* g = globals.data();
+            vm_cell* ap = args.data();
+            int frame_size = 1, function = -1;
+            uint64_t count = 0;
+
+#define VM_NEXT() do { ++count; goto *pc->op; } while (0)
+#define VM_INT(x) fp[pc->x].i
+#define VM_FLT(x) fp[pc->x].f
+#define VM_BINARY_INT(label, expr) label: { int a = VM_INT(a), b = VM_INT(b); VM_INT(d) = (expr); pc++; VM_NEXT(); }
+#define VM_BINARY_FLT(label, expr) label: { double a = VM_FLT(a), b = VM_FLT(b); VM_FLT(d) = (expr); pc++; VM_NEXT(); }
+#define VM_COMPARE_FLT(label, expr) label: { double a = VM_FLT(a), b = VM_FLT(b); VM_INT(d) = (expr); pc++; VM_NEXT(); }
+
+            VM_NEXT();
+
+            op_mov: fp[pc->d] = fp[pc->a]; pc++; VM_NEXT();
+            // ints wrap around like the hardware does
+            VM_BINARY_INT(op_addi, (int)((unsigned)a + (unsigned)b))
+            VM_BINARY_INT(op_subi, (int)((unsigned)a - (unsigned)b))
+            VM_BINARY_INT(op_muli, (int)((unsigned)a * (unsigned)b))
+            op_divi: {
+                int a = VM_INT(a), b = VM_INT(b);
+                if (b == 0) { fault = "division by zero"; goto done; }
+                VM_INT(d) = b == -1 ? (int)(0u - (unsigned)a) : a / b;
+                pc++; VM_NEXT();
+            }
+            op_modi: {
+                int a = VM_INT(a), b = VM_INT(b);
+                if (b == 0) { fault = "division by zero"; goto done; }
+                VM_INT(d) = b == -1 ? 0 : a % b;
+                pc++; VM_NEXT();
+            }
+            VM_BINARY_INT(op_shli, (int)((unsigned)a << (b & 31)))
+            op_negi: VM_INT(d) = (int)(0u - (unsigned)VM_INT(a)); pc++; VM_NEXT();
+            VM_BINARY_FLT(op_addf, a + b)
+            VM_BINARY_FLT(op_subf, a - b)
+            VM_BINARY_FLT(op_mulf, a * b)
+            VM_BINARY_FLT(op_divf, a / b)
+            op_negf: VM_FLT(d) = -VM_FLT(a); pc++; VM_NEXT();
+            VM_BINARY_INT(op_lti, a < b)
+            VM_BINARY_INT(op_gti, a > b)
+            VM_BINARY_INT(op_lei, a <= b)
+            VM_BINARY_INT(op_gei, a >= b)
+            VM_BINARY_INT(op_eqi, a == b)
+            VM_BINARY_INT(op_nei, a != b)
+            VM_COMPARE_FLT(op_ltf, a < b)
+            VM_COMPARE_FLT(op_gtf, a > b)
+            VM_COMPARE_FLT(op_lef, a <= b)
+            VM_COMPARE_FLT(op_gef, a >= b)
+            VM_COMPARE_FLT(op_eqf, a == b)
+            VM_COMPARE_FLT(op_nef, a != b)
+            VM_BINARY_INT(op_and, a != 0 && b != 0)
+            VM_BINARY_INT(op_or, a != 0 || b != 0)
+            op_not: VM_INT(d) = VM_INT(a) == 0; pc++; VM_NEXT();
+            op_itof: VM_FLT(d) = VM_INT(a); pc++; VM_NEXT();
+            op_ftoi: VM_INT(d) = (int)(long long)VM_FLT(a); pc++; VM_NEXT();
+            op_load: {
+                unsigned index = VM_INT(b);
+                if (index >= (unsigned)pc->n) { fault = "array index out of range"; goto done; }
+                fp[pc->d] = fp[pc->a + index];
+                pc++; VM_NEXT();
+            }
+            op_store: {
+                unsigned index = VM_INT(a);
+                if (index >= (unsigned)pc->n) { fault = "array index out of range"; goto done; }
+                fp[pc->d + index] = fp[pc->b];
+                pc++; VM_NEXT();
+            }
+            op_loadg: {
+                unsigned index = VM_INT(b);
+                if (index >= (unsigned)pc->n) { fault = "array index out of range"; goto done; }
+                fp[pc->d] = g[pc->a + index];
+                pc++; VM_NEXT();
+            }
+            op_storeg: {
+                unsigned index = VM_INT(a);
+                if (index >= (unsigned)pc->n) { fault = "array index out of range"; goto done; }
+                g[pc->d + index] = fp[pc->b];
+                pc++; VM_NEXT();
+            }
+            op_gget: fp[pc->d] = g[pc->a]; pc++; VM_NEXT();
+            op_gset: g[pc->d] = fp[pc->a]; pc++; VM_NEXT();
+            op_jmp: pc = base + pc->d; VM_NEXT();
+            op_jt: pc = VM_INT(a) ? base + pc->d : pc + 1; VM_NEXT();
+            op_jf: pc = VM_INT(a) ? pc + 1 : base + pc->d; VM_NEXT();
+            op_param: *ap++ = fp[pc->a]; pc++; VM_NEXT();
+            op_paramitof: (ap++)->f = VM_INT(a); pc++; VM_NEXT();
+            op_paramftoi: (ap++)->i = (int)(long long)VM_FLT(a); pc++; VM_NEXT();
+            op_call: {
+                const vm_function& callee = functions[pc->a];
+                vm_cell* callee_fp = fp + frame_size;
+                if (callee_fp + callee.frame_size > stack_end) { fault = "stack overflow"; goto done; }
+                links.push_back({pc + 1, fp, function, pc->d});
+                memcpy(callee_fp, callee.frame.data(), callee.frame_size * sizeof(vm_cell));
+                ap -= pc->b;
+                for (int k = 0; k < pc->b; k++) {
+                    if (callee.param_cells[k] >= 0) callee_fp[callee.param_cells[k]] = ap[k];
+                }
+                fp = callee_fp;
+                function = pc->a;
+                frame_size = callee.frame_size;
+                pc = base + callee.entry;
+                VM_NEXT();
+            }
+            op_ret: {
+                vm_cell value = fp[pc->a];
+                const vm_link& link = links.back();
+                pc = link.ret;
+                fp = link.fp;
+                function = link.function;
+                frame_size = function < 0 ? 1 : functions[function].frame_size;
+                fp[link.dst] = value;
+                links.pop_back();
+                VM_NEXT();
+            }
+            op_halt:
+            done:
+            executed = count;
+
+#undef VM_NEXT
+#undef VM_INT
+#undef VM_FLT
+#undef VM_BINARY_INT
+#undef VM_BINARY_FLT
+#undef VM_COMPARE_FLT
+        }
+};
+
+#endif // TAC_VM_H
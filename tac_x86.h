@@ -0,0 +1,969 @@
+#ifndef TAC_X86_H
+#define TAC_X86_H
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "tac.h"
+#include "tac_cfg.h"
+#include "tac_opt.h"
+#include "tac_typing.h"
+
+using namespace std;
+
+// x86-64 System V assembly (GNU as, AT&T syntax) from a tac_program, ready for `gcc code.s`.
+// Ints are 32-bit and wrap; floats are doubles kept in SSE registers, the same values the TAC
+// virtual machine computes. Functions keep their source names and the standard calling
+// convention, so they link against C: an int is an int, a float is a double.
+//
+// Each function gets a linear-scan register allocator over the live intervals of its temps and
+// scalar locals. Values live across a call go to callee-saved registers, or to the stack when
+// none is left; no SSE register survives a call. Arrays, and values the allocator spills, get
+// rbp-relative stack slots. Locals and arrays start out zero, as in the virtual machine.
+
+struct x86_stats {
+    int functions = 0;
+    int values = 0; // temps and scalar locals given a home
+    int in_registers = 0;
+    int spilled = 0;
+};
+
+class x86_backend {
+    public:
+        x86_stats stats;
+
+        explicit x86_backend(const tac_program& code_in) : code(code_in) {}
+
+        bool generate(string& result, string& error) {
+            if (!split_mixed_temps(code, error)) return false;
+            out.clear();
+            out += "\t.text\n";
+            for (const tac_function& fn : code.functions) function_index[fn.name] = &fn;
+            for (const tac_function_range& r : function_ranges(code)) generate_function(r);
+            write_data();
+            out += "\t.section .note.GNU-stack,\"\",@progbits\n";
+            result.swap(out);
+            return true;
+        }
+
+    private:
+        enum {
+            RAX, RCX, RDX, RBX, RSI, RDI, RBP, RSP, R8, R9, R10, R11, R12, R13, R14, R15,
+            XMM0 = 16, XMM1 // XMM0 + n is %xmmn
+        };
+
+        // Where an operand's value is when an instruction reads it
+        struct x86_loc {
+            enum { REG, MEM, IMM, SYM } kind;
+            int value; // register, rbp offset or the constant
+            string sym; // rip-relative symbol
+        };
+
+        // A temp or scalar local of the function being generated
+        struct x86_value {
+            data_type type;
+            int start = -1, end = -1; // live interval in quad positions, see generate_function
+            int reg = -1;
+            int mem = 0; // rbp offset once the value is spilled
+        };
+
+        tac_program code; // with mixed temps split
+        string out;
+        unordered_map<int, const tac_function*> function_index; // by interned name
+        unordered_map<int64_t, int> float_label; // bits of a double constant -> .LC number
+        bool need_sign_mask = false;
+
+        // the function being generated
+        const tac_function* fn = nullptr;
+        int fn_number = 0;
+        tac_operand_numbering num;
+        vector<x86_value> values; // indexed by num.index
+        vector<int> array_mem; // rbp offset of each array slot
+        unordered_map<int, data_type> temp_type;
+        vector<tac_operand> params; // passed and not yet called
+        int local_label = 0;
+
+        static const char* reg_name(int r, int bits) {
+            static const char* r64[] = {"rax", "rcx", "rdx", "rbx", "rsi", "rdi", "rbp", "rsp",
+                                        "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15"};
+            static const char* r32[] = {"eax", "ecx", "edx", "ebx", "esi", "edi", "ebp", "esp",
+                                        "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d"};
+            static const char* r8[] = {"al", "cl", "dl", "bl", "sil", "dil", "bpl", "spl",
+                                       "r8b", "r9b", "r10b", "r11b", "r12b", "r13b", "r14b", "r15b"};
+            static const char* xmm[] = {"xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7",
+                                        "xmm8", "xmm9", "xmm10", "xmm11", "xmm12", "xmm13", "xmm14", "xmm15"};
+            if (r >= XMM0) return xmm[r - XMM0];
+            return bits == 64 ? r64[r] : bits == 32 ? r32[r] : r8[r];
+        }
+
+        // Appends one line of assembly, indented unless it is a label
+        void emit(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+            char buf[256];
+            va_list ap;
+            va_start(ap, fmt);
+            vsnprintf(buf, sizeof(buf), fmt, ap);
+            va_end(ap);
+            size_t len = strlen(buf);
+            if (len == 0 || buf[len - 1] != ':') out += '\t';
+            out += buf;
+            out += '\n';
+        }
+
+        string label(int n) const { return ".L" + to_string(fn_number) + "_" + to_string(n); }
+        string fresh_label() { return ".Lx" + to_string(fn_number) + "_" + to_string(local_label++); }
+
+        int float_constant(double v) {
+            int64_t bits;
+            memcpy(&bits, &v, sizeof(bits));
+            auto [it, added] = float_label.emplace(bits, float_label.size());
+            return it->second;
+        }
+
+        // ---- operands ----
+
+        data_type type_of(const tac_operand& o) const {
+            switch (o.kind) {
+                case OPND_FLOAT: return TYPE_FLOAT;
+                case OPND_VAR: return value_type(fn->slots[o.value].type);
+                case OPND_GLOBAL: return value_type(code.globals[o.value].type);
+                case OPND_TEMP: {
+                    auto it = temp_type.find(o.value);
+                    return it == temp_type.end() ? TYPE_INT : it->second;
+                }
+                default: return TYPE_INT;
+            }
+        }
+
+        x86_loc loc(const tac_operand& o) {
+            switch (o.kind) {
+                case OPND_INT: return {x86_loc::IMM, o.value, ""};
+                case OPND_FLOAT: return {x86_loc::SYM, 0, ".LC" + to_string(float_constant(code.floats[o.value]))};
+                case OPND_GLOBAL: return {x86_loc::SYM, 0, names.str(code.globals[o.value].name)};
+                default: {
+                    const x86_value& v = values[num.index(o)];
+                    if (v.reg >= 0) return {x86_loc::REG, v.reg, ""};
+                    return {x86_loc::MEM, v.mem, ""};
+                }
+            }
+        }
+
+        static string text(const x86_loc& l, int bits = 32) {
+            switch (l.kind) {
+                case x86_loc::REG: return string("%") + reg_name(l.value, bits);
+                case x86_loc::MEM: return to_string(l.value) + "(%rbp)";
+                case x86_loc::IMM: return "$" + to_string(l.value);
+                default: return l.sym + "(%rip)";
+            }
+        }
+
+        static bool is_reg(const x86_loc& l, int r) { return l.kind == x86_loc::REG && l.value == r; }
+
+        // Puts o's value, as an int, in GPR r
+        void load_int(const tac_operand& o, int r) {
+            x86_loc l = loc(o);
+            if (type_of(o) == TYPE_FLOAT) {
+                emit("cvttsd2siq %s, %%%s", text(l).c_str(), reg_name(r, 64));
+            } else if (l.kind == x86_loc::IMM && l.value == 0) {
+                emit("xorl %%%s, %%%s", reg_name(r, 32), reg_name(r, 32));
+            } else if (!is_reg(l, r)) {
+                emit("movl %s, %%%s", text(l).c_str(), reg_name(r, 32));
+            }
+        }
+
+        // Puts o's value, as a double, in SSE register x
+        void load_float(const tac_operand& o, int x) {
+            x86_loc l = loc(o);
+            if (type_of(o) == TYPE_FLOAT) {
+                if (is_reg(l, x)) return;
+                emit(l.kind == x86_loc::REG ? "movapd %s, %%%s" : "movsd %s, %%%s", text(l).c_str(), reg_name(x, 0));
+            } else if (l.kind == x86_loc::IMM) {
+                emit("movsd .LC%d(%%rip), %%%s", float_constant(l.value), reg_name(x, 0));
+            } else {
+                emit("pxor %%%s, %%%s", reg_name(x, 0), reg_name(x, 0));
+                emit("cvtsi2sdl %s, %%%s", text(l).c_str(), reg_name(x, 0));
+            }
+        }
+
+        // An int source operand for an ALU instruction; float values are converted into GPR scratch
+        string int_source(const tac_operand& o, int scratch) {
+            if (type_of(o) == TYPE_FLOAT) {
+                load_int(o, scratch);
+                return string("%") + reg_name(scratch, 32);
+            }
+            return text(loc(o));
+        }
+
+        // A double source operand for an SSE instruction; int values are converted into scratch
+        string float_source(const tac_operand& o, int scratch) {
+            x86_loc l = loc(o);
+            if (type_of(o) == TYPE_FLOAT) return text(l);
+            if (l.kind == x86_loc::IMM) return ".LC" + to_string(float_constant(l.value)) + "(%rip)";
+            load_float(o, scratch);
+            return string("%") + reg_name(scratch, 0);
+        }
+
+        // The register an instruction producing a value of type t for dst should compute into:
+        // dst's own register when it holds that type, otherwise a scratch one
+        int work_reg(const tac_operand& dst, data_type t) {
+            x86_loc l = loc(dst);
+            bool same = type_of(dst) == t && l.kind == x86_loc::REG && dst.kind != OPND_GLOBAL;
+            if (same) return l.value;
+            return t == TYPE_FLOAT ? XMM0 : RAX;
+        }
+
+        // Stores an int in GPR r to dst, converting if dst holds a float
+        void store_int(int r, const tac_operand& dst) {
+            x86_loc l = loc(dst);
+            if (type_of(dst) == TYPE_FLOAT) {
+                int x = l.kind == x86_loc::REG ? l.value : XMM0;
+                emit("pxor %%%s, %%%s", reg_name(x, 0), reg_name(x, 0));
+                emit("cvtsi2sdl %%%s, %%%s", reg_name(r, 32), reg_name(x, 0));
+                if (x == XMM0) emit("movsd %%xmm0, %s", text(l).c_str());
+            } else if (!is_reg(l, r)) {
+                emit("movl %%%s, %s", reg_name(r, 32), text(l).c_str());
+            }
+        }
+
+        // Stores a double in SSE register x to dst, converting if dst holds an int
+        void store_float(int x, const tac_operand& dst) {
+            x86_loc l = loc(dst);
+            if (type_of(dst) == TYPE_INT) {
+                if (l.kind == x86_loc::REG) emit("cvttsd2siq %%%s, %%%s", reg_name(x, 0), reg_name(l.value, 64));
+                else {
+                    emit("cvttsd2siq %%%s, %%rax", reg_name(x, 0));
+                    emit("movl %%eax, %s", text(l).c_str());
+                }
+            } else if (!is_reg(l, x)) {
+                emit(l.kind == x86_loc::REG ? "movapd %%%s, %s" : "movsd %%%s, %s", reg_name(x, 0), text(l).c_str());
+            }
+        }
+
+        void store(int r, const tac_operand& dst) {
+            if (r >= XMM0) store_float(r, dst);
+            else store_int(r, dst);
+        }
+
+        // dst = src converted to via, then to dst's own type
+        void move(const tac_operand& dst, const tac_operand& src, data_type via) {
+            x86_loc s = loc(src), d = loc(dst);
+            data_type to = type_of(dst);
+            bool direct = type_of(src) == via && via == to &&
+                          (s.kind == x86_loc::REG || d.kind == x86_loc::REG || (s.kind == x86_loc::IMM && to == TYPE_INT));
+            if (!direct) {
+                int r = work_reg(dst, via);
+                if (via == TYPE_FLOAT) load_float(src, r);
+                else load_int(src, r);
+                store(r, dst);
+            } else if (to == TYPE_FLOAT) {
+                if (s.kind == x86_loc::REG) store_float(s.value, dst);
+                else load_float(src, d.value);
+            } else {
+                if (s.kind == x86_loc::REG) store_int(s.value, dst);
+                else if (d.kind == x86_loc::REG) load_int(src, d.value);
+                else emit("movl %s, %s", text(s).c_str(), text(d).c_str());
+            }
+        }
+
+        // Leaves o's truth value, 0 or 1, in the low byte of GPR r; clobbers dl and xmm1
+        void truth(const tac_operand& o, int r) {
+            x86_loc l = loc(o);
+            if (type_of(o) == TYPE_FLOAT) {
+                emit("xorpd %%xmm1, %%xmm1");
+                emit("ucomisd %s, %%xmm1", text(l).c_str());
+                emit("setne %%%s", reg_name(r, 8));
+                emit("setp %%dl");
+                emit("orb %%dl, %%%s", reg_name(r, 8));
+            } else if (l.kind == x86_loc::IMM) {
+                emit("movl $%d, %%%s", l.value != 0, reg_name(r, 32));
+            } else {
+                emit("cmpl $0, %s", text(l).c_str());
+                emit("setne %%%s", reg_name(r, 8));
+            }
+        }
+
+        // ---- branches ----
+
+        // Jumps to target when o is true (when_true) or false
+        void branch_on(const tac_operand& o, bool when_true, const string& target) {
+            x86_loc l = loc(o);
+            if (l.kind == x86_loc::IMM) {
+                if ((l.value != 0) == when_true) emit("jmp %s", target.c_str());
+                return;
+            }
+            if (type_of(o) == TYPE_FLOAT) {
+                emit("xorpd %%xmm1, %%xmm1");
+                emit("ucomisd %s, %%xmm1", text(l).c_str());
+                float_jump(TAC_NE, when_true, target);
+                return;
+            }
+            if (l.kind == x86_loc::REG) emit("testl %s, %s", text(l).c_str(), text(l).c_str());
+            else emit("cmpl $0, %s", text(l).c_str());
+            emit("%s %s", when_true ? "jne" : "je", target.c_str());
+        }
+
+        // After ucomisd set up for relation op (see compare), jumps when the relation holds
+        // (when_true) or fails. Unordered operands make every relation but != false.
+        void float_jump(tac_opcode op, bool when_true, const string& target) {
+            if (op == TAC_EQ || op == TAC_NE) {
+                bool jump_if_equal = (op == TAC_EQ) == when_true;
+                if (jump_if_equal) {
+                    string skip = fresh_label();
+                    emit("jp %s", skip.c_str());
+                    emit("je %s", target.c_str());
+                    emit("%s:", skip.c_str());
+                } else {
+                    emit("jne %s", target.c_str());
+                    emit("jp %s", target.c_str());
+                }
+                return;
+            }
+            bool strict = op == TAC_LT || op == TAC_GT;
+            const char* jcc = when_true ? (strict ? "ja" : "jae") : (strict ? "jbe" : "jb");
+            emit("%s %s", jcc, target.c_str());
+        }
+
+        static const char* int_condition(tac_opcode op, bool holds) {
+            switch (op) {
+                case TAC_LT: return holds ? "l" : "ge";
+                case TAC_GT: return holds ? "g" : "le";
+                case TAC_LE: return holds ? "le" : "g";
+                case TAC_GE: return holds ? "ge" : "l";
+                case TAC_EQ: return holds ? "e" : "ne";
+                default: return holds ? "ne" : "e";
+            }
+        }
+
+        // Sets the flags for relational quad q and returns whether it compared doubles.
+        // Doubles are compared so that 'a' or 'ae' means the relation holds: a < b is b > a.
+        bool compare(const tac_quad& q) {
+            bool floats = type_of(q.a) == TYPE_FLOAT || type_of(q.b) == TYPE_FLOAT;
+            if (!floats) {
+                x86_loc a = loc(q.a);
+                if (a.kind == x86_loc::REG) emit("cmpl %s, %s", int_source(q.b, RCX).c_str(), text(a).c_str());
+                else {
+                    load_int(q.a, RAX);
+                    emit("cmpl %s, %%eax", int_source(q.b, RCX).c_str());
+                }
+                return false;
+            }
+            bool swap_sides = q.op == TAC_LT || q.op == TAC_LE;
+            const tac_operand& left = swap_sides ? q.b : q.a;
+            const tac_operand& right = swap_sides ? q.a : q.b;
+            x86_loc l = loc(left);
+            int x = l.kind == x86_loc::REG && type_of(left) == TYPE_FLOAT ? l.value : XMM0;
+            load_float(left, x);
+            emit("ucomisd %s, %%%s", float_source(right, XMM1).c_str(), reg_name(x, 0));
+            return true;
+        }
+
+        // ---- register allocation ----
+
+        // Computes live intervals over positions 2i (reads of quad i) and 2i + 1 (its write), then
+        // hands out registers by linear scan
+        void allocate(const tac_function_range& r) {
+            num.build(code, r);
+            int n = num.size();
+            values.assign(n, x86_value());
+            for (size_t s = 0; s < fn->slots.size(); s++) values[s].type = value_type(fn->slots[s].type);
+            for (int x = num.first_temp(); x < n; x++) values[x].type = TYPE_INT;
+            for (auto& [t, type] : temp_type) {
+                int x = num.index(temp_operand(t));
+                if (x >= 0) values[x].type = type;
+            }
+            auto allocatable = [&](int x) {
+                return x >= 0 && !num.is_global(x) && (x >= num.first_temp() || fn->slots[x].array_size == 0);
+            };
+            auto touch = [&](int x, int pos) {
+                if (!allocatable(x)) return;
+                x86_value& v = values[x];
+                if (v.start < 0 || pos < v.start) v.start = pos;
+                if (pos > v.end) v.end = pos;
+            };
+
+            tac_cfg cfg;
+            cfg.build(code.quads, r.begin, r.end);
+            vector<int> calls;
+            for (int i = r.begin; i < r.end; i++) {
+                if (code.quads[i].op == TAC_CALL) calls.push_back(i);
+            }
+            // a parameter is read by its call, which moves it into place
+            auto read_at = [&](int i) {
+                if (code.quads[i].op != TAC_PARAM) return i;
+                auto c = lower_bound(calls.begin(), calls.end(), i);
+                return c == calls.end() ? i : *c;
+            };
+
+            entry_live.clear();
+            // liveness is quadratic in the size of the function; past this budget everything
+            // stays on the stack
+            bool fits = (double)cfg.blocks.size() * n <= 2e8;
+            if (fits) {
+                vector<char> removed(code.quads.size(), 0);
+                vector<tac_bitset> live_out = live_out_sets(code.quads, removed, cfg, num);
+                for (size_t b = 0; b < cfg.blocks.size(); b++) {
+                    const tac_block& blk = cfg.blocks[b];
+                    tac_bitset live = live_out[b];
+                    live.for_each([&](int x) { touch(x, 2 * blk.end - 1); });
+                    for (int i = blk.end - 1; i >= blk.begin; i--) {
+                        tac_quad& q = code.quads[i];
+                        if (tac_operand* d = quad_def(q)) {
+                            int x = num.index(*d);
+                            if (x >= 0) {
+                                touch(x, 2 * i + 1);
+                                live.reset(x);
+                            }
+                        }
+                        for_each_use(q, [&](tac_operand& o) {
+                            int x = num.index(o);
+                            if (x >= 0) {
+                                touch(x, 2 * read_at(i));
+                                live.set(x);
+                            }
+                        });
+                    }
+                    live.for_each([&](int x) { touch(x, 2 * blk.begin); });
+                    if (b == 0) live.for_each([&](int x) { if (allocatable(x)) entry_live.push_back(x); });
+                }
+            } else {
+                for (int i = r.begin; i < r.end; i++) {
+                    for (tac_operand* o : {&code.quads[i].dst, &code.quads[i].a, &code.quads[i].b}) touch(num.index(*o), 2 * i);
+                }
+                for (int x = 0; x < n; x++) {
+                    if (values[x].start >= 0) entry_live.push_back(x);
+                }
+            }
+            // parameters arrive at the entry even when nothing reads them first
+            for (size_t s = 0; s < fn->slots.size() && s < (size_t)named_params(); s++) {
+                if (values[s].start >= 0) values[s].start = 2 * r.begin;
+            }
+
+            vector<int> order;
+            for (int x = 0; x < n; x++) {
+                if (values[x].start >= 0) order.push_back(x);
+            }
+            sort(order.begin(), order.end(), [&](int a, int b) { return values[a].start < values[b].start; });
+
+            auto crosses_call = [&](const x86_value& v) {
+                auto c = upper_bound(calls.begin(), calls.end(), v.start / 2);
+                return c != calls.end() && 2 * *c + 1 <= v.end && v.start < 2 * *c;
+            };
+            auto touches_call = [&](const x86_value& v) {
+                auto c = lower_bound(calls.begin(), calls.end(), v.start / 2);
+                return c != calls.end() && 2 * *c <= v.end;
+            };
+
+            // preference order: caller-saved first so short-lived values need no save
+            static const vector<int> int_free = {RSI, RDI, R8, R9, R10, R11, RBX, R12, R13, R14, R15};
+            static const vector<int> int_near_call = {R10, R11, RBX, R12, R13, R14, R15};
+            static const vector<int> int_across_call = {RBX, R12, R13, R14, R15};
+            static const vector<int> float_free = {XMM0 + 2, XMM0 + 3, XMM0 + 4, XMM0 + 5, XMM0 + 6, XMM0 + 7, XMM0 + 8,
+                                                   XMM0 + 9, XMM0 + 10, XMM0 + 11, XMM0 + 12, XMM0 + 13, XMM0 + 14, XMM0 + 15};
+            static const vector<int> float_near_call = {XMM0 + 8, XMM0 + 9, XMM0 + 10, XMM0 + 11,
+                                                        XMM0 + 12, XMM0 + 13, XMM0 + 14, XMM0 + 15};
+            static const vector<int> none;
+
+            vector<int> owner(32, -1);
+            vector<int> active;
+            vector<int> spilled;
+            for (int x : order) {
+                x86_value& v = values[x];
+                for (size_t k = 0; k < active.size();) {
+                    if (values[active[k]].end < v.start) {
+                        owner[values[active[k]].reg] = -1;
+                        active[k] = active.back();
+                        active.pop_back();
+                    } else {
+                        k++;
+                    }
+                }
+                // arguments sit in the argument registers until the prologue moves them
+                bool at_entry = v.start <= 2 * r.begin;
+                const vector<int>& pool = !fits ? none
+                    : v.type == TYPE_FLOAT ? (crosses_call(v) ? none : touches_call(v) || at_entry ? float_near_call : float_free)
+                    : crosses_call(v) ? int_across_call : touches_call(v) || at_entry ? int_near_call : int_free;
+                for (int reg : pool) {
+                    if (owner[reg] < 0) {
+                        v.reg = reg;
+                        break;
+                    }
+                }
+                if (v.reg < 0 && !pool.empty()) {
+                    // take the register of the value that lives longest, if it outlives this one
+                    int victim = -1;
+                    for (int y : active) {
+                        if (find(pool.begin(), pool.end(), values[y].reg) == pool.end()) continue;
+                        if (victim < 0 || values[y].end > values[victim].end) victim = y;
+                    }
+                    if (victim >= 0 && values[victim].end > v.end) {
+                        v.reg = values[victim].reg;
+                        values[victim].reg = -1;
+                        spilled.push_back(victim);
+                        active.erase(find(active.begin(), active.end(), victim));
+                    }
+                }
+                if (v.reg >= 0) {
+                    owner[v.reg] = x;
+                    active.push_back(x);
+                } else {
+                    spilled.push_back(x);
+                }
+            }
+            stats.values += order.size();
+            stats.spilled += spilled.size();
+            stats.in_registers += order.size() - spilled.size();
+        }
+        vector<int> entry_live; // values that may be read before they are written
+
+        int named_params() const {
+            int k = 0;
+            for (auto& p : fn->params) k += p.second != 0;
+            return k;
+        }
+
+        // ---- functions ----
+
+        void generate_function(const tac_function_range& r) {
+            fn = &code.functions[r.function];
+            fn_number = r.function;
+            local_label = 0;
+            params.clear();
+            temp_type = temp_types(code, r);
+            allocate(r);
+            stats.functions++;
+
+            vector<int> saved;
+            for (int reg : {RBX, R12, R13, R14, R15}) {
+                for (const x86_value& v : values) {
+                    if (v.reg == reg) {
+                        saved.push_back(reg);
+                        break;
+                    }
+                }
+            }
+            // frame: saved registers right below rbp, then the arrays, then spill slots
+            int frame = 8 * saved.size();
+            array_mem.assign(fn->slots.size(), 0);
+            int arrays_begin = frame;
+            for (size_t s = 0; s < fn->slots.size(); s++) {
+                const tac_slot& slot = fn->slots[s];
+                if (slot.array_size == 0) continue;
+                frame += ((slot.type == TYPE_FLOAT ? 8 : 4) * slot.array_size + 7) / 8 * 8;
+                array_mem[s] = -frame;
+            }
+            int arrays_end = frame;
+            for (x86_value& v : values) {
+                if (v.start >= 0 && v.reg < 0) {
+                    frame += 8;
+                    v.mem = -frame;
+                }
+            }
+            int locals = (frame + 15) / 16 * 16 - 8 * saved.size();
+
+            const string& name = names.str(fn->name);
+            out += "\n";
+            emit(".globl %s", name.c_str());
+            emit(".type %s, @function", name.c_str());
+            emit("%s:", name.c_str());
+            emit("pushq %%rbp");
+            emit("movq %%rsp, %%rbp");
+            for (int reg : saved) emit("pushq %%%s", reg_name(reg, 64));
+            if (locals > 0) emit("subq $%d, %%rsp", locals);
+
+            // arguments to their homes, then zero what may be read before it is written
+            static const int int_args[] = {RDI, RSI, RDX, RCX, R8, R9};
+            int next_int = 0, next_float = 0, stack_arg = 16, slot = 0;
+            vector<char> is_param(values.size(), 0);
+            for (auto& p : fn->params) {
+                bool is_float = value_type(p.first) == TYPE_FLOAT;
+                x86_loc from;
+                if (is_float && next_float < 8) from = {x86_loc::REG, XMM0 + next_float++, ""};
+                else if (!is_float && next_int < 6) from = {x86_loc::REG, int_args[next_int++], ""};
+                else {
+                    from = {x86_loc::MEM, stack_arg, ""};
+                    stack_arg += 8;
+                }
+                if (p.second == 0) continue;
+                is_param[slot] = 1;
+                const x86_value& v = values[slot++];
+                if (v.start < 0) continue;
+                x86_loc to = v.reg >= 0 ? x86_loc{x86_loc::REG, v.reg, ""} : x86_loc{x86_loc::MEM, v.mem, ""};
+                if (is_float) {
+                    if (from.kind == x86_loc::MEM && to.kind == x86_loc::MEM) {
+                        emit("movsd %s, %%xmm0", text(from).c_str());
+                        from = {x86_loc::REG, XMM0, ""};
+                    }
+                    emit(from.kind == x86_loc::REG && to.kind == x86_loc::REG ? "movapd %s, %s" : "movsd %s, %s",
+                         text(from).c_str(), text(to).c_str());
+                } else {
+                    if (from.kind == x86_loc::MEM && to.kind == x86_loc::MEM) {
+                        emit("movl %s, %%eax", text(from).c_str());
+                        from = {x86_loc::REG, RAX, ""};
+                    }
+                    emit("movl %s, %s", text(from).c_str(), text(to).c_str());
+                }
+            }
+            for (int x : entry_live) {
+                if (x < (int)is_param.size() && is_param[x]) continue;
+                const x86_value& v = values[x];
+                if (v.reg >= XMM0) emit("xorpd %%%s, %%%s", reg_name(v.reg, 0), reg_name(v.reg, 0));
+                else if (v.reg >= 0) emit("xorl %%%s, %%%s", reg_name(v.reg, 32), reg_name(v.reg, 32));
+                else emit("movq $0, %d(%%rbp)", v.mem);
+            }
+            if (arrays_end > arrays_begin) {
+                emit("leaq %d(%%rbp), %%rdi", -arrays_end);
+                emit("movl $%d, %%ecx", (arrays_end - arrays_begin) / 8);
+                emit("xorl %%eax, %%eax");
+                emit("rep stosq");
+            }
+
+            int last = r.end - 1;
+            while (last >= r.begin && (code.quads[last].op == TAC_DECL || code.quads[last].op == TAC_LABEL)) last--;
+            for (int i = r.begin; i < r.end; i++) i += generate_quad(i, r.end);
+            if (last < r.begin || code.quads[last].op != TAC_RETURN) {
+                // falling off the end returns zero
+                emit(value_type(fn->return_type) == TYPE_FLOAT ? "xorpd %%xmm0, %%xmm0" : "xorl %%eax, %%eax");
+            }
+
+            emit(".Lret%d:", fn_number);
+            if (saved.empty()) emit("leave");
+            else {
+                emit("leaq %d(%%rbp), %%rsp", -8 * (int)saved.size());
+                for (size_t k = saved.size(); k-- > 0;) emit("popq %%%s", reg_name(saved[k], 64));
+                emit("popq %%rbp");
+            }
+            emit("ret");
+            emit(".size %s, .-%s", name.c_str(), name.c_str());
+        }
+
+        // Address of element index of the array operand arr; the index goes in rax and global
+        // arrays put their base in rdx
+        string element(const tac_operand& arr, const tac_operand& index, int size) {
+            x86_loc i = loc(index);
+            bool constant = i.kind == x86_loc::IMM;
+            if (!constant) {
+                load_int(index, RAX);
+                emit("cltq");
+            }
+            if (arr.kind == OPND_GLOBAL) {
+                string sym = names.str(code.globals[arr.value].name);
+                if (constant) return sym + "+" + to_string((long long)i.value * size) + "(%rip)";
+                emit("leaq %s(%%rip), %%rdx", sym.c_str());
+                return "(%rdx,%rax," + to_string(size) + ")";
+            }
+            int base = array_mem[arr.value];
+            if (constant) return to_string(base + (long long)i.value * size) + "(%rbp)";
+            return to_string(base) + "(%rbp,%rax," + to_string(size) + ")";
+        }
+
+        const tac_slot& array_slot(const tac_operand& o) const {
+            return o.kind == OPND_GLOBAL ? code.globals[o.value] : fn->slots[o.value];
+        }
+
+        // Whether temp operand t dies at quad i, which reads it
+        bool dies_at(const tac_operand& t, int i) const {
+            int x = num.index(t);
+            return t.kind == OPND_TEMP && x >= 0 && values[x].end <= 2 * i;
+        }
+
+        // Emits quad i; returns how many quads after it were folded in
+        int generate_quad(int i, int end) {
+            const tac_quad& q = code.quads[i];
+            switch (q.op) {
+                case TAC_COPY:
+                    move(q.dst, q.a, type_of(q.dst));
+                    break;
+                case TAC_ITOF:
+                    move(q.dst, q.a, TYPE_FLOAT);
+                    break;
+                case TAC_FTOI:
+                    move(q.dst, q.a, TYPE_INT);
+                    break;
+                case TAC_ADD: case TAC_SUB: case TAC_MUL: case TAC_DIV: case TAC_MOD: case TAC_SHL: {
+                    data_type t = q.op == TAC_MOD || q.op == TAC_SHL ? TYPE_INT : def_type(q);
+                    if (t == TYPE_FLOAT) float_arith(q);
+                    else if (q.op == TAC_DIV || q.op == TAC_MOD) int_divide(q);
+                    else int_arith(q);
+                    break;
+                }
+                case TAC_LT: case TAC_GT: case TAC_LE: case TAC_GE: case TAC_EQ: case TAC_NE: {
+                    // a compare feeding the branch right after it becomes a conditional jump
+                    if (i + 1 < end) {
+                        const tac_quad& next = code.quads[i + 1];
+                        if ((next.op == TAC_IF || next.op == TAC_IFFALSE) && next.a == q.dst && dies_at(q.dst, i + 1)) {
+                            bool when_true = next.op == TAC_IF;
+                            string target = label(next.dst.value);
+                            if (compare(q)) float_jump(q.op, when_true, target);
+                            else emit("j%s %s", int_condition(q.op, when_true), target.c_str());
+                            return 1;
+                        }
+                    }
+                    if (compare(q)) {
+                        if (q.op == TAC_EQ || q.op == TAC_NE) {
+                            emit(q.op == TAC_EQ ? "sete %%al" : "setne %%al");
+                            emit(q.op == TAC_EQ ? "setnp %%dl" : "setp %%dl");
+                            emit(q.op == TAC_EQ ? "andb %%dl, %%al" : "orb %%dl, %%al");
+                        } else {
+                            emit(q.op == TAC_LT || q.op == TAC_GT ? "seta %%al" : "setae %%al");
+                        }
+                    } else {
+                        emit("set%s %%al", int_condition(q.op, true));
+                    }
+                    emit("movzbl %%al, %%eax");
+                    store_int(RAX, q.dst);
+                    break;
+                }
+                case TAC_AND:
+                case TAC_OR:
+                    truth(q.a, RAX);
+                    truth(q.b, RCX);
+                    emit(q.op == TAC_AND ? "andb %%cl, %%al" : "orb %%cl, %%al");
+                    emit("movzbl %%al, %%eax");
+                    store_int(RAX, q.dst);
+                    break;
+                case TAC_NOT:
+                    truth(q.a, RAX);
+                    emit("xorb $1, %%al");
+                    emit("movzbl %%al, %%eax");
+                    store_int(RAX, q.dst);
+                    break;
+                case TAC_NEG:
+                    if (def_type(q) == TYPE_FLOAT) {
+                        int x = work_reg(q.dst, TYPE_FLOAT);
+                        load_float(q.a, x);
+                        emit("xorpd .LCsign(%%rip), %%%s", reg_name(x, 0));
+                        need_sign_mask = true;
+                        store_float(x, q.dst);
+                    } else {
+                        int g = work_reg(q.dst, TYPE_INT);
+                        load_int(q.a, g);
+                        emit("negl %%%s", reg_name(g, 32));
+                        store_int(g, q.dst);
+                    }
+                    break;
+                case TAC_LOAD: {
+                    const tac_slot& arr = array_slot(q.a);
+                    bool is_float = arr.type == TYPE_FLOAT;
+                    string at = element(q.a, q.b, is_float ? 8 : 4);
+                    int r = work_reg(q.dst, is_float ? TYPE_FLOAT : TYPE_INT);
+                    emit(is_float ? "movsd %s, %%%s" : "movl %s, %%%s", at.c_str(), reg_name(r, 32));
+                    store(r, q.dst);
+                    break;
+                }
+                case TAC_STORE: {
+                    const tac_slot& arr = array_slot(q.dst);
+                    bool is_float = arr.type == TYPE_FLOAT;
+                    x86_loc v = loc(q.b);
+                    string value;
+                    if (is_float) {
+                        // the value is ready before the address takes rax and rdx
+                        if (v.kind == x86_loc::REG && type_of(q.b) == TYPE_FLOAT) value = text(v);
+                        else {
+                            load_float(q.b, XMM0);
+                            value = "%xmm0";
+                        }
+                    } else if (v.kind == x86_loc::IMM || (v.kind == x86_loc::REG && type_of(q.b) == TYPE_INT)) {
+                        value = text(v);
+                    } else {
+                        load_int(q.b, RCX);
+                        value = "%ecx";
+                    }
+                    string at = element(q.dst, q.a, is_float ? 8 : 4);
+                    emit(is_float ? "movsd %s, %s" : "movl %s, %s", value.c_str(), at.c_str());
+                    break;
+                }
+                case TAC_LABEL:
+                    emit("%s:", label(q.dst.value).c_str());
+                    break;
+                case TAC_GOTO:
+                    emit("jmp %s", label(q.dst.value).c_str());
+                    break;
+                case TAC_IF:
+                case TAC_IFFALSE:
+                    branch_on(q.a, q.op == TAC_IF, label(q.dst.value));
+                    break;
+                case TAC_PARAM:
+                    params.push_back(q.a);
+                    break;
+                case TAC_CALL:
+                    call(q);
+                    break;
+                case TAC_RETURN: {
+                    data_type t = value_type(fn->return_type);
+                    if (q.a.is_none()) emit(t == TYPE_FLOAT ? "xorpd %%xmm0, %%xmm0" : "xorl %%eax, %%eax");
+                    else if (t == TYPE_FLOAT) load_float(q.a, XMM0);
+                    else load_int(q.a, RAX);
+                    if (i + 1 < end) emit("jmp .Lret%d", fn_number);
+                    break;
+                }
+                case TAC_FUNC:
+                case TAC_DECL:
+                    break;
+            }
+            return 0;
+        }
+
+        void int_arith(const tac_quad& q) {
+            static const char* mnemonic[] = {"", "addl", "subl", "imull", "", "", "sall"};
+            bool commutes = q.op == TAC_ADD || q.op == TAC_MUL;
+            tac_operand a = q.a, b = q.b;
+            int r = work_reg(q.dst, TYPE_INT);
+            x86_loc lb = loc(b);
+            if (is_reg(lb, r) && !is_reg(loc(a), r)) {
+                if (commutes) swap(a, b);
+                else r = RAX;
+            }
+            if (q.op == TAC_SHL && loc(b).kind != x86_loc::IMM) {
+                load_int(b, RCX);
+                load_int(a, r);
+                emit("sall %%cl, %%%s", reg_name(r, 32));
+            } else {
+                string src = int_source(b, RCX);
+                load_int(a, r);
+                emit("%s %s, %%%s", mnemonic[q.op], src.c_str(), reg_name(r, 32));
+            }
+            store_int(r, q.dst);
+        }
+
+        void int_divide(const tac_quad& q) {
+            x86_loc d = loc(q.b);
+            load_int(q.a, RAX);
+            if (d.kind == x86_loc::IMM && d.value == -1) {
+                // INT_MIN / -1 wraps to INT_MIN instead of trapping
+                if (q.op == TAC_DIV) emit("negl %%eax");
+                else emit("xorl %%eax, %%eax");
+                store_int(RAX, q.dst);
+                return;
+            }
+            string divisor;
+            if (d.kind == x86_loc::IMM || type_of(q.b) == TYPE_FLOAT) {
+                load_int(q.b, RCX);
+                divisor = "%ecx";
+            } else {
+                divisor = text(d);
+            }
+            string done;
+            if (d.kind != x86_loc::IMM) {
+                string divide = fresh_label();
+                done = fresh_label();
+                emit("cmpl $-1, %s", divisor.c_str());
+                emit("jne %s", divide.c_str());
+                if (q.op == TAC_DIV) emit("negl %%eax");
+                else emit("xorl %%eax, %%eax");
+                emit("jmp %s", done.c_str());
+                emit("%s:", divide.c_str());
+            }
+            emit("cltd");
+            emit("idivl %s", divisor.c_str());
+            if (q.op == TAC_MOD) emit("movl %%edx, %%eax");
+            if (!done.empty()) emit("%s:", done.c_str());
+            store_int(RAX, q.dst);
+        }
+
+        void float_arith(const tac_quad& q) {
+            static const char* mnemonic[] = {"", "addsd", "subsd", "mulsd", "divsd"};
+            bool commutes = q.op == TAC_ADD || q.op == TAC_MUL;
+            tac_operand a = q.a, b = q.b;
+            int x = work_reg(q.dst, TYPE_FLOAT);
+            if (is_reg(loc(b), x) && !is_reg(loc(a), x)) {
+                if (commutes) swap(a, b);
+                else x = XMM0;
+            }
+            string src = float_source(b, XMM1);
+            load_float(a, x);
+            emit("%s %s, %%%s", mnemonic[q.op], src.c_str(), reg_name(x, 0));
+            store_float(x, q.dst);
+        }
+
+        void call(const tac_quad& q) {
+            int n = q.b.value;
+            vector<tac_operand> args(params.end() - n, params.end());
+            params.resize(params.size() - n);
+            auto callee = function_index.find(q.a.value);
+            vector<data_type> want;
+            data_type returns = def_type(q);
+            for (int k = 0; k < n; k++) want.push_back(type_of(args[k]));
+            if (callee != function_index.end()) {
+                const tac_function& f = *callee->second;
+                for (int k = 0; k < n && k < (int)f.params.size(); k++) want[k] = value_type(f.params[k].first);
+                returns = value_type(f.return_type);
+            }
+
+            // arguments past six ints or eight floats go on the stack, last one pushed first
+            static const int int_args[] = {RDI, RSI, RDX, RCX, R8, R9};
+            vector<int> reg_of(n, -1);
+            vector<int> on_stack;
+            int ints = 0, floats = 0;
+            for (int k = 0; k < n; k++) {
+                if (want[k] == TYPE_FLOAT && floats < 8) reg_of[k] = XMM0 + floats++;
+                else if (want[k] == TYPE_INT && ints < 6) reg_of[k] = int_args[ints++];
+                else on_stack.push_back(k);
+            }
+            int pad = on_stack.size() % 2 ? 8 : 0;
+            if (pad) emit("subq $8, %%rsp");
+            for (size_t k = on_stack.size(); k-- > 0;) {
+                const tac_operand& arg = args[on_stack[k]];
+                if (want[on_stack[k]] == TYPE_FLOAT) {
+                    load_float(arg, XMM0);
+                    emit("movq %%xmm0, %%rax");
+                } else {
+                    load_int(arg, RAX);
+                }
+                emit("pushq %%rax");
+            }
+            // no argument lives in an argument register, so these moves cannot clobber each other
+            for (int k = 0; k < n; k++) {
+                if (reg_of[k] < 0) continue;
+                if (want[k] == TYPE_FLOAT) load_float(args[k], reg_of[k]);
+                else load_int(args[k], reg_of[k]);
+            }
+            emit("movl $%d, %%eax", floats); // vector registers used, for variadic callees
+            emit("call %s", names.str(q.a.value).c_str());
+            int pushed = 8 * on_stack.size() + pad;
+            if (pushed) emit("addq $%d, %%rsp", pushed);
+            if (q.dst.is_none()) return;
+            if (returns == TYPE_FLOAT) store_float(XMM0, q.dst);
+            else store_int(RAX, q.dst);
+        }
+
+        // ---- data ----
+
+        void write_data() {
+            if (!code.globals.empty()) out += "\n\t.bss\n";
+            for (const tac_slot& g : code.globals) {
+                const string& name = names.str(g.name);
+                int count = g.array_size > 0 ? g.array_size : 1;
+                int bytes = (g.type == TYPE_FLOAT ? 8 : 4) * count;
+                out += "# " + string(type_name(g.type)) + " " + name;
+                if (g.array_size > 0) out += "[" + to_string(g.array_size) + "]";
+                out += "\n";
+                emit(".globl %s", name.c_str());
+                emit(".align 8");
+                emit(".type %s, @object", name.c_str());
+                emit(".size %s, %d", name.c_str(), bytes);
+                emit("%s:", name.c_str());
+                emit(".zero %d", bytes);
+            }
+            if (float_label.empty() && !need_sign_mask) return;
+            out += "\n\t.section .rodata\n";
+            if (need_sign_mask) {
+                emit(".align 16");
+                emit(".LCsign:");
+                emit(".quad 0x8000000000000000, 0");
+            }
+            vector<pair<int, int64_t>> constants;
+            for (auto& [bits, n] : float_label) constants.push_back({n, bits});
+            sort(constants.begin(), constants.end());
+            emit(".align 8");
+            for (auto& [n, bits] : constants) {
+                emit(".LC%d:", n);
+                emit(".quad %lld", (long long)bits);
+            }
+        }
+};
+
+#endif // TAC_X86_H
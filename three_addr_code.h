@@ -2,9 +2,16 @@
 #define THREE_ADDR_CODE_H
 
 #include "ast.h"
+#include "tac_binary.h"
+#include "tac_c.h"
+#include "tac_cache.h"
+#include "tac_opt.h"
+#include "tac_x86.h"
+#include "work_pool.h"
+#include <chrono>
 #include <fstream>
 #include <string>
-#include <map>
+#include <vector>
 
 using namespace std;
 
@@ -12,45 +19,175 @@ class ThreeAddrCodeGenerator {
 private:
     ProgramNode* ast_root;
     ofstream& outcode;
-    map<string, string> symbol_to_temp;
-    int temp_count;
-    int label_count;
+    tac_program code;
+    int opt_level;
+    int jobs; // threads generating and optimizing functions
+    tac_cache* cache = nullptr; // finished code of unchanged functions, if any
+    tac_opt_stats stats;
+    x86_stats asm_stats;
+    double build_ms = 0; // wall time of code generation and optimization
+    bool built;
+    bool streaming = false; // units come one at a time through stream_unit()
+    bool keep_code = false; // while streaming, keep the quads for the outputs written at the end
+    int label_base = 0; // labels used by the units appended so far
 
-public:
-    ThreeAddrCodeGenerator(ProgramNode* root, ofstream& out)
-        : ast_root(root), outcode(out), temp_count(0), label_count(0) {}
+    // Key of the unit's entry in the cache, empty when it has none
+    const string& cache_key(const ASTNode* unit) const {
+        static const string none;
+        const FuncDeclNode* func = cache ? dynamic_cast<const FuncDeclNode*>(unit) : nullptr;
+        return func ? func->get_cache_key() : none;
+    }
 
-    void generate() {
-        // TODO: Implement this method
-        // This method should:
-        // 1. Write a header to the output file
+    // Generates and optimizes one unit as a program of its own, with temps and labels numbered from 0
+    void generate_unit(const ASTNode* unit, tac_program& part, tac_opt_stats& part_stats) const {
+        vector<tac_operand> slot_map; // per-function, reset by each FuncDeclNode
+        int temp_count = 0, label_count = 0;
+        part.globals = code.globals;
+        unit->generate_code(part, slot_map, temp_count, label_count);
+        tac_optimizer(part).run(opt_level, part_stats);
+    }
 
-        outcode << "//========== THREE ADDRESS CODE ==========" << endl;
+    void append_unit(const tac_program& part, const tac_opt_stats& part_stats) {
+        int function_base = code.functions.size(), unit_label_base = label_base;
+        code.append(part, label_base);
+        stats.add(part_stats, function_base, unit_label_base);
+    }
 
-        outcode << ""<< endl;
+    // Every unit of the program is generated on its own on a work-stealing pool. The units are
+    // then appended in source order, so the result does not depend on how many threads did the
+    // work. With a cache, the functions found in it are loaded instead, and the others stored
+    // once done; both happen on this thread, since loading and storing go through its interner.
+    void build() {
+        if (built) return;
+        auto start = chrono::steady_clock::now();
+        code.globals = ast_root ? ast_root->get_globals() : vector<tac_slot>();
+        const vector<ASTNode*> no_units;
+        const vector<ASTNode*>& units = ast_root ? ast_root->get_units() : no_units;
+        vector<tac_program> parts(units.size());
+        vector<tac_opt_stats> part_stats(units.size());
+        vector<size_t> todo;
+        for (size_t i = 0; i < units.size(); i++) {
+            const string& key = cache_key(units[i]);
+            if (key.empty() || !cache->load(key, parts[i], part_stats[i])) todo.push_back(i);
+        }
+        work_stealing_pool(jobs).run(todo.size(), [&](size_t k) {
+            generate_unit(units[todo[k]], parts[todo[k]], part_stats[todo[k]]);
+        });
+        for (size_t i : todo) {
+            const string& key = cache_key(units[i]);
+            if (!key.empty()) cache->store(key, parts[i], part_stats[i]);
+        }
 
-        outcode << "// This code was generated by a two-pass compiler" << endl;
-        outcode << "// Format: " << endl;
-        outcode << "// - t0, t1, etc. are temporary variables" << endl;
-        outcode << "// - L0, L1, etc. are labels for jumps" << endl;
-        outcode << "// - Operations follow the three-address code format" << endl;
+        size_t total = 0;
+        for (const tac_program& part : parts) total += part.quads.size();
+        code.quads.reserve(total);
+        for (size_t i = 0; i < parts.size(); i++) append_unit(parts[i], part_stats[i]);
+        build_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        built = true;
+    }
 
-        outcode << ""<< endl;
+public:
+    ThreeAddrCodeGenerator(ProgramNode* root, ofstream& out, int opt_level = 0, int jobs = 1)
+        : ast_root(root), outcode(out), opt_level(opt_level), jobs(jobs), built(false) {}
 
-        outcode << "//Three Address Code" << endl << endl;
+    // Streaming: rather than building the program from the AST at the end, every unit is
+    // generated, optimized and written to code.txt by stream_unit() as soon as it is parsed,
+    // so the parser can free it. Quads are only kept when keep is set, for outputs that need
+    // the whole program; the function table is always kept, the stats refer to it.
+    void begin_stream(bool keep) {
+        streaming = true;
+        keep_code = keep;
+        if (outcode.is_open()) {
+            string out;
+            code.print_listing_start(out);
+            outcode.write(out.data(), out.size());
+        }
+    }
 
-        // 2. Call the generate_code method of the AST root
-        if (ast_root) {
-            ast_root->generate_code(outcode, symbol_to_temp, temp_count, label_count);
+    // globals are those declared so far, the only ones unit can refer to
+    void stream_unit(const ASTNode* unit, const vector<tac_slot>& globals) {
+        auto start = chrono::steady_clock::now();
+        if (globals.size() != code.globals.size()) code.globals = globals;
+        tac_program part;
+        tac_opt_stats part_stats;
+        const string& key = cache_key(unit);
+        if (key.empty() || !cache->load(key, part, part_stats)) {
+            generate_unit(unit, part, part_stats);
+            if (!key.empty()) cache->store(key, part, part_stats);
+        }
+        size_t first = code.quads.size();
+        append_unit(part, part_stats);
+        if (outcode.is_open()) {
+            string out;
+            code.print(out, first);
+            outcode.write(out.data(), out.size());
+        }
+        if (!keep_code) {
+            code.quads.clear();
+            code.floats.clear();
         }
+        build_ms += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+
+    // After the last unit; the program is then built as far as the other outputs are concerned
+    void end_stream(const vector<tac_slot>& globals) {
+        code.globals = globals;
+        if (outcode.is_open()) {
+            string out;
+            code.print_listing_end(out);
+            outcode.write(out.data(), out.size());
+        }
+        built = true;
+    }
+
+    bool is_streaming() const { return streaming; }
+
+    // Takes unchanged functions from cache instead of generating them; call before any output
+    void use_cache(tac_cache* c) { cache = c; }
 
-        outcode << ""<< endl;
+    // Builds the quads and writes them to code.txt as text, in one write
+    void generate() {
+        if (streaming) return; // written unit by unit
+        build();
+        string out;
+        code.print_listing(out);
+        outcode.write(out.data(), out.size());
+    }
+
+    // Builds the quads and writes the binary form (see tac_binary.h) to outbin
+    void generate_binary(ofstream& outbin) {
+        build();
+        string out;
+        write_tac_binary(code, out);
+        outbin.write(out.data(), out.size());
+    }
+
+    // Builds the quads and writes them as x86-64 assembly (see tac_x86.h) to outasm
+    bool generate_asm(ofstream& outasm, string& error) {
+        build();
+        x86_backend backend(code);
+        string out;
+        if (!backend.generate(out, error)) return false;
+        asm_stats = backend.stats;
+        outasm.write(out.data(), out.size());
+        return true;
+    }
 
-        // 3. Write a footer to the output file
-        outcode << "//========== END OF CODE ==========" << endl;
+    // Builds the quads and writes them as a C translation unit (see tac_c.h) to outc
+    bool generate_c(ofstream& outc, string& error) {
+        build();
+        c_backend backend(code);
+        string out;
+        if (!backend.generate(out, error)) return false;
+        outc.write(out.data(), out.size());
+        return true;
     }
 
-    // You may add helper methods here
+    const tac_program& get_program() const { return code; }
+    const tac_opt_stats& get_stats() const { return stats; }
+    const x86_stats& get_asm_stats() const { return asm_stats; }
+    double get_build_ms() const { return build_ms; }
+    int get_jobs() const { return jobs; }
 };
 
 #endif // THREE_ADDR_CODE_H
\ No newline at end of file
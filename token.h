@@ -0,0 +1,22 @@
+#ifndef TOKEN_H
+#define TOKEN_H
+
+#include "tac.h"
+
+// Semantic value of a token. It is plain data held by value in the parser's %union, so the
+// scanner allocates nothing per token: an identifier carries its interned name, a constant the
+// value the scanner parsed once, and an operator the opcode it computes.
+struct token_value
+{
+    int kind; //token number, as returned by yylex
+    int line;
+    union
+    {
+        int name; //ID: interned spelling
+        tac_opcode op; //ADDOP, MULOP, RELOP, LOGICOP
+        int int_value; //CONST_INT
+        double float_value; //CONST_FLOAT
+    };
+};
+
+#endif // TOKEN_H
@@ -0,0 +1,66 @@
+// Converts a binary TAC file (code.tac) back to the code.txt text format.
+// Build from the repository root:
+//   g++ -O2 -I. tools/tac2text.cpp -o tac2text
+// Usage: ./tac2text code.tac [out.txt]   (writes to stdout without an output file)
+
+#include "tac_binary.h"
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+thread_local string_interner names;
+
+int main(int argc, char *argv[])
+{
+    if(argc < 2 || argc > 3)
+    {
+        fprintf(stderr, "usage: %s code.tac [out.txt]\n", argv[0]);
+        return 2;
+    }
+
+    int fd = open(argv[1], O_RDONLY);
+    if(fd < 0)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        fprintf(stderr, "%s: empty or unreadable file\n", argv[1]);
+        close(fd);
+        return 1;
+    }
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED)
+    {
+        perror("mmap");
+        return 1;
+    }
+
+    tac_image image;
+    tac_program code;
+    if(!image.open(data, st.st_size) || !image.load(code))
+    {
+        fprintf(stderr, "%s: not a version %d TAC file\n", argv[1], tac_file_version);
+        munmap(data, st.st_size);
+        return 1;
+    }
+    munmap(data, st.st_size);
+
+    string out;
+    code.print_listing(out);
+
+    FILE *f = argc == 3 ? fopen(argv[2], "w") : stdout;
+    if(f == NULL)
+    {
+        perror(argv[2]);
+        return 1;
+    }
+    fwrite(out.data(), 1, out.size(), f);
+    if(f != stdout) fclose(f);
+    return 0;
+}
@@ -0,0 +1,37 @@
+#ifndef TYPES_H
+#define TYPES_H
+
+// Compact tags shared by the symbol table, the grammar actions and the AST.
+// They replace the "int"/"float"/"var"/"array" strings that used to be compared everywhere.
+
+enum data_type : unsigned char
+{
+    TYPE_NONE,
+    TYPE_INT,
+    TYPE_FLOAT,
+    TYPE_VOID,
+    TYPE_ERROR
+};
+
+enum id_kind : unsigned char
+{
+    ID_NONE,
+    ID_VAR,
+    ID_ARRAY,
+    ID_FUNC_DEC,
+    ID_FUNC_DEF
+};
+
+inline const char* type_name(data_type type)
+{
+    switch(type)
+    {
+        case TYPE_INT: return "int";
+        case TYPE_FLOAT: return "float";
+        case TYPE_VOID: return "void";
+        case TYPE_ERROR: return "error";
+        default: return "";
+    }
+}
+
+#endif // TYPES_H
@@ -0,0 +1,75 @@
+#ifndef WORK_POOL_H
+#define WORK_POOL_H
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Runs a batch of independent tasks on a fixed number of threads, the caller's included.
+// Tasks are dealt to the threads in contiguous runs; each thread takes its own tasks from the
+// front and, once it has none left, steals from the back of another thread's run, so one slow
+// task only holds up the thread that runs it.
+class work_stealing_pool {
+    private:
+        struct worker_queue {
+            mutex lock;
+            deque<size_t> tasks;
+        };
+
+        int threads;
+
+        static bool take(worker_queue& q, bool front, size_t& task) {
+            lock_guard<mutex> guard(q.lock);
+            if (q.tasks.empty()) return false;
+            if (front) {
+                task = q.tasks.front();
+                q.tasks.pop_front();
+            } else {
+                task = q.tasks.back();
+                q.tasks.pop_back();
+            }
+            return true;
+        }
+
+    public:
+        explicit work_stealing_pool(int threads) : threads(max(1, threads)) {}
+
+        // Calls task(i) once for every i in [0, n) and returns when all calls have returned
+        template <typename F>
+        void run(size_t n, F task) {
+            int used = (int)min<size_t>(threads, n);
+            if (used <= 1) {
+                for (size_t i = 0; i < n; i++) task(i);
+                return;
+            }
+            vector<unique_ptr<worker_queue>> queues;
+            for (int w = 0; w < used; w++) {
+                queues.push_back(make_unique<worker_queue>());
+                for (size_t i = n * w / used; i < n * (w + 1) / used; i++) queues[w]->tasks.push_back(i);
+            }
+            auto work = [&](int self) {
+                size_t i;
+                while (true) {
+                    if (take(*queues[self], true, i)) {
+                        task(i);
+                        continue;
+                    }
+                    bool stole = false;
+                    for (int k = 1; k < used && !stole; k++) stole = take(*queues[(self + k) % used], false, i);
+                    if (!stole) return; // every queue is empty and no task adds more
+                    task(i);
+                }
+            };
+            vector<thread> pool;
+            for (int w = 1; w < used; w++) pool.emplace_back(work, w);
+            work(0);
+            for (thread& t : pool) t.join();
+        }
+};
+
+#endif // WORK_POOL_H